@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <config.h>
+#include <defs.hpp>
+#include <parser.hpp>
+#include <report_gen.hpp>
+#include <utils.hpp>
+
+#include "synth.hpp"
+
+
+struct BenchOptions {
+    std::vector<size_t> sizes = {64 << 10, 1 << 20, 4 << 20};
+    SynthSpec spec;
+    size_t iterations = 3;
+    std::string output;
+    std::string emit_dir;
+    bool emit_only = false;
+};
+
+
+void usage(int ret) {
+    std::cout << "Usage: bench [options]" << std::endl;
+    std::cout << "Generates synthetic ELF files and prints one JSON object per measurement." << std::endl;
+    std::cout << std::endl;
+    std::cout << "  --sizes A,B,..     input sizes in bytes, K/M/G suffixes allowed (default 64K,1M,4M)" << std::endl;
+    std::cout << "  --sections N       payload sections per file (default 16)" << std::endl;
+    std::cout << "  --symbols N        symbols in .symtab (default 256)" << std::endl;
+    std::cout << "  --class 32|64      ELF class (default 64)" << std::endl;
+    std::cout << "  --endian le|be     data encoding (default le)" << std::endl;
+    std::cout << "  --iterations N     repetitions per measurement, best is reported (default 3)" << std::endl;
+    std::cout << "  --out FILE         append results to FILE instead of stdout" << std::endl;
+    std::cout << "  --emit DIR         also write the generated corpus to DIR" << std::endl;
+    std::cout << "  --emit-only        only write the corpus, without measuring anything" << std::endl;
+    std::exit(ret);
+}
+
+size_t parse_size(const std::string& text) {
+    auto value = parse_byte_size(text);
+    if (!value) {
+        usage(1);
+    }
+    return *value;
+}
+
+BenchOptions parse_arguments(int argc, char** argv) {
+    BenchOptions options;
+
+    auto next = [&](int& i) {
+        if (i + 1 >= argc) {
+            usage(1);
+        }
+        return std::string(argv[++i]);
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        auto argument = std::string(argv[i]);
+
+        if (argument == "-h" || argument == "--help") {
+            usage(0);
+        } else if (argument == "--sizes") {
+            options.sizes.clear();
+            std::stringstream list(next(i));
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                options.sizes.push_back(parse_size(item));
+            }
+        } else if (argument == "--sections") {
+            options.spec.sections = parse_size(next(i));
+        } else if (argument == "--symbols") {
+            options.spec.symbols = parse_size(next(i));
+        } else if (argument == "--class") {
+            auto class_ = next(i);
+            if (class_ != "32" && class_ != "64") {
+                usage(1);
+            }
+            options.spec.class_ = class_ == "32" ? ELF_CLASS32 : ELF_CLASS64;
+        } else if (argument == "--endian") {
+            auto endian = next(i);
+            if (endian != "le" && endian != "be") {
+                usage(1);
+            }
+            options.spec.endianness = endian == "be" ? ELF_DATA2MSB : ELF_DATA2LSB;
+        } else if (argument == "--iterations") {
+            options.iterations = parse_size(next(i));
+        } else if (argument == "--out") {
+            options.output = next(i);
+        } else if (argument == "--emit") {
+            options.emit_dir = next(i);
+        } else if (argument == "--emit-only") {
+            options.emit_only = true;
+        } else {
+            usage(1);
+        }
+    }
+
+    if (options.emit_only && options.emit_dir.empty()) {
+        usage(1);
+    }
+
+    if (options.iterations == 0) {
+        options.iterations = 1;
+    }
+
+    return options;
+}
+
+// returns the best wall time over all iterations, in nanoseconds
+template<class function>
+uint64_t measure(size_t iterations, const function& f) {
+    uint64_t best = UINT64_MAX;
+
+    for (size_t i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        best = std::min(best, ns);
+    }
+
+    return best;
+}
+
+// same for passes over a parsed file: each iteration gets a fresh ParsedElf, so the
+// tables it builds on first use (ranges, string tables, notes) are paid for every
+// time instead of only by the first iteration. parsing itself isn't timed
+template<class function>
+uint64_t measure_parsed(size_t iterations, const std::string& name, const std::vector<uint8_t>& contents, const function& f) {
+    uint64_t best = UINT64_MAX;
+
+    for (size_t i = 0; i < iterations; ++i) {
+        auto elf = ParsedElf::from_bytes(name, contents);
+        auto start = std::chrono::steady_clock::now();
+        f(elf);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        best = std::min(best, ns);
+    }
+
+    return best;
+}
+
+void report(std::ostream& os, const char* name, const SynthSpec& spec, size_t actual_size, size_t iterations, uint64_t ns) {
+    double seconds = static_cast<double>(ns) / 1e9;
+    double mib_per_s = seconds > 0 ? static_cast<double>(actual_size) / (1 << 20) / seconds : 0;
+
+    os << "{\"bench\": \"" << name << "\""
+        << ", \"version\": \"" << ELFCAT_VERSION_MAJOR << "." << ELFCAT_VERSION_MINOR << "\""
+        << ", \"class\": " << (spec.class_ == ELF_CLASS32 ? 32 : 64)
+        << ", \"endian\": \"" << (spec.endianness == ELF_DATA2MSB ? "be" : "le") << "\""
+        << ", \"size\": " << actual_size
+        << ", \"sections\": " << spec.sections
+        << ", \"symbols\": " << spec.symbols
+        << ", \"iterations\": " << iterations
+        << ", \"best_ns\": " << ns
+        << ", \"mib_per_s\": " << mib_per_s << "}" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    auto options = parse_arguments(argc, argv);
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output, std::ios::app);
+    }
+    std::ostream& os = options.output.empty() ? std::cout : file;
+
+    for (auto size : options.sizes) {
+        auto spec = options.spec;
+        spec.size = size;
+
+        auto contents = synthesize_elf(spec);
+        auto name = spec.describe();
+
+        if (!options.emit_dir.empty()) {
+            std::ofstream corpus(options.emit_dir + "/" + name + ".elf", std::ios::binary);
+            corpus.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+        }
+
+        if (options.emit_only) {
+            continue;
+        }
+
+        auto parse_ns = measure(options.iterations, [&] {
+            ParsedElf::from_bytes(name, contents);
+        });
+        report(os, "from_bytes", spec, contents.size(), options.iterations, parse_ns);
+
+        auto ranges_ns = measure_parsed(options.iterations, name, contents, [](const ParsedElf& elf) {
+            elf.ranges();
+        });
+        report(os, "ranges", spec, contents.size(), options.iterations, ranges_ns);
+
+        auto strtab_ns = measure_parsed(options.iterations, name, contents, [](const ParsedElf& elf) {
+            elf.strtab();
+        });
+        report(os, "strtab", spec, contents.size(), options.iterations, strtab_ns);
+
+        auto notes_ns = measure_parsed(options.iterations, name, contents, [](const ParsedElf& elf) {
+            elf.notes();
+        });
+        report(os, "notes", spec, contents.size(), options.iterations, notes_ns);
+
+        auto dump_ns = measure_parsed(options.iterations, name, contents, [](const ParsedElf& elf) {
+            generate_file_dump(elf);
+        });
+        report(os, "generate_file_dump", spec, contents.size(), options.iterations, dump_ns);
+
+        auto report_ns = measure_parsed(options.iterations, name, contents, [](const ParsedElf& elf) {
+            generate_report(elf);
+        });
+        report(os, "generate_report", spec, contents.size(), options.iterations, report_ns);
+    }
+}
@@ -0,0 +1,51 @@
+# Emits one synthetic file with SECTIONS payload sections, then checks that
+# elfcat --check finds nothing wrong with it and that the --summary report counts
+# every section header: the payloads plus the null section, the build-id note,
+# .symtab, .strtab, .symtab_shndx and .shstrtab.
+
+file(REMOVE_RECURSE ${DIR})
+file(MAKE_DIRECTORY ${DIR})
+# the report pulls its stylesheets and scripts from data/ under the working directory
+file(COPY ${DATA} DESTINATION ${DIR})
+
+execute_process(
+    COMMAND ${BENCH} --emit ${DIR} --emit-only --sizes 1 --symbols 0 --sections ${SECTIONS}
+    RESULT_VARIABLE result
+)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "bench failed: ${result}")
+endif()
+
+file(GLOB files ${DIR}/*.elf)
+list(LENGTH files count)
+if (NOT count EQUAL 1)
+    message(FATAL_ERROR "expected one emitted file, found ${count}")
+endif()
+
+execute_process(
+    COMMAND ${ELFCAT} --check ${files}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+)
+if (NOT result EQUAL 0 OR NOT output STREQUAL "")
+    message(FATAL_ERROR "elfcat --check failed (${result}):\n${output}")
+endif()
+
+execute_process(
+    COMMAND ${ELFCAT} --summary ${files}
+    WORKING_DIRECTORY ${DIR}
+    RESULT_VARIABLE result
+)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "elfcat --summary failed: ${result}")
+endif()
+
+math(EXPR expected "${SECTIONS} + 6")
+file(GLOB reports ${DIR}/*.html)
+file(READ ${reports} report)
+if (NOT report MATCHES "<span id='info_e_shnum'>([0-9]+)</span>")
+    message(FATAL_ERROR "no section header count in ${reports}")
+endif()
+if (NOT CMAKE_MATCH_1 EQUAL expected)
+    message(FATAL_ERROR "report counts ${CMAKE_MATCH_1} section headers, expected ${expected}")
+endif()
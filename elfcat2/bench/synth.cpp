@@ -0,0 +1,292 @@
+#include <random>
+#include <sstream>
+
+#include <defs.hpp>
+
+#include "synth.hpp"
+
+
+namespace {
+
+constexpr uint64_t BASE_VADDR = 0x400000;
+
+struct Writer {
+    void put(size_t offset, uint64_t value, size_t width) {
+        for (size_t i = 0; i < width; ++i) {
+            size_t shift = 8 * (big_endian ? (width - 1 - i) : i);
+            buf[offset + i] = static_cast<uint8_t>(value >> shift);
+        }
+    }
+
+    // 32-bit files use 4-byte words where 64-bit files use 8-byte xwords/addrs/offs.
+    void put_addr(size_t offset, uint64_t value) {
+        put(offset, value, is64 ? 8 : 4);
+    }
+
+    std::vector<uint8_t>& buf;
+    bool big_endian;
+    bool is64;
+};
+
+struct PendingSection {
+    std::string name;
+    uint32_t type;
+    uint64_t flags;
+    size_t offset;
+    size_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t align;
+    uint64_t entsize;
+};
+
+size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+
+std::string SynthSpec::describe() const {
+    std::stringstream s;
+    s << (class_ == ELF_CLASS32 ? "elf32" : "elf64") << (endianness == ELF_DATA2MSB ? "be" : "le")
+        << "-" << size << "b-" << sections << "s-" << symbols << "y";
+    return s.str();
+}
+
+std::vector<uint8_t> synthesize_elf(const SynthSpec& spec) {
+    bool is64 = spec.class_ != ELF_CLASS32;
+    size_t ehsize = is64 ? 64 : 52;
+    size_t phentsize = is64 ? 56 : 32;
+    size_t shentsize = is64 ? 64 : 40;
+    size_t symentsize = is64 ? 24 : 16;
+    size_t phnum = 2;
+
+    std::vector<PendingSection> sections;
+    std::string shstrtab(1, '\0');
+    std::string strtab(1, '\0');
+
+    auto add_name = [](std::string& table, const std::string& name) {
+        auto idx = table.size();
+        table += name;
+        table += '\0';
+        return static_cast<uint32_t>(idx);
+    };
+
+    std::vector<uint32_t> shnames;
+
+    sections.push_back({"", SHT_NULL, 0, 0, 0, 0, 0, 0, 0});
+
+    size_t offset = ehsize + phnum * phentsize;
+
+    size_t note_offset = offset;
+    size_t note_size = 12 + 4 + 20;
+    sections.push_back({".note.gnu.build-id", SHT_NOTE, SHF_ALLOC, note_offset, note_size, 0, 0, 4, 0});
+    offset += note_size;
+
+    size_t payload_count = spec.sections == 0 ? 1 : spec.sections;
+    size_t fixed = offset + spec.symbols * symentsize + (payload_count + 6) * shentsize;
+    size_t payload_total = spec.size > fixed ? spec.size - fixed : payload_count;
+    size_t payload_each = payload_total / payload_count;
+    if (payload_each == 0) {
+        payload_each = 1;
+    }
+
+    size_t first_payload = sections.size();
+    for (size_t i = 0; i < payload_count; ++i) {
+        offset = align_up(offset, 16);
+        sections.push_back({".text." + std::to_string(i), SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, offset, payload_each, 0, 0, 16, 0});
+        offset += payload_each;
+    }
+
+    for (size_t i = 0; i < spec.symbols; ++i) {
+        add_name(strtab, "sym_" + std::to_string(i));
+    }
+
+    offset = align_up(offset, 8);
+    size_t symtab_idx = sections.size();
+    size_t symtab_offset = offset;
+    size_t symtab_size = (spec.symbols + 1) * symentsize;
+    sections.push_back({".symtab", SHT_SYMTAB, 0, offset, symtab_size, 0, 1, 8, symentsize});
+    offset += symtab_size;
+
+    size_t strtab_idx = sections.size();
+    size_t strtab_offset = offset;
+    sections.push_back({".strtab", SHT_STRTAB, 0, offset, strtab.size(), 0, 0, 1, 0});
+    offset += strtab.size();
+    sections[symtab_idx].link = static_cast<uint32_t>(strtab_idx);
+
+    // st_shndx is 16 bits: past SHN_LORESERVE symbols say SHN_XINDEX and the real
+    // index goes into a parallel SHT_SYMTAB_SHNDX table
+    bool xindex = first_payload + payload_count >= SHN_LORESERVE;
+    size_t shndx_offset = 0;
+    if (xindex) {
+        offset = align_up(offset, 4);
+        shndx_offset = offset;
+        size_t shndx_size = (spec.symbols + 1) * 4;
+        sections.push_back({".symtab_shndx", SHT_SYMTAB_SHNDX, 0, offset, shndx_size, static_cast<uint32_t>(symtab_idx), 0, 4, 4});
+        offset += shndx_size;
+    }
+
+    size_t shstrtab_idx = sections.size();
+    sections.push_back({".shstrtab", SHT_STRTAB, 0, 0, 0, 0, 0, 1, 0});
+
+    for (const auto& section : sections) {
+        shnames.push_back(add_name(shstrtab, section.name));
+    }
+
+    size_t shstrtab_offset = offset;
+    sections[shstrtab_idx].offset = shstrtab_offset;
+    sections[shstrtab_idx].size = shstrtab.size();
+    offset += shstrtab.size();
+
+    size_t shoff = align_up(offset, 8);
+    size_t shnum = sections.size();
+    size_t total = shoff + shnum * shentsize;
+
+    // extended numbering: the real counts go into section 0
+    bool extended_shnum = shnum >= SHN_LORESERVE;
+    bool extended_shstrndx = shstrtab_idx >= SHN_LORESERVE;
+    if (extended_shnum) {
+        sections[0].size = shnum;
+    }
+    if (extended_shstrndx) {
+        sections[0].link = static_cast<uint32_t>(shstrtab_idx);
+    }
+
+    std::vector<uint8_t> buf(total, 0);
+    Writer wr{buf, spec.endianness == ELF_DATA2MSB, is64};
+
+    // file header
+    buf[0] = 0x7f;
+    buf[1] = 'E';
+    buf[2] = 'L';
+    buf[3] = 'F';
+    buf[ELF_EI_CLASS] = is64 ? ELF_CLASS64 : ELF_CLASS32;
+    buf[ELF_EI_DATA] = spec.endianness;
+    buf[ELF_EI_VERSION] = ELF_EV_CURRENT;
+
+    size_t p = 16;
+    wr.put(p, ELF_ET_EXEC, 2); p += 2;
+    wr.put(p, is64 ? 62 : 3, 2); p += 2;
+    wr.put(p, ELF_EV_CURRENT, 4); p += 4;
+    wr.put_addr(p, BASE_VADDR + sections[first_payload].offset); p += is64 ? 8 : 4;
+    wr.put_addr(p, ehsize); p += is64 ? 8 : 4;
+    wr.put_addr(p, shoff); p += is64 ? 8 : 4;
+    wr.put(p, 0, 4); p += 4;
+    wr.put(p, ehsize, 2); p += 2;
+    wr.put(p, phentsize, 2); p += 2;
+    wr.put(p, phnum, 2); p += 2;
+    wr.put(p, shentsize, 2); p += 2;
+    wr.put(p, extended_shnum ? 0 : shnum, 2); p += 2;
+    wr.put(p, extended_shstrndx ? SHN_XINDEX : shstrtab_idx, 2);
+
+    // program headers: one PT_LOAD over the whole file and a PT_NOTE over the build-id
+    auto put_phdr = [&](size_t at, uint32_t type, uint32_t flags, uint64_t off, uint64_t size, uint64_t align) {
+        if (is64) {
+            wr.put(at + 0, type, 4);
+            wr.put(at + 4, flags, 4);
+            wr.put(at + 8, off, 8);
+            wr.put(at + 16, BASE_VADDR + off, 8);
+            wr.put(at + 24, BASE_VADDR + off, 8);
+            wr.put(at + 32, size, 8);
+            wr.put(at + 40, size, 8);
+            wr.put(at + 48, align, 8);
+        } else {
+            wr.put(at + 0, type, 4);
+            wr.put(at + 4, off, 4);
+            wr.put(at + 8, BASE_VADDR + off, 4);
+            wr.put(at + 12, BASE_VADDR + off, 4);
+            wr.put(at + 16, size, 4);
+            wr.put(at + 20, size, 4);
+            wr.put(at + 24, flags, 4);
+            wr.put(at + 28, align, 4);
+        }
+    };
+
+    put_phdr(ehsize, PT_LOAD, PF_R | PF_X, 0, shoff, 0x1000);
+    put_phdr(ehsize + phentsize, PT_NOTE, PF_R, note_offset, note_size, 4);
+
+    std::mt19937 rng(spec.seed);
+
+    // build-id note
+    wr.put(note_offset + 0, 4, 4);
+    wr.put(note_offset + 4, 20, 4);
+    wr.put(note_offset + 8, NT_GNU_BUILD_ID, 4);
+    buf[note_offset + 12] = 'G';
+    buf[note_offset + 13] = 'N';
+    buf[note_offset + 14] = 'U';
+    for (size_t i = 0; i < 20; ++i) {
+        buf[note_offset + 16 + i] = static_cast<uint8_t>(rng());
+    }
+
+    for (size_t i = first_payload; i < first_payload + payload_count; ++i) {
+        const auto& section = sections[i];
+        for (size_t j = 0; j < section.size; ++j) {
+            buf[section.offset + j] = static_cast<uint8_t>(rng());
+        }
+    }
+
+    // symbols are spread round-robin over the payload sections
+    uint32_t sym_name = 1;
+    for (size_t i = 0; i < spec.symbols; ++i) {
+        size_t at = symtab_offset + (i + 1) * symentsize;
+        size_t shndx = first_payload + i % payload_count;
+        uint64_t value = BASE_VADDR + sections[shndx].offset;
+        uint8_t info = 0x12;
+
+        if (xindex) {
+            wr.put(shndx_offset + (i + 1) * 4, shndx, 4);
+        }
+        size_t st_shndx = shndx >= SHN_LORESERVE ? SHN_XINDEX : shndx;
+
+        if (is64) {
+            wr.put(at + 0, sym_name, 4);
+            buf[at + 4] = info;
+            wr.put(at + 6, st_shndx, 2);
+            wr.put(at + 8, value, 8);
+            wr.put(at + 16, 1, 8);
+        } else {
+            wr.put(at + 0, sym_name, 4);
+            wr.put(at + 4, value, 4);
+            wr.put(at + 8, 1, 4);
+            buf[at + 12] = info;
+            wr.put(at + 14, st_shndx, 2);
+        }
+
+        sym_name += static_cast<uint32_t>(std::to_string(i).size() + 5);
+    }
+
+    std::copy(strtab.begin(), strtab.end(), buf.begin() + strtab_offset);
+    std::copy(shstrtab.begin(), shstrtab.end(), buf.begin() + shstrtab_offset);
+
+    for (size_t i = 0; i < shnum; ++i) {
+        const auto& section = sections[i];
+        size_t at = shoff + i * shentsize;
+        uint64_t addr = (section.flags & SHF_ALLOC) ? BASE_VADDR + section.offset : 0;
+
+        wr.put(at + 0, shnames[i], 4);
+        wr.put(at + 4, section.type, 4);
+        if (is64) {
+            wr.put(at + 8, section.flags, 8);
+            wr.put(at + 16, addr, 8);
+            wr.put(at + 24, section.offset, 8);
+            wr.put(at + 32, section.size, 8);
+            wr.put(at + 40, section.link, 4);
+            wr.put(at + 44, section.info, 4);
+            wr.put(at + 48, section.align, 8);
+            wr.put(at + 56, section.entsize, 8);
+        } else {
+            wr.put(at + 8, section.flags, 4);
+            wr.put(at + 12, addr, 4);
+            wr.put(at + 16, section.offset, 4);
+            wr.put(at + 20, section.size, 4);
+            wr.put(at + 24, section.link, 4);
+            wr.put(at + 28, section.info, 4);
+            wr.put(at + 32, section.align, 4);
+            wr.put(at + 36, section.entsize, 4);
+        }
+    }
+
+    return buf;
+}
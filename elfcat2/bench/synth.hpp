@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Parameters of a synthetic ELF file. Payload sections are filled with
+// pseudo-random bytes so that the dump is not dominated by zero rows.
+struct SynthSpec {
+    size_t size = 1 << 20;
+    size_t sections = 16;
+    size_t symbols = 256;
+    uint8_t class_ = 2;
+    uint8_t endianness = 1;
+    uint32_t seed = 1;
+
+    std::string describe() const;
+};
+
+
+std::vector<uint8_t> synthesize_elf(const SynthSpec& spec);
@@ -0,0 +1,65 @@
+// repeatedRows holds (first row, length) pairs of the runs the dump collapses into one
+// marker row each; hiddenBefore[k] is how many rows the runs before the k-th hide
+let hiddenBefore = [0];
+for (var k = 0; k < repeatedRows.length; k += 2) {
+    hiddenBefore.push(hiddenBefore[hiddenBefore.length - 1] + repeatedRows[k + 1] - 1);
+}
+
+// the row of the dump showing file row `row`: the marker for a collapsed one
+function displayedRow(row) {
+    // last run starting at or before row
+    var low = 0;
+    var high = repeatedRows.length / 2;
+    while (low < high) {
+        let middle = (low + high) >> 1;
+        if (repeatedRows[middle * 2] <= row) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if (low == 0) {
+        return row;
+    }
+
+    let first = repeatedRows[(low - 1) * 2];
+    let length = repeatedRows[(low - 1) * 2 + 1];
+    if (row < first + length) {
+        return first - hiddenBefore[low - 1];
+    }
+    return row - hiddenBefore[low];
+}
+
+function populateOffsets(columns) {
+    let rows = Math.ceil(fileLen / columns);
+    let elements = "";
+    var run = 0;
+
+    for (var i = 0; i < rows; ++i) {
+        if (run < repeatedRows.length && repeatedRows[run] == i) {
+            elements += "*</br>\n";
+            i += repeatedRows[run + 1] - 1;
+            run += 2;
+            continue;
+        }
+        elements += (i * columns).toString(16) + "</br>\n";
+    }
+
+    document.getElementById('offsets').innerHTML = elements;
+}
+
+// report.html#0x1f40 scrolls the dump to the row holding that offset
+function scrollToOffset(columns) {
+    let match = /^#0x([0-9a-fA-F]+)$/.exec(window.location.hash);
+    if (!match) {
+        return;
+    }
+
+    let offset = parseInt(match[1], 16);
+    let bytes = document.getElementById('bytes');
+    let rows = displayedRow(Math.ceil(fileLen / columns));
+    let rowHeight = bytes.clientHeight / rows;
+
+    window.scrollTo(0, bytes.offsetTop + displayedRow(Math.floor(offset / columns)) * rowHeight - window.innerHeight / 3);
+}
@@ -0,0 +1,149 @@
+// --serve: the dump arrives windowRows rows at a time. Windows are added as the page
+// scrolls near either end of what is loaded and dropped again once far away, so the
+// page stays small however large the file is.
+let columns = ['offsets', 'bytes', 'ascii'];
+let totalRows = Math.ceil(fileLen / 16);
+let windowCount = Math.max(1, Math.ceil(totalRows / windowRows));
+let maxWindows = 5;
+var firstWindow = 0;
+var lastWindow = 0;
+var loading = false;
+
+function windowRowCount(index) {
+    return Math.min(totalRows, (index + 1) * windowRows) - index * windowRows;
+}
+
+// resolves to the offsets, bytes and ascii divs of a window
+function fetchWindow(index) {
+    let from = index * windowRows;
+    let to = from + windowRowCount(index);
+
+    return fetch(rowsUrl + '?from=' + from + '&to=' + to)
+        .then(response => response.text())
+        .then(text => {
+            let template = document.createElement('template');
+            template.innerHTML = text;
+            return Array.from(template.content.children);
+        });
+}
+
+function dumpHeight() {
+    return document.getElementById('bytes').offsetHeight;
+}
+
+// content added or removed above the viewport would move it, scroll by as much
+function keepingPosition(atEnd, change) {
+    let before = dumpHeight();
+    change();
+    if (!atEnd) {
+        window.scrollBy(0, dumpHeight() - before);
+    }
+}
+
+function addWindow(parts, atEnd) {
+    keepingPosition(atEnd, () => {
+        columns.forEach((column, i) => {
+            let container = document.getElementById(column);
+            if (atEnd) {
+                container.appendChild(parts[i]);
+            } else {
+                container.insertBefore(parts[i], container.firstElementChild);
+            }
+        });
+    });
+}
+
+function dropWindow(atEnd) {
+    keepingPosition(atEnd, () => {
+        columns.forEach(column => {
+            let container = document.getElementById(column);
+            container.removeChild(atEnd ? container.lastElementChild : container.firstElementChild);
+        });
+    });
+}
+
+function loadMore() {
+    if (loading) {
+        return;
+    }
+
+    let rect = document.getElementById('bytes').getBoundingClientRect();
+    var atEnd;
+    if (rect.bottom < 2 * window.innerHeight && lastWindow + 1 < windowCount) {
+        atEnd = true;
+    } else if (rect.top > -window.innerHeight && firstWindow > 0) {
+        atEnd = false;
+    } else {
+        return;
+    }
+
+    loading = true;
+    fetchWindow(atEnd ? lastWindow + 1 : firstWindow - 1).then(parts => {
+        addWindow(parts, atEnd);
+        if (atEnd) {
+            ++lastWindow;
+        } else {
+            --firstWindow;
+        }
+
+        if (lastWindow - firstWindow + 1 > maxWindows) {
+            dropWindow(!atEnd);
+            if (atEnd) {
+                ++firstWindow;
+            } else {
+                --lastWindow;
+            }
+        }
+
+        loading = false;
+        loadMore();
+    }, () => {
+        loading = false;
+    });
+}
+
+// report#0x1f40 shows the row holding that offset, loading its window in place of the
+// shown ones when it isn't among them
+function jumpToOffset() {
+    let match = /^#0x([0-9a-fA-F]+)$/.exec(window.location.hash);
+    if (!match || totalRows == 0) {
+        return;
+    }
+
+    let row = Math.min(Math.floor(parseInt(match[1], 16) / 16), totalRows - 1);
+    let index = Math.floor(row / windowRows);
+
+    let scroll = () => {
+        let part = document.getElementById('bytes').children[index - firstWindow];
+        let rowHeight = part.offsetHeight / windowRowCount(index);
+        let top = part.getBoundingClientRect().top + window.scrollY;
+        window.scrollTo(0, top + (row - index * windowRows) * rowHeight - window.innerHeight / 3);
+    };
+
+    if (index >= firstWindow && index <= lastWindow) {
+        scroll();
+        return;
+    }
+
+    loading = true;
+    fetchWindow(index).then(parts => {
+        columns.forEach(column => {
+            document.getElementById(column).innerHTML = '';
+        });
+        addWindow(parts, true);
+        firstWindow = index;
+        lastWindow = index;
+        loading = false;
+        scroll();
+        loadMore();
+    }, () => {
+        loading = false;
+    });
+}
+
+function setupWindows() {
+    window.addEventListener('scroll', loadMore);
+    window.addEventListener('hashchange', jumpToOffset);
+    jumpToOffset();
+    loadMore();
+}
@@ -0,0 +1,20 @@
+// one cell per entropy level digit, each as tall as the dump rows it covers;
+// runs of equal levels share a span. Collapsed rows count as the marker row
+// that replaces them (displayedRow in offsets.js)
+function populateHeatmap(rowsPerCell) {
+    let rows = Math.ceil(fileLen / 16);
+    let elements = "";
+    var i = 0;
+
+    while (i < entropyLevels.length) {
+        var j = i;
+        while (j < entropyLevels.length && entropyLevels[j] == entropyLevels[i]) {
+            ++j;
+        }
+        let cellRows = displayedRow(Math.min(rows, j * rowsPerCell)) - displayedRow(i * rowsPerCell);
+        elements += "<span class='heat" + entropyLevels[i] + "'>" + "&nbsp;</br>".repeat(cellRows) + "</span>";
+        i = j;
+    }
+
+    document.getElementById('heatmap').innerHTML = elements;
+}
@@ -0,0 +1,148 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <file_walk.hpp>
+#include <utils.hpp>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+
+// Stand-in for libFuzzer where the compiler has none: runs every file given
+// (directories recursively) through the target, then --mutate=N mutated copies of
+// each. Mutations are what breaks header parsers: header fields set to boundary
+// values, random bytes and truncation.
+struct DriverOptions {
+    std::vector<std::string> roots;
+    size_t mutations = 0;
+    uint64_t seed = 1;
+    // every input is written here before it runs, so a crashing one is left behind
+    std::string save;
+};
+
+
+void usage(int ret) {
+    std::cout << "Usage: fuzz_parse [--mutate=N] [--seed=S] [--save=FILE] <file or directory>..." << std::endl;
+    std::cout << "Runs the inputs through the parser and every pass over the contents; build with" << std::endl;
+    std::cout << "-fsanitize=address,undefined to catch what goes wrong." << std::endl;
+    std::cout << std::endl;
+    std::cout << "  --mutate=N         also run N mutated copies of every input" << std::endl;
+    std::cout << "  --seed=S           seed of the mutations (default 1)" << std::endl;
+    std::cout << "  --save=FILE        write every input to FILE before running it" << std::endl;
+    std::exit(ret);
+}
+
+DriverOptions parse_arguments(int argc, char** argv) {
+    DriverOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+
+        if (argument == "-h" || argument == "--help") {
+            usage(0);
+        } else if (argument.rfind("--mutate=", 0) == 0) {
+            options.mutations = std::strtoull(argument.c_str() + 9, nullptr, 10);
+        } else if (argument.rfind("--seed=", 0) == 0) {
+            options.seed = std::strtoull(argument.c_str() + 7, nullptr, 10);
+        } else if (argument.rfind("--save=", 0) == 0) {
+            options.save = argument.substr(7);
+        } else if (argument.rfind("-", 0) == 0) {
+            usage(1);
+        } else {
+            options.roots.push_back(argument);
+        }
+    }
+
+    if (options.roots.empty()) {
+        usage(1);
+    }
+
+    return options;
+}
+
+// values at which offset and size arithmetic overflows or runs off the end
+uint64_t boundary_value(std::mt19937_64& random, size_t size) {
+    const uint64_t values[] = {
+        0, 1, 2, 0x7f, 0x80, 0xff, 0xffff, 0x7fffffff, 0xffffffff,
+        0x7fffffffffffffff, 0xffffffffffffffff, size, size - 1, size + 1, size / 2,
+    };
+    return values[random() % std::size(values)];
+}
+
+void mutate(std::vector<uint8_t>& input, std::mt19937_64& random) {
+    size_t count = 1 + random() % 4;
+
+    for (size_t i = 0; i < count && !input.empty(); ++i) {
+        // most of what matters is in the headers, which are usually near the start or the end
+        size_t limit = (random() % 2 == 0) ? std::min<size_t>(input.size(), 256) : input.size();
+        size_t offset = random() % limit;
+
+        switch (random() % 4) {
+            case 0:
+            case 1: {
+                size_t width = size_t(1) << (random() % 4);
+                auto value = boundary_value(random, input.size());
+                for (size_t b = 0; b < width && offset + b < input.size(); ++b) {
+                    input[offset + b] = static_cast<uint8_t>(value >> (8 * b));
+                }
+                break;
+            }
+            case 2:
+                input[offset] = static_cast<uint8_t>(random());
+                break;
+            case 3:
+                input.resize(offset);
+                break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    auto options = parse_arguments(argc, argv);
+
+    std::vector<std::string> files;
+    try {
+        for (const auto& root : options.roots) {
+            auto found = list_regular_files(root);
+            files.insert(files.end(), found.cbegin(), found.cend());
+        }
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::mt19937_64 random(options.seed);
+    size_t runs = 0;
+
+    auto run = [&](const std::vector<uint8_t>& input) {
+        if (!options.save.empty()) {
+            std::ofstream(options.save, std::ios::binary).write(reinterpret_cast<const char*>(input.data()), input.size());
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        ++runs;
+    };
+
+    for (const auto& file : files) {
+        std::ifstream stream(file, std::ios::binary);
+        std::vector<uint8_t> original((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+        run(original);
+
+        for (size_t i = 0; i < options.mutations; ++i) {
+            auto input = original;
+            mutate(input, random);
+            run(input);
+        }
+    }
+
+    std::cout << runs << " runs over " << files.size() << " inputs" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+#include <address_index.hpp>
+#include <archive.hpp>
+#include <debug_link.hpp>
+#include <defs.hpp>
+#include <hash_manifest.hpp>
+#include <parser.hpp>
+#include <report_gen.hpp>
+#include <size_report.hpp>
+#include <string_scan.hpp>
+
+
+namespace {
+
+void run_passes(ParsedElf& elf) {
+    elf.jobs = 1;
+
+    for (const auto& shdr : elf.shdrs) {
+        elf.shnstrtab().get(shdr.name);
+        elf.strtab().get(shdr.name);
+    }
+
+    elf.notes();
+    elf.symbols();
+    elf.segment_mapping();
+    elf.repeated_rows();
+    elf.core();
+    find_debug_link(elf);
+
+    auto index = AddressIndex::build(elf);
+    for (const auto& phdr : elf.phdrs) {
+        index.from_vaddr(phdr.vaddr);
+        index.from_offset(phdr.file_offset);
+    }
+
+    for (auto level : {SizeLevel::segments, SizeLevel::sections, SizeLevel::symbols, SizeLevel::compile_units}) {
+        SizeReport::build(elf, level);
+    }
+
+    scan_strings(elf, 4, StringEncoding::ascii, 1);
+    scan_strings(elf, 4, StringEncoding::utf16le, 1);
+    HashManifest::build(elf, {}, 1);
+
+    std::ostringstream report;
+    write_report(report, elf);
+    generate_summary_report(elf);
+}
+
+}
+
+
+// libFuzzer entry point. The input is parsed without exceptions and every pass that
+// reads contents runs over it, so that the sanitizers catch any read the header
+// validation lets through. Archives are split into members first, each of which
+// gets the same passes.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    ByteView buf(data, size);
+
+    if (Archive::is_archive(buf)) {
+        try {
+            auto archive = ParsedArchive::from_bytes("fuzz_input", buf, 1);
+            for (auto& elf : archive.elves) {
+                if (elf) {
+                    run_passes(*elf);
+                }
+            }
+            generate_archive_report(archive);
+        } catch (const std::runtime_error&) {
+            // malformed member tables are rejected as a whole, which is the expected outcome
+        }
+        return 0;
+    }
+
+    auto elf = ParsedElf::parse("fuzz_input", buf);
+    if (elf.headers_parsed()) {
+        run_passes(elf);
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// searchNames holds section and symbol names sorted bytewise, one UTF-16 code unit per
+// byte (the report escapes the others as \xNN), so string comparison here is the order
+// they were sorted in and the names starting with a prefix are one range of the array.
+// searchRanges holds the file offset and size of every name, searchKinds one letter each
+let searchKindNames = {s: 'section', f: 'function', o: 'object', '-': 'symbol'};
+let searchLimit = 50;
+
+// first name not less than prefix
+function searchLowerBound(prefix) {
+    var low = 0;
+    var high = searchNames.length;
+    while (low < high) {
+        let middle = (low + high) >> 1;
+        if (searchNames[middle] < prefix) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// first name from low on that doesn't start with prefix
+function searchUpperBound(prefix, low) {
+    var high = searchNames.length;
+    while (low < high) {
+        let middle = (low + high) >> 1;
+        if (searchNames[middle].startsWith(prefix)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// typed text as the names are stored: its UTF-8 bytes, one code unit each
+function searchBytes(text) {
+    return unescape(encodeURIComponent(text));
+}
+
+function searchDisplayName(name) {
+    try {
+        return decodeURIComponent(escape(name));
+    } catch (error) {
+        return name;
+    }
+}
+
+function showSearchResults() {
+    let prefix = searchBytes(document.getElementById('search').value);
+    let results = document.getElementById('search_results');
+    results.textContent = '';
+
+    if (prefix.length == 0) {
+        return;
+    }
+
+    let first = searchLowerBound(prefix);
+    let end = searchUpperBound(prefix, first);
+
+    for (var i = first; i < end && i < first + searchLimit; ++i) {
+        let offset = searchRanges[i * 2];
+        let size = searchRanges[i * 2 + 1];
+        let link = document.createElement('a');
+        link.href = '#0x' + offset.toString(16);
+        link.textContent = searchDisplayName(searchNames[i]);
+        link.title = searchKindNames[searchKinds[i]] + ', ' + size + ' bytes at 0x' + offset.toString(16);
+        results.appendChild(link);
+        results.appendChild(document.createElement('br'));
+    }
+
+    if (end == first) {
+        results.appendChild(document.createTextNode('no match'));
+    } else if (end - first > searchLimit) {
+        results.appendChild(document.createTextNode((end - first - searchLimit) + ' more'));
+    }
+}
+
+// enter jumps to the first match
+function setupSearch() {
+    let input = document.getElementById('search');
+    input.addEventListener('input', showSearchResults);
+    input.addEventListener('keydown', (event) => {
+        let first = document.querySelector('#search_results > a');
+        if (event.key == 'Enter' && first) {
+            window.location.hash = first.hash;
+        }
+    });
+}
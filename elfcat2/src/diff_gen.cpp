@@ -0,0 +1,66 @@
+#include <cinttypes>
+#include <cstdio>
+
+#include <defs.hpp>
+
+#include "diff_gen.hpp"
+#include "report_gen.hpp"
+
+
+namespace {
+
+std::string size_or_dash(const std::optional<size_t>& index, uint64_t size) {
+    return index ? std::to_string(size) : "-";
+}
+
+}
+
+// one line per section and segment that differs, then the totals
+void print_diff_summary(std::ostream& o, const ElfDiff& diff, const std::string& filename) {
+    size_t sections_differing = 0;
+    size_t segments_differing = 0;
+    uint64_t changed_bytes = 0;
+    uint64_t moved_bytes = 0;
+
+    char buf[128];
+
+    for (const auto& section : diff.sections) {
+        changed_bytes += section.changed_bytes;
+        moved_bytes += section.moved_bytes;
+        if (section.status == DiffStatus::same) {
+            continue;
+        }
+        ++sections_differing;
+
+        auto status = diff_status_to_string(section.status);
+        std::snprintf(buf, sizeof(buf), "%-8s %10s %10s  changed %" PRIu64 " moved %" PRIu64 " removed %" PRIu64,
+                status.c_str(), size_or_dash(section.base_index, section.base_size).c_str(),
+                size_or_dash(section.index, section.size).c_str(), section.changed_bytes, section.moved_bytes,
+                section.removed_bytes);
+        o << "section " << buf << "  " << section.name;
+        if (section.status == DiffStatus::changed) {
+            o << " (" << section_diff_details(section) << ")";
+        }
+        o << '\n';
+    }
+
+    for (const auto& segment : diff.segments) {
+        if (segment.status == DiffStatus::same) {
+            continue;
+        }
+        ++segments_differing;
+
+        auto status = diff_status_to_string(segment.status);
+        std::snprintf(buf, sizeof(buf), "%-8s", status.c_str());
+        o << "segment " << buf << "  " << ptype_to_string(segment.ptype) << " #" << segment.ordinal << '\n';
+    }
+
+    o << diff.base_filename << " -> " << filename << ": ";
+    if (diff.identical()) {
+        o << "identical\n";
+        return;
+    }
+    o << sections_differing << " of " << diff.sections.size() << " sections and " << segments_differing << " of "
+        << diff.segments.size() << " segments differ, ELF header " << (diff.header_changed ? "changed" : "same")
+        << ", " << changed_bytes << " bytes changed, " << moved_bytes << " moved\n";
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <ostream>
+
+#include <elf_diff.hpp>
+
+
+void print_diff_summary(std::ostream& o, const ElfDiff& diff, const std::string& filename);
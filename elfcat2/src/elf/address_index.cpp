@@ -0,0 +1,124 @@
+#include <algorithm>
+
+#include <stats.hpp>
+
+#include "include/address_index.hpp"
+#include "include/defs.hpp"
+
+
+IntervalSet IntervalSet::build(std::vector<Interval> intervals) {
+    std::stable_sort(intervals.begin(), intervals.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.start < rhs.start;
+    });
+
+    IntervalSet set;
+    set.intervals.reserve(intervals.size());
+
+    for (auto interval : intervals) {
+        if (interval.start >= interval.end) {
+            continue;
+        }
+        if (!set.intervals.empty()) {
+            auto previous_end = set.intervals.back().end;
+            if (interval.end <= previous_end) {
+                continue;
+            }
+            interval.start = std::max(interval.start, previous_end);
+        }
+        set.intervals.push_back(interval);
+    }
+
+    return set;
+}
+
+const Interval* IntervalSet::find(uint64_t point) const {
+    // first interval starting past the point; the candidate is the one before it
+    auto found = std::upper_bound(intervals.begin(), intervals.end(), point, [](uint64_t value, const auto& interval) {
+        return value < interval.start;
+    });
+
+    if (found == intervals.begin()) {
+        return nullptr;
+    }
+
+    --found;
+    return (point < found->end) ? &*found : nullptr;
+}
+
+AddressIndex AddressIndex::build(const ParsedElf& elf) {
+    STATS_PHASE(phase, "address_index");
+
+    std::vector<Interval> segment_vaddrs;
+    std::vector<Interval> segment_offsets;
+
+    for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+        const auto& phdr = elf.phdrs[i];
+        if (phdr.ptype != PT_LOAD) {
+            continue;
+        }
+        segment_vaddrs.push_back({phdr.vaddr, phdr.vaddr + phdr.memsz, i});
+        segment_offsets.push_back({phdr.file_offset, phdr.file_offset + phdr.file_size, i});
+    }
+
+    std::vector<Interval> section_vaddrs;
+    std::vector<Interval> section_offsets;
+
+    for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+        const auto& shdr = elf.shdrs[i];
+        bool tbss = (shdr.flags & SHF_TLS) && shdr.shtype == SHT_NOBITS;
+
+        if ((shdr.flags & SHF_ALLOC) && !tbss) {
+            section_vaddrs.push_back({shdr.addr, shdr.addr + shdr.size, i});
+        }
+        if (shdr.shtype != SHT_NOBITS && shdr.shtype != SHT_NULL) {
+            section_offsets.push_back({shdr.file_offset, shdr.file_offset + shdr.size, i});
+        }
+    }
+
+    AddressIndex index;
+    index.elf = &elf;
+    index.segments_by_vaddr = IntervalSet::build(std::move(segment_vaddrs));
+    index.segments_by_offset = IntervalSet::build(std::move(segment_offsets));
+    index.sections_by_vaddr = IntervalSet::build(std::move(section_vaddrs));
+    index.sections_by_offset = IntervalSet::build(std::move(section_offsets));
+    return index;
+}
+
+AddressLocation AddressIndex::from_vaddr(uint64_t vaddr) const {
+    AddressLocation location;
+    location.vaddr = vaddr;
+
+    if (auto segment = segments_by_vaddr.find(vaddr)) {
+        const auto& phdr = elf->phdrs[segment->index];
+        uint64_t delta = vaddr - phdr.vaddr;
+
+        location.segment = segment->index;
+        if (delta < phdr.file_size) {
+            location.file_offset = phdr.file_offset + delta;
+        }
+    }
+
+    if (auto section = sections_by_vaddr.find(vaddr)) {
+        location.section = section->index;
+    }
+
+    return location;
+}
+
+AddressLocation AddressIndex::from_offset(uint64_t offset) const {
+    AddressLocation location;
+    location.file_offset = offset;
+
+    if (auto segment = segments_by_offset.find(offset)) {
+        const auto& phdr = elf->phdrs[segment->index];
+
+        location.segment = segment->index;
+        location.vaddr = phdr.vaddr + (offset - phdr.file_offset);
+    }
+
+    if (auto section = sections_by_offset.find(offset)) {
+        location.section = section->index;
+    }
+
+    return location;
+}
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <parallel.hpp>
+#include <stats.hpp>
+
+#include "include/archive.hpp"
+
+
+namespace {
+
+constexpr char AR_MAGIC[] = "!<arch>\n";
+constexpr char THIN_MAGIC[] = "!<thin>\n";
+constexpr size_t AR_MAGIC_SIZE = 8;
+constexpr size_t AR_HEADER_SIZE = 60;
+
+
+struct RawHeader {
+    std::string_view name;
+    size_t size;
+};
+
+
+std::string_view field(const ByteView& buf, size_t offset, size_t length) {
+    std::string_view text(reinterpret_cast<const char*>(buf.data()) + offset, length);
+    auto end = text.find_last_not_of(' ');
+    return end == std::string_view::npos ? std::string_view() : text.substr(0, end + 1);
+}
+
+RawHeader read_header(const ByteView& buf, size_t offset) {
+    if (offset + AR_HEADER_SIZE > buf.size()) {
+        throw std::runtime_error("archive member header past the end of the file");
+    }
+    if (buf[offset + 58] != '`' || buf[offset + 59] != '\n') {
+        throw std::runtime_error("corrupt archive member header");
+    }
+
+    auto size_text = field(buf, offset + 48, 10);
+    size_t size = 0;
+    auto [end, error] = std::from_chars(size_text.data(), size_text.data() + size_text.size(), size);
+    if (error != std::errc() || end != size_text.data() + size_text.size()) {
+        throw std::runtime_error("corrupt archive member size");
+    }
+    if (size > buf.size() - offset - AR_HEADER_SIZE) {
+        throw std::runtime_error("archive member past the end of the file");
+    }
+
+    return {field(buf, offset, 16), size};
+}
+
+template<class T>
+T read_be(const ByteView& buf, size_t offset) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value = (value << 8) | buf[offset + i];
+    }
+    return value;
+}
+
+template<class T>
+T read_le(const ByteView& buf, size_t offset) {
+    T value = 0;
+    for (size_t i = sizeof(T); i-- > 0;) {
+        value = (value << 8) | buf[offset + i];
+    }
+    return value;
+}
+
+std::string c_string(const ByteView& table, size_t& pos) {
+    if (pos >= table.size()) {
+        return {};
+    }
+    auto start = pos;
+    while (pos < table.size() && table[pos] != 0) {
+        ++pos;
+    }
+    std::string result(reinterpret_cast<const char*>(table.data()) + start, pos - start);
+    ++pos;
+    return result;
+}
+
+// (name, member header offset) pairs of a GNU "/" or "/SYM64/" index: a big
+// endian count, that many offsets, then the names
+template<class Word>
+std::vector<std::tuple<std::string, size_t>> gnu_symbols(const ByteView& index) {
+    if (index.size() < sizeof(Word)) {
+        throw std::runtime_error("truncated archive symbol index");
+    }
+    auto count = read_be<Word>(index, 0);
+    if (count > (index.size() - sizeof(Word)) / sizeof(Word)) {
+        throw std::runtime_error("truncated archive symbol index");
+    }
+
+    std::vector<std::tuple<std::string, size_t>> symbols;
+    symbols.reserve(count);
+    size_t pos = sizeof(Word) * (count + 1);
+
+    for (size_t i = 0; i < count; ++i) {
+        auto offset = read_be<Word>(index, sizeof(Word) * (i + 1));
+        symbols.emplace_back(c_string(index, pos), offset);
+    }
+    return symbols;
+}
+
+// BSD "__.SYMDEF": a byte count of (name, header offset) ranlib entries, the
+// entries, a byte count of the string table and the table; little endian, and
+// 64-bit throughout for "__.SYMDEF_64"
+template<class Word>
+std::vector<std::tuple<std::string, size_t>> bsd_symbols(const ByteView& index) {
+    // both byte counts, whatever is between them
+    if (index.size() < 2 * sizeof(Word)) {
+        throw std::runtime_error("truncated archive symbol index");
+    }
+    auto entries_size = read_le<Word>(index, 0);
+    if (entries_size > index.size() - 2 * sizeof(Word)) {
+        throw std::runtime_error("truncated archive symbol index");
+    }
+
+    size_t strings_offset = sizeof(Word) * 2 + entries_size;
+    auto strings_size = read_le<Word>(index, sizeof(Word) + entries_size);
+    if (strings_size > index.size() - strings_offset) {
+        throw std::runtime_error("truncated archive symbol index");
+    }
+    auto strings = index.subview(strings_offset, strings_offset + strings_size);
+
+    std::vector<std::tuple<std::string, size_t>> symbols;
+    for (size_t entry = sizeof(Word); entry + 2 * sizeof(Word) <= sizeof(Word) + entries_size; entry += 2 * sizeof(Word)) {
+        size_t name = read_le<Word>(index, entry);
+        auto offset = read_le<Word>(index, entry + sizeof(Word));
+        if (name < strings.size()) {
+            symbols.emplace_back(c_string(strings, name), offset);
+        }
+    }
+    return symbols;
+}
+
+}
+
+
+bool Archive::is_archive(const ByteView& buf) {
+    return buf.size() >= AR_MAGIC_SIZE
+        && (std::memcmp(buf.data(), AR_MAGIC, AR_MAGIC_SIZE) == 0 || std::memcmp(buf.data(), THIN_MAGIC, AR_MAGIC_SIZE) == 0);
+}
+
+Archive Archive::from_bytes(const ByteView& buf) {
+    if (!is_archive(buf)) {
+        throw std::runtime_error("mismatched magic: not an ar archive");
+    }
+    if (std::memcmp(buf.data(), THIN_MAGIC, AR_MAGIC_SIZE) == 0) {
+        throw std::runtime_error("thin archives are not supported");
+    }
+
+    Archive archive;
+    ByteView long_names;
+    std::vector<std::tuple<std::string, size_t>> raw_symbols;
+
+    for (size_t offset = AR_MAGIC_SIZE; offset < buf.size();) {
+        // some tools pad the end of the archive with a newline
+        if (offset + 1 == buf.size() && buf[offset] == '\n') {
+            break;
+        }
+
+        auto header = read_header(buf, offset);
+        size_t data = offset + AR_HEADER_SIZE;
+        size_t size = header.size;
+        auto contents = buf.subview(data, data + size);
+        std::string name;
+
+        if (header.name == "/" || header.name == "/SYM64/") {
+            raw_symbols = header.name == "/" ? gnu_symbols<uint32_t>(contents) : gnu_symbols<uint64_t>(contents);
+        } else if (header.name == "//") {
+            long_names = contents;
+        } else if (header.name.size() > 1 && header.name[0] == '/') {
+            size_t name_offset = 0;
+            auto digits = header.name.substr(1);
+            auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), name_offset);
+            if (error != std::errc() || name_offset >= long_names.size()) {
+                throw std::runtime_error("bad archive long name reference");
+            }
+            auto table = std::string_view(reinterpret_cast<const char*>(long_names.data()), long_names.size());
+            auto name_end = table.find('\n', name_offset);
+            name = std::string(table.substr(name_offset, name_end - name_offset));
+            if (!name.empty() && name.back() == '/') {
+                name.pop_back();
+            }
+        } else if (header.name.rfind("#1/", 0) == 0) {
+            // BSD: the name is the first N bytes of the contents
+            size_t name_size = 0;
+            auto digits = header.name.substr(3);
+            auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), name_size);
+            if (error != std::errc() || name_size > size) {
+                throw std::runtime_error("bad archive member name length");
+            }
+            name = std::string(reinterpret_cast<const char*>(contents.data()), name_size);
+            name.resize(std::strlen(name.c_str()));
+            data += name_size;
+            size -= name_size;
+        } else {
+            name = std::string(header.name);
+            if (!name.empty() && name.back() == '/') {
+                name.pop_back();
+            }
+        }
+
+        if (name.rfind("__.SYMDEF", 0) == 0) {
+            auto index = buf.subview(data, data + size);
+            raw_symbols = name.find("_64") != std::string::npos ? bsd_symbols<uint64_t>(index) : bsd_symbols<uint32_t>(index);
+        } else if (!name.empty()) {
+            archive.members.push_back({name, offset, data, size});
+        }
+
+        offset += AR_HEADER_SIZE + header.size + (header.size & 1);
+    }
+
+    std::unordered_map<size_t, size_t> member_at;
+    for (size_t i = 0; i < archive.members.size(); ++i) {
+        member_at.emplace(archive.members[i].header_offset, i);
+    }
+
+    archive.symbols.reserve(raw_symbols.size());
+    for (auto& [name, header_offset] : raw_symbols) {
+        auto found = member_at.find(header_offset);
+        if (found != member_at.end()) {
+            archive.symbols.push_back({std::move(name), found->second});
+        }
+    }
+
+    return archive;
+}
+
+ParsedArchive ParsedArchive::from_bytes(const std::string& filename, const ByteView& buf, size_t jobs) {
+    STATS_PHASE(phase, "archive");
+
+    ParsedArchive result;
+    result.filename = filename;
+    result.file_size = buf.size();
+    result.archive = Archive::from_bytes(buf);
+
+    auto count = result.archive.members.size();
+    result.elves.resize(count);
+    result.errors.resize(count);
+
+    parallel_for(count, jobs, [&](size_t i) {
+        const auto& member = result.archive.members[i];
+        try {
+            result.elves[i] = ParsedElf::from_bytes(filename + "(" + member.name + ")",
+                    buf.subview(member.offset, member.offset + member.size));
+            // the report reads the section names of every member, warm them here
+            result.elves[i]->shnstrtab();
+        } catch (const std::runtime_error& e) {
+            result.elves[i].reset();
+            result.errors[i] = e.what();
+        }
+    });
+
+    return result;
+}
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#include <file_walk.hpp>
+#include <parallel.hpp>
+#include <stats.hpp>
+
+#include "include/build_id_index.hpp"
+#include "include/defs.hpp"
+#include "include/parser.hpp"
+
+
+namespace {
+
+constexpr char INDEX_MAGIC[8] = {'E', 'L', 'F', 'C', 'A', 'T', 'B', 'I'};
+constexpr uint32_t INDEX_VERSION = 1;
+
+static_assert(sizeof(BuildIdIndexHeader) == 32);
+static_assert(sizeof(BuildIdRecord) == 56);
+
+
+BuildIdRecord make_key(const ByteView& build_id) {
+    BuildIdRecord key = {};
+    std::memcpy(key.build_id, build_id.data(), build_id.size());
+    key.build_id_size = static_cast<uint8_t>(build_id.size());
+    return key;
+}
+
+bool key_less(const BuildIdRecord& lhs, const BuildIdRecord& rhs) {
+    auto order = std::memcmp(lhs.build_id, rhs.build_id, BUILD_ID_MAX);
+    return order < 0 || (order == 0 && lhs.build_id_size < rhs.build_id_size);
+}
+
+std::optional<BuildIdEntry> read_entry(const std::string& path) {
+    MappedFile file;
+    try {
+        file = MappedFile::open(path);
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+
+    // most of a store isn't ELF, don't make those throw
+    auto view = file.view();
+    if (view.size() < static_cast<size_t>(ELF_EI_NIDENT) || std::memcmp(view.data(), "\x7f" "ELF", 4) != 0) {
+        return std::nullopt;
+    }
+
+    try {
+        auto elf = ParsedElf::from_bytes(path, view);
+        auto build_id = find_build_id(elf);
+        if (!build_id || build_id->empty() || build_id->size() > BUILD_ID_MAX) {
+            return std::nullopt;
+        }
+        return BuildIdEntry{std::move(*build_id), path, view.size(), elf.machine, elf.ident.class_};
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+}
+
+}
+
+
+std::optional<std::vector<uint8_t>> find_build_id(const ParsedElf& elf) {
+    for (const auto& note : elf.notes()) {
+        if (note.ntype == NT_GNU_BUILD_ID && note.name.size() == 4 && std::memcmp(note.name.data(), "GNU", 4) == 0) {
+            return note.desc;
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<BuildIdEntry> scan_build_ids(const std::vector<std::string>& roots, size_t jobs) {
+    STATS_PHASE(phase, "scan_build_ids");
+
+    std::vector<std::string> files;
+    for (const auto& root : roots) {
+        // absolute paths, so that the index can be queried from anywhere
+        std::unique_ptr<char, decltype(&std::free)> resolved(realpath(root.c_str(), nullptr), &std::free);
+        auto found = list_regular_files(resolved ? resolved.get() : root);
+        files.insert(files.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    }
+
+    std::vector<std::optional<BuildIdEntry>> read(files.size());
+    parallel_for(files.size(), jobs, [&](size_t i) {
+        read[i] = read_entry(files[i]);
+    });
+
+    std::vector<BuildIdEntry> entries;
+    for (auto& entry : read) {
+        if (entry) {
+            entries.push_back(std::move(*entry));
+        }
+    }
+    return entries;
+}
+
+std::optional<std::vector<uint8_t>> parse_build_id(std::string_view text) {
+    if (text.empty() || text.size() % 2 != 0 || text.size() > 2 * BUILD_ID_MAX) {
+        return std::nullopt;
+    }
+
+    auto digit = [](char ch) -> int {
+        if (ch >= '0' && ch <= '9') {
+            return ch - '0';
+        }
+        if (ch >= 'a' && ch <= 'f') {
+            return ch - 'a' + 10;
+        }
+        if (ch >= 'A' && ch <= 'F') {
+            return ch - 'A' + 10;
+        }
+        return -1;
+    };
+
+    std::vector<uint8_t> build_id;
+    build_id.reserve(text.size() / 2);
+    for (size_t i = 0; i < text.size(); i += 2) {
+        auto high = digit(text[i]);
+        auto low = digit(text[i + 1]);
+        if (high < 0 || low < 0) {
+            return std::nullopt;
+        }
+        build_id.push_back(static_cast<uint8_t>(high << 4 | low));
+    }
+    return build_id;
+}
+
+void BuildIdIndex::write(const std::string& path, std::vector<BuildIdEntry> entries) {
+    STATS_PHASE(phase, "write_index");
+
+    std::stable_sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+        return key_less(make_key(lhs.build_id), make_key(rhs.build_id));
+    });
+
+    std::vector<BuildIdRecord> records;
+    records.reserve(entries.size());
+    std::string paths;
+
+    for (const auto& entry : entries) {
+        auto record = make_key(entry.build_id);
+        record.elf_class = entry.elf_class;
+        record.machine = entry.machine;
+        record.path_size = static_cast<uint32_t>(entry.path.size());
+        record.path_offset = paths.size();
+        record.file_size = entry.file_size;
+        records.push_back(record);
+        paths += entry.path;
+    }
+
+    BuildIdIndexHeader header = {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.record_size = sizeof(BuildIdRecord);
+    header.count = records.size();
+    header.paths_offset = sizeof(header) + records.size() * sizeof(BuildIdRecord);
+
+    // written next to the target and renamed over it, so readers never map half an index
+    auto temporary = path + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(BuildIdRecord));
+        output.write(paths.data(), paths.size());
+        if (!output) {
+            throw std::runtime_error("can't write '" + temporary + "'");
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("can't write '" + path + "'");
+    }
+
+    STATS_EMITTED(phase, header.paths_offset + paths.size());
+}
+
+BuildIdIndex BuildIdIndex::open(const std::string& path) {
+    BuildIdIndex index;
+    index.file = MappedFile::open(path);
+
+    auto view = index.file.view();
+    BuildIdIndexHeader header;
+    if (view.size() < sizeof(header)) {
+        throw std::runtime_error("'" + path + "' is not a build-id index");
+    }
+    std::memcpy(&header, view.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        throw std::runtime_error("'" + path + "' is not a build-id index");
+    }
+    if (header.version != INDEX_VERSION || header.record_size != sizeof(BuildIdRecord)) {
+        throw std::runtime_error("'" + path + "' was written by another version of elfcat");
+    }
+    if (header.count > (view.size() - sizeof(header)) / sizeof(BuildIdRecord)
+            || header.paths_offset != sizeof(header) + header.count * sizeof(BuildIdRecord)) {
+        throw std::runtime_error("'" + path + "' is truncated");
+    }
+
+    // the mapping is page aligned and the header is a multiple of 8 bytes, so the records are aligned
+    index.records = reinterpret_cast<const BuildIdRecord*>(view.data() + sizeof(header));
+    index.count = header.count;
+    index.paths = view.subview(header.paths_offset, view.size());
+    return index;
+}
+
+std::vector<BuildIdEntry> BuildIdIndex::lookup(const ByteView& build_id) const {
+    if (build_id.empty() || build_id.size() > BUILD_ID_MAX) {
+        return {};
+    }
+
+    auto key = make_key(build_id);
+    auto [first, last] = std::equal_range(records, records + count, key, key_less);
+
+    std::vector<BuildIdEntry> found;
+    for (auto it = first; it != last; ++it) {
+        if (it->path_offset > paths.size() || it->path_size > paths.size() - it->path_offset) {
+            throw std::runtime_error("corrupt build-id index");
+        }
+        BuildIdEntry entry;
+        entry.build_id.assign(it->build_id, it->build_id + it->build_id_size);
+        entry.path.assign(reinterpret_cast<const char*>(paths.data()) + it->path_offset, it->path_size);
+        entry.file_size = it->file_size;
+        entry.machine = it->machine;
+        entry.elf_class = it->elf_class;
+        found.push_back(std::move(entry));
+    }
+    return found;
+}
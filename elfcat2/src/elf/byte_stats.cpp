@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+
+#include <parallel.hpp>
+#include <stats.hpp>
+
+#include "include/byte_stats.hpp"
+#include "include/defs.hpp"
+#include "include/parser.hpp"
+
+
+namespace {
+
+// ranges larger than this are split so that one big section keeps every thread busy
+constexpr size_t STATS_PIECE = 4 << 20;
+// entropy strip work unit, a multiple of ENTROPY_BLOCK
+constexpr size_t STRIP_CHUNK = 1 << 20;
+
+uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Four interleaved tables: consecutive equal bytes land in different counters,
+// so increments don't wait on the store of the previous one. Counters are 32-bit
+// to keep the tables in L1, which bounds a single call.
+void count_bytes(const uint8_t* p, size_t size, std::array<uint64_t, 256>& histogram) {
+    constexpr size_t MAX_CALL = size_t(1) << 31;
+
+    while (size > 0) {
+        size_t n = std::min(size, MAX_CALL);
+        uint32_t tables[4][256] = {};
+        const uint8_t* end = p + n;
+
+        while (p + 8 <= end) {
+            uint64_t word = read64(p);
+            ++tables[0][word & 0xff];
+            ++tables[1][(word >> 8) & 0xff];
+            ++tables[2][(word >> 16) & 0xff];
+            ++tables[3][(word >> 24) & 0xff];
+            ++tables[0][(word >> 32) & 0xff];
+            ++tables[1][(word >> 40) & 0xff];
+            ++tables[2][(word >> 48) & 0xff];
+            ++tables[3][word >> 56];
+            p += 8;
+        }
+        while (p < end) {
+            ++tables[0][*p++];
+        }
+
+        for (size_t i = 0; i < 256; ++i) {
+            histogram[i] += uint64_t(tables[0][i]) + tables[1][i] + tables[2][i] + tables[3][i];
+        }
+        size -= n;
+    }
+}
+
+bool has_zero_byte(uint64_t word) {
+    return ((word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL) != 0;
+}
+
+// c * log2(c) for every count a block can have
+const std::array<double, ENTROPY_BLOCK + 1>& c_log_c() {
+    static const auto table = [] {
+        std::array<double, ENTROPY_BLOCK + 1> result{};
+        for (size_t c = 1; c <= ENTROPY_BLOCK; ++c) {
+            result[c] = c * std::log2(static_cast<double>(c));
+        }
+        return result;
+    }();
+    return table;
+}
+
+char entropy_level(const uint8_t* p, size_t size) {
+    const auto& table = c_log_c();
+    uint16_t counts[256] = {};
+
+    for (size_t i = 0; i < size; ++i) {
+        ++counts[p[i]];
+    }
+
+    // H = log2(n) - sum(c log2 c) / n, visiting only the values present
+    double sum = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (counts[p[i]] != 0) {
+            sum += table[counts[p[i]]];
+            counts[p[i]] = 0;
+        }
+    }
+
+    double entropy = std::log2(static_cast<double>(size)) - sum / size;
+    auto level = static_cast<size_t>(entropy * ENTROPY_LEVELS / 8);
+    return static_cast<char>('0' + std::min(level, ENTROPY_LEVELS - 1));
+}
+
+void fill_entropy_levels(const ByteView& bytes, char* out) {
+    for (size_t start = 0; start < bytes.size(); start += ENTROPY_BLOCK) {
+        size_t size = std::min(ENTROPY_BLOCK, bytes.size() - start);
+        *out++ = entropy_level(bytes.data() + start, size);
+    }
+}
+
+
+struct Piece {
+    size_t start;
+    size_t end;
+    ByteSummary* summary;
+    // slot in the partials of a range split into several pieces
+    std::optional<size_t> partial;
+};
+
+}
+
+
+ByteStats ByteStats::of(const ByteView& bytes) {
+    ByteStats stats;
+    stats.size = bytes.size();
+    count_bytes(bytes.data(), bytes.size(), stats.histogram);
+
+    const uint8_t* p = bytes.data();
+    const uint8_t* end = p + bytes.size();
+    uint64_t run = 0;
+    bool at_start = true;
+
+    auto end_run = [&] {
+        if (at_start) {
+            stats.leading_zeros = run;
+            at_start = false;
+        } else if (run >= ZERO_RUN_MIN) {
+            stats.inner_zero_run_bytes += run;
+        }
+        run = 0;
+    };
+
+    while (p < end) {
+        if (p + 8 <= end) {
+            uint64_t word = read64(p);
+            if (word == 0) {
+                run += 8;
+                p += 8;
+                continue;
+            }
+            if (!has_zero_byte(word)) {
+                end_run();
+                p += 8;
+                continue;
+            }
+        }
+        if (*p == 0) {
+            ++run;
+        } else {
+            end_run();
+        }
+        ++p;
+    }
+
+    if (at_start) {
+        stats.leading_zeros = run;
+    }
+    stats.trailing_zeros = run;
+
+    return stats;
+}
+
+void ByteStats::merge(const ByteStats& next) {
+    for (size_t i = 0; i < 256; ++i) {
+        histogram[i] += next.histogram[i];
+    }
+
+    bool all_zero = leading_zeros == size;
+    bool next_all_zero = next.leading_zeros == next.size;
+
+    if (all_zero) {
+        leading_zeros += next.leading_zeros;
+        inner_zero_run_bytes = next.inner_zero_run_bytes;
+    } else if (!next_all_zero) {
+        uint64_t joined = trailing_zeros + next.leading_zeros;
+        inner_zero_run_bytes += next.inner_zero_run_bytes + (joined >= ZERO_RUN_MIN ? joined : 0);
+    }
+    trailing_zeros = next_all_zero ? trailing_zeros + next.size : next.trailing_zeros;
+    size += next.size;
+}
+
+double ByteStats::entropy() const {
+    if (size == 0) {
+        return 0;
+    }
+
+    double result = 0;
+    for (auto count : histogram) {
+        if (count != 0) {
+            double p = static_cast<double>(count) / size;
+            result -= p * std::log2(p);
+        }
+    }
+    return result;
+}
+
+uint64_t ByteStats::zero_run_bytes() const {
+    if (leading_zeros == size) {
+        return size >= ZERO_RUN_MIN ? size : 0;
+    }
+    return inner_zero_run_bytes + (leading_zeros >= ZERO_RUN_MIN ? leading_zeros : 0)
+        + (trailing_zeros >= ZERO_RUN_MIN ? trailing_zeros : 0);
+}
+
+ByteSummary ByteSummary::of(const ByteStats& stats) {
+    constexpr size_t COMMON_SHOWN = 4;
+
+    ByteSummary summary;
+    summary.size = stats.size;
+    summary.entropy = stats.entropy();
+    summary.zero_run_bytes = stats.zero_run_bytes();
+
+    for (size_t i = 0; i < 256; ++i) {
+        if (stats.histogram[i] != 0) {
+            summary.common.emplace_back(static_cast<uint8_t>(i), stats.histogram[i]);
+        }
+    }
+    auto shown = std::min(COMMON_SHOWN, summary.common.size());
+    std::partial_sort(summary.common.begin(), summary.common.begin() + shown, summary.common.end(),
+            [](const auto& lhs, const auto& rhs) { return std::get<1>(lhs) > std::get<1>(rhs); });
+    summary.common.resize(shown);
+
+    return summary;
+}
+
+ElfByteStats ElfByteStats::build(const ParsedElf& elf, size_t jobs) {
+    STATS_PHASE(phase, "byte_stats");
+
+    ElfByteStats result;
+    result.sections.resize(elf.shdrs.size());
+    result.segments.resize(elf.phdrs.size());
+
+    std::vector<Piece> pieces;
+    size_t partial_count = 0;
+
+    auto add_range = [&](size_t offset, size_t size, ByteSummary& summary) {
+        auto [start, end] = elf.file_range(offset, size);
+        if (start == end) {
+            return;
+        }
+        if (end - start <= STATS_PIECE) {
+            pieces.push_back({start, end, &summary, std::nullopt});
+            return;
+        }
+        for (size_t piece = start; piece < end; piece += STATS_PIECE) {
+            pieces.push_back({piece, std::min(end, piece + STATS_PIECE), &summary, partial_count++});
+        }
+    };
+
+    for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+        if (elf.shdrs[i].shtype != SHT_NOBITS) {
+            add_range(elf.shdrs[i].file_offset, elf.shdrs[i].size, result.sections[i]);
+        }
+    }
+    for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+        add_range(elf.phdrs[i].file_offset, elf.phdrs[i].file_size, result.segments[i]);
+    }
+
+    // reads through the block cache can't be shared between threads
+    if (elf.source) {
+        jobs = 1;
+    }
+
+    std::vector<ByteStats> partials(partial_count);
+    std::vector<uint8_t> scratch;
+
+    parallel_for(pieces.size(), jobs, [&](size_t i) {
+        const auto& piece = pieces[i];
+        auto stats = ByteStats::of(elf.bytes(piece.start, piece.end, scratch));
+        if (piece.partial) {
+            partials[*piece.partial] = std::move(stats);
+        } else {
+            *piece.summary = ByteSummary::of(stats);
+        }
+    });
+
+    // pieces of one range are consecutive and in order
+    for (size_t i = 0; i < pieces.size();) {
+        if (!pieces[i].partial) {
+            ++i;
+            continue;
+        }
+        auto stats = partials[*pieces[i].partial];
+        size_t next = i + 1;
+        while (next < pieces.size() && pieces[next].summary == pieces[i].summary) {
+            stats.merge(partials[*pieces[next].partial]);
+            ++next;
+        }
+        *pieces[i].summary = ByteSummary::of(stats);
+        i = next;
+    }
+
+    result.entropy_levels.resize((elf.file_size + ENTROPY_BLOCK - 1) / ENTROPY_BLOCK);
+    size_t chunks = (elf.file_size + STRIP_CHUNK - 1) / STRIP_CHUNK;
+
+    parallel_for(chunks, jobs, [&](size_t i) {
+        size_t start = i * STRIP_CHUNK;
+        size_t end = std::min(elf.file_size, start + STRIP_CHUNK);
+        fill_entropy_levels(elf.bytes(start, end, scratch), &result.entropy_levels[start / ENTROPY_BLOCK]);
+    });
+
+    return result;
+}
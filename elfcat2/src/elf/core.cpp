@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include <sparse.hpp>
+#include <stats.hpp>
+
+#include "include/core.hpp"
+#include "include/defs.hpp"
+#include "include/elfxx.hpp"
+#include "include/parser.hpp"
+
+
+namespace {
+
+// bounds-checked reads out of a note descriptor in the file's byte order, which is
+// fixed per instantiation
+template<bool big_endian>
+struct DescReader {
+    bool has(size_t offset, size_t size) const {
+        return offset <= desc.size() && desc.size() - offset >= size;
+    }
+
+    // 0 for fields past the end of the descriptor
+    uint64_t read(size_t offset, size_t size) const {
+        if (!has(offset, size)) {
+            return 0;
+        }
+        const uint8_t* p = desc.data() + offset;
+        switch (size) {
+            case 2: return load_bytes<uint16_t, big_endian>(p);
+            case 4: return load_bytes<uint32_t, big_endian>(p);
+            case 8: return load_bytes<uint64_t, big_endian>(p);
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            value = (value << 8) | p[big_endian ? i : size - 1 - i];
+        }
+        return value;
+    }
+
+    uint64_t word(size_t offset) const {
+        return read(offset, word_size);
+    }
+
+    std::string c_string(size_t offset, size_t max_len) const {
+        std::string result;
+        for (size_t i = offset; i < desc.size() && i < offset + max_len && desc[i] != 0; ++i) {
+            result += static_cast<char>(desc[i]);
+        }
+        return result;
+    }
+
+    const std::vector<uint8_t>& desc;
+    size_t word_size;
+};
+
+
+// offsets into struct elf_prstatus and elf_prpsinfo, per class
+struct CoreLayout {
+    size_t prstatus_pid;
+    size_t prstatus_regs;
+    size_t prpsinfo_fname;
+    size_t prpsinfo_args;
+    size_t siginfo_addr;
+};
+
+constexpr CoreLayout CORE_LAYOUT_32 = {24, 72, 28, 44, 12};
+constexpr CoreLayout CORE_LAYOUT_64 = {32, 112, 40, 56, 16};
+
+constexpr size_t PRSTATUS_CURSIG = 12;
+constexpr size_t PRPSINFO_FNAME_LEN = 16;
+constexpr size_t PRPSINFO_ARGS_LEN = 80;
+
+
+// (pc, sp) register indices inside pr_reg
+std::optional<std::tuple<size_t, size_t>> pc_sp_registers(uint16_t machine) {
+    switch (machine) {
+        case EM_386:
+            return std::make_tuple(12, 15);
+        case EM_X86_64:
+            return std::make_tuple(16, 19);
+        case EM_AARCH64:
+            return std::make_tuple(32, 31);
+        default:
+            return std::nullopt;
+    }
+}
+
+bool signal_has_addr(int32_t signo) {
+    // SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV
+    return signo == 4 || signo == 5 || signo == 7 || signo == 8 || signo == 11;
+}
+
+template<class Reader>
+void parse_prstatus(CoreInfo& core, const Reader& r, const CoreLayout& layout, uint16_t machine) {
+    if (!r.has(layout.prstatus_regs, 0)) {
+        return;
+    }
+
+    CoreThread thread{
+        static_cast<int32_t>(r.read(layout.prstatus_pid, 4)),
+        static_cast<int16_t>(r.read(PRSTATUS_CURSIG, 2)),
+        std::nullopt,
+        std::nullopt,
+    };
+
+    if (auto regs = pc_sp_registers(machine)) {
+        auto [pc, sp] = *regs;
+        size_t pc_offset = layout.prstatus_regs + pc * r.word_size;
+        size_t sp_offset = layout.prstatus_regs + sp * r.word_size;
+
+        if (r.has(pc_offset, r.word_size)) {
+            thread.pc = r.word(pc_offset);
+        }
+        if (r.has(sp_offset, r.word_size)) {
+            thread.sp = r.word(sp_offset);
+        }
+    }
+
+    core.threads.push_back(thread);
+}
+
+template<class Reader>
+void parse_prpsinfo(CoreInfo& core, const Reader& r, const CoreLayout& layout) {
+    core.process_name = r.c_string(layout.prpsinfo_fname, PRPSINFO_FNAME_LEN);
+    core.process_args = r.c_string(layout.prpsinfo_args, PRPSINFO_ARGS_LEN);
+}
+
+template<class Reader>
+void parse_auxv(CoreInfo& core, const Reader& r) {
+    for (size_t pos = 0; r.has(pos, 2 * r.word_size); pos += 2 * r.word_size) {
+        auto type = r.word(pos);
+        if (type == 0) {
+            break;
+        }
+        core.auxv.emplace_back(type, r.word(pos + r.word_size));
+    }
+}
+
+template<class Reader>
+void parse_siginfo(CoreInfo& core, const Reader& r, const CoreLayout& layout) {
+    if (!r.has(0, 12)) {
+        return;
+    }
+
+    // si_signo, si_errno, si_code in that order
+    CoreSigInfo info{
+        static_cast<int32_t>(r.read(0, 4)),
+        static_cast<int32_t>(r.read(8, 4)),
+        static_cast<int32_t>(r.read(4, 4)),
+        std::nullopt,
+    };
+
+    if (signal_has_addr(info.signo) && r.has(layout.siginfo_addr, r.word_size)) {
+        info.addr = r.word(layout.siginfo_addr);
+    }
+
+    core.siginfo = info;
+}
+
+// count, page size, count * (start, end, offset in pages), then count NUL-terminated paths
+template<class Reader>
+void parse_file_note(CoreInfo& core, const Reader& r) {
+    if (!r.has(0, 2 * r.word_size)) {
+        return;
+    }
+
+    size_t count = r.word(0);
+    core.page_size = r.word(r.word_size);
+
+    // count is checked before it's multiplied, so a huge one can't wrap around
+    size_t entries = 2 * r.word_size;
+    if (count > (r.desc.size() - entries) / (3 * r.word_size)) {
+        return;
+    }
+    size_t names = entries + count * 3 * r.word_size;
+
+    size_t name_pos = names;
+    for (size_t i = 0; i < count; ++i) {
+        size_t entry = entries + i * 3 * r.word_size;
+        auto path = r.c_string(name_pos, r.desc.size());
+        name_pos += path.size() + 1;
+
+        core.mappings.push_back(CoreMapping{
+            r.word(entry),
+            r.word(entry + r.word_size),
+            r.word(entry + 2 * r.word_size) * core.page_size,
+            path,
+        });
+    }
+}
+
+void collect_segments(CoreInfo& core, const ParsedElf& elf) {
+    std::optional<SparseProbe> probe;
+    int fd = -1;
+
+    // streamed files already hold a descriptor; mapped ones get a fresh one
+    if (elf.source != nullptr) {
+        fd = elf.source->fd;
+    } else {
+        try {
+            probe = SparseProbe::open(elf.filename);
+            fd = probe->fd;
+        } catch (const std::runtime_error&) {
+            // parsed from a buffer that isn't a file on disk
+        }
+    }
+
+    for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+        const auto& phdr = elf.phdrs[i];
+        if (phdr.ptype != PT_LOAD) {
+            continue;
+        }
+
+        auto [start, end] = elf.file_range(phdr.file_offset, phdr.file_size);
+        uint64_t data = (fd >= 0) ? data_bytes_in(fd, start, end) : end - start;
+
+        core.segments.push_back(CoreSegment{i, phdr.vaddr, phdr.memsz, phdr.file_offset, phdr.file_size, data});
+    }
+}
+
+// the CORE notes, in the byte order visit_elf picked
+template<bool big_endian>
+void parse_core_notes(CoreInfo& core, const ParsedElf& elf) {
+    const auto& layout = (elf.ident.class_ == ELF_CLASS32) ? CORE_LAYOUT_32 : CORE_LAYOUT_64;
+    size_t word_size = (elf.ident.class_ == ELF_CLASS32) ? 4 : 8;
+
+    for (const auto& note : elf.notes()) {
+        // names include the terminating NUL; "LINUX" notes hold register sets we don't decode
+        if (note.name.size() < 4 || std::memcmp(note.name.data(), "CORE", 4) != 0) {
+            continue;
+        }
+
+        DescReader<big_endian> r{note.desc, word_size};
+
+        switch (note.ntype) {
+            case NT_PRSTATUS:
+                parse_prstatus(core, r, layout, elf.machine);
+                break;
+            case NT_PRPSINFO:
+                parse_prpsinfo(core, r, layout);
+                break;
+            case NT_AUXV:
+                parse_auxv(core, r);
+                break;
+            case NT_SIGINFO:
+                parse_siginfo(core, r, layout);
+                break;
+            case NT_FILE:
+                parse_file_note(core, r);
+                break;
+        }
+    }
+}
+
+}
+
+
+CoreInfo parse_core(const ParsedElf& elf) {
+    STATS_PHASE(phase, "core");
+
+    CoreInfo core;
+
+    visit_elf(elf.ident, [&](auto layout) {
+        parse_core_notes<decltype(layout)::big_endian>(core, elf);
+    });
+
+    collect_segments(core, elf);
+
+    return core;
+}
+
+constexpr ValueName AUXV_NAMES[] = {
+    {3, "AT_PHDR"},
+    {4, "AT_PHENT"},
+    {5, "AT_PHNUM"},
+    {6, "AT_PAGESZ"},
+    {7, "AT_BASE"},
+    {8, "AT_FLAGS"},
+    {9, "AT_ENTRY"},
+    {11, "AT_UID"},
+    {12, "AT_EUID"},
+    {13, "AT_GID"},
+    {14, "AT_EGID"},
+    {15, "AT_PLATFORM"},
+    {16, "AT_HWCAP"},
+    {17, "AT_CLKTCK"},
+    {23, "AT_SECURE"},
+    {24, "AT_BASE_PLATFORM"},
+    {25, "AT_RANDOM"},
+    {26, "AT_HWCAP2"},
+    {31, "AT_EXECFN"},
+    {33, "AT_SYSINFO_EHDR"},
+    {51, "AT_MINSIGSTKSZ"},
+};
+
+constexpr ValueName SIGNAL_NAMES[] = {
+    {1, "SIGHUP"},
+    {2, "SIGINT"},
+    {3, "SIGQUIT"},
+    {4, "SIGILL"},
+    {5, "SIGTRAP"},
+    {6, "SIGABRT"},
+    {7, "SIGBUS"},
+    {8, "SIGFPE"},
+    {9, "SIGKILL"},
+    {10, "SIGUSR1"},
+    {11, "SIGSEGV"},
+    {12, "SIGUSR2"},
+    {13, "SIGPIPE"},
+    {14, "SIGALRM"},
+    {15, "SIGTERM"},
+    {24, "SIGXCPU"},
+    {25, "SIGXFSZ"},
+    {31, "SIGSYS"},
+};
+
+static_assert(sorted_by_value(AUXV_NAMES) && sorted_by_value(SIGNAL_NAMES), "lookup_name needs tables sorted by value");
+
+std::string auxv_type_to_string(uint64_t type) {
+    auto name = lookup_name(AUXV_NAMES, type);
+    if (name.empty()) {
+        return "Unknown " + std::to_string(type);
+    }
+    return std::string(name);
+}
+
+std::string signal_to_string(int32_t signo) {
+    auto name = lookup_name(SIGNAL_NAMES, static_cast<uint32_t>(signo));
+    if (name.empty()) {
+        return std::to_string(signo);
+    }
+    return std::string(name);
+}
@@ -0,0 +1,271 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <hash.hpp>
+#include <mapped_file.hpp>
+#include <stats.hpp>
+
+#include "include/build_id_index.hpp"
+#include "include/debug_link.hpp"
+#include "include/defs.hpp"
+#include "include/elfxx.hpp"
+#include "include/parser.hpp"
+
+
+namespace {
+
+constexpr char CACHE_HEADER[] = "elfcat debug-files 1";
+constexpr char DEFAULT_DEBUG_ROOT[] = "/usr/lib/debug";
+
+
+std::optional<std::tuple<uint64_t, int64_t>> file_stamp(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return std::nullopt;
+    }
+    return std::make_tuple(static_cast<uint64_t>(st.st_size),
+            static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec);
+}
+
+std::string to_hex(const std::vector<uint8_t>& bytes) {
+    std::string hex;
+    for (auto byte : bytes) {
+        hex += "0123456789abcdef"[byte >> 4];
+        hex += "0123456789abcdef"[byte & 0xf];
+    }
+    return hex;
+}
+
+std::string directory_of(const std::string& path) {
+    std::unique_ptr<char, decltype(&std::free)> resolved(realpath(path.c_str(), nullptr), &std::free);
+    std::string absolute = resolved ? resolved.get() : path;
+    auto slash = absolute.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : absolute.substr(0, slash);
+}
+
+std::string join(const std::string& directory, const std::string& name) {
+    if (!directory.empty() && directory.back() == '/') {
+        return directory + name;
+    }
+    return directory + "/" + name;
+}
+
+}
+
+
+std::optional<DebugLink> find_debug_link(const ParsedElf& elf) {
+    for (const auto& shdr : elf.shdrs) {
+        if (shdr.shtype != SHT_PROGBITS || elf.shnstrtab().get(shdr.name) != ".gnu_debuglink") {
+            continue;
+        }
+        if (shdr.file_offset > elf.file_size || elf.file_size - shdr.file_offset < shdr.size) {
+            return std::nullopt;
+        }
+
+        // the file name, NUL padded to 4 bytes, then the CRC in the file's byte order
+        auto contents = elf.read_bytes(shdr.file_offset, shdr.file_offset + shdr.size);
+        if (contents.empty()) {
+            return std::nullopt;
+        }
+        auto nul = static_cast<const uint8_t*>(std::memchr(contents.data(), 0, contents.size()));
+        if (nul == nullptr) {
+            return std::nullopt;
+        }
+        size_t name_size = nul - contents.data();
+        auto crc_offset = (name_size + 4) & ~size_t(3);
+        if (name_size == 0 || crc_offset + 4 > contents.size()) {
+            return std::nullopt;
+        }
+
+        auto crc = visit_elf(elf.ident, [&](auto layout) {
+            return load_bytes<uint32_t, decltype(layout)::big_endian>(contents.data() + crc_offset);
+        });
+        return DebugLink{std::string(reinterpret_cast<const char*>(contents.data()), name_size), crc};
+    }
+    return std::nullopt;
+}
+
+std::string DebugFileCache::default_path() {
+    if (const char* cache_home = std::getenv("XDG_CACHE_HOME"); cache_home && *cache_home) {
+        return join(cache_home, "elfcat/debug-files");
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return join(home, ".cache/elfcat/debug-files");
+    }
+    return {};
+}
+
+// one line per file: size, mtime, crc or "-", build-id or "-" / "none", path
+DebugFileCache DebugFileCache::load(const std::string& path) {
+    DebugFileCache cache;
+    cache.path = path;
+
+    std::ifstream input(path);
+    std::string line;
+    if (!std::getline(input, line) || line != CACHE_HEADER) {
+        return cache;
+    }
+
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        std::string crc, build_id, file;
+
+        if (!(fields >> entry.size >> entry.mtime_ns >> crc >> build_id) || fields.get() != '\t' || !std::getline(fields, file)) {
+            continue;
+        }
+        if (crc != "-") {
+            entry.crc = static_cast<uint32_t>(std::strtoul(crc.c_str(), nullptr, 16));
+        }
+        if (build_id == "none") {
+            entry.build_id.emplace();
+        } else if (build_id != "-") {
+            entry.build_id = parse_build_id(build_id);
+        }
+        cache.entries[file] = entry;
+    }
+
+    return cache;
+}
+
+void DebugFileCache::save() const {
+    if (!dirty || path.empty()) {
+        return;
+    }
+
+    auto slash = path.rfind('/');
+    if (slash != std::string::npos && slash != 0) {
+        make_directories(path.substr(0, slash));
+    }
+
+    // unique per process, so elfcats saving at the same time don't write into one file
+    auto temporary = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::trunc);
+        output << CACHE_HEADER << '\n';
+        for (const auto& [file, entry] : entries) {
+            if (file.find('\n') != std::string::npos) {
+                continue;
+            }
+            char crc[9] = "-";
+            if (entry.crc) {
+                std::snprintf(crc, sizeof(crc), "%08x", *entry.crc);
+            }
+            output << entry.size << '\t' << entry.mtime_ns << '\t' << crc << '\t';
+            output << (!entry.build_id ? "-" : entry.build_id->empty() ? "none" : to_hex(*entry.build_id));
+            output << '\t' << file << '\n';
+        }
+        if (!output) {
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+DebugFileCache::Entry* DebugFileCache::entry(const std::string& file) {
+    auto stamp = file_stamp(file);
+    if (!stamp) {
+        return nullptr;
+    }
+
+    auto& [size, mtime_ns] = *stamp;
+    auto& cached = entries[file];
+    if (cached.size != size || cached.mtime_ns != mtime_ns) {
+        cached = Entry{size, mtime_ns, std::nullopt, std::nullopt};
+        dirty = true;
+    }
+    return &cached;
+}
+
+std::optional<uint32_t> DebugFileCache::crc(const std::string& file) {
+    auto cached = entry(file);
+    if (cached == nullptr) {
+        return std::nullopt;
+    }
+
+    if (!cached->crc) {
+        STATS_PHASE(phase, "debuglink_crc");
+        try {
+            cached->crc = crc32(MappedFile::open(file).view());
+            dirty = true;
+        } catch (const std::runtime_error&) {
+            return std::nullopt;
+        }
+    }
+    return cached->crc;
+}
+
+std::optional<std::vector<uint8_t>> DebugFileCache::build_id(const std::string& file) {
+    auto cached = entry(file);
+    if (cached == nullptr) {
+        return std::nullopt;
+    }
+
+    if (!cached->build_id) {
+        try {
+            auto mapped = MappedFile::open(file);
+            auto elf = ParsedElf::from_bytes(file, mapped.view());
+            cached->build_id = find_build_id(elf).value_or(std::vector<uint8_t>());
+        } catch (const std::runtime_error&) {
+            cached->build_id.emplace();
+        }
+        dirty = true;
+    }
+    return cached->build_id;
+}
+
+std::optional<std::string> DebugResolver::resolve(const ParsedElf& elf) {
+    STATS_PHASE(phase, "debug_file");
+
+    auto search_roots = roots;
+    search_roots.push_back(DEFAULT_DEBUG_ROOT);
+
+    if (auto build_id = find_build_id(elf); build_id && build_id->size() >= 2) {
+        auto hex = to_hex(*build_id);
+        auto relative = ".build-id/" + hex.substr(0, 2) + "/" + hex.substr(2) + ".debug";
+        for (const auto& root : search_roots) {
+            auto candidate = join(root, relative);
+            if (cache.build_id(candidate) == build_id) {
+                return candidate;
+            }
+        }
+    }
+
+    if (auto link = find_debug_link(elf)) {
+        auto directory = directory_of(elf.filename);
+        std::vector<std::string> candidates = {
+            join(directory, link->filename),
+            join(join(directory, ".debug"), link->filename),
+        };
+        for (const auto& root : search_roots) {
+            candidates.push_back(join(root, join(directory.substr(1), link->filename)));
+        }
+
+        std::unique_ptr<char, decltype(&std::free)> self(realpath(elf.filename.c_str(), nullptr), &std::free);
+        for (const auto& candidate : candidates) {
+            std::unique_ptr<char, decltype(&std::free)> resolved(realpath(candidate.c_str(), nullptr), &std::free);
+            // a binary may link to a debug file of its own name in the same directory
+            if (!resolved || (self && std::strcmp(resolved.get(), self.get()) == 0)) {
+                continue;
+            }
+            if (cache.crc(candidate) == link->crc) {
+                return candidate;
+            }
+        }
+    }
+
+    return std::nullopt;
+}
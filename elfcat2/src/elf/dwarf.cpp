@@ -0,0 +1,513 @@
+#include <map>
+#include <optional>
+
+#include <stats.hpp>
+
+#include "include/defs.hpp"
+#include "include/dwarf.hpp"
+#include "include/elfxx.hpp"
+#include "include/parser.hpp"
+
+
+namespace {
+
+constexpr uint64_t DW_AT_name = 0x03;
+constexpr uint64_t DW_AT_low_pc = 0x11;
+constexpr uint64_t DW_AT_high_pc = 0x12;
+constexpr uint64_t DW_AT_str_offsets_base = 0x72;
+constexpr uint64_t DW_AT_addr_base = 0x73;
+
+constexpr uint64_t DW_FORM_addr = 0x01;
+constexpr uint64_t DW_FORM_block2 = 0x03;
+constexpr uint64_t DW_FORM_block4 = 0x04;
+constexpr uint64_t DW_FORM_data2 = 0x05;
+constexpr uint64_t DW_FORM_data4 = 0x06;
+constexpr uint64_t DW_FORM_data8 = 0x07;
+constexpr uint64_t DW_FORM_string = 0x08;
+constexpr uint64_t DW_FORM_block = 0x09;
+constexpr uint64_t DW_FORM_block1 = 0x0a;
+constexpr uint64_t DW_FORM_data1 = 0x0b;
+constexpr uint64_t DW_FORM_flag = 0x0c;
+constexpr uint64_t DW_FORM_sdata = 0x0d;
+constexpr uint64_t DW_FORM_strp = 0x0e;
+constexpr uint64_t DW_FORM_udata = 0x0f;
+constexpr uint64_t DW_FORM_ref_addr = 0x10;
+constexpr uint64_t DW_FORM_ref1 = 0x11;
+constexpr uint64_t DW_FORM_ref2 = 0x12;
+constexpr uint64_t DW_FORM_ref4 = 0x13;
+constexpr uint64_t DW_FORM_ref8 = 0x14;
+constexpr uint64_t DW_FORM_ref_udata = 0x15;
+constexpr uint64_t DW_FORM_indirect = 0x16;
+constexpr uint64_t DW_FORM_sec_offset = 0x17;
+constexpr uint64_t DW_FORM_exprloc = 0x18;
+constexpr uint64_t DW_FORM_flag_present = 0x19;
+constexpr uint64_t DW_FORM_strx = 0x1a;
+constexpr uint64_t DW_FORM_addrx = 0x1b;
+constexpr uint64_t DW_FORM_ref_sup4 = 0x1c;
+constexpr uint64_t DW_FORM_strp_sup = 0x1d;
+constexpr uint64_t DW_FORM_data16 = 0x1e;
+constexpr uint64_t DW_FORM_line_strp = 0x1f;
+constexpr uint64_t DW_FORM_ref_sig8 = 0x20;
+constexpr uint64_t DW_FORM_implicit_const = 0x21;
+constexpr uint64_t DW_FORM_loclistx = 0x22;
+constexpr uint64_t DW_FORM_rnglistx = 0x23;
+constexpr uint64_t DW_FORM_ref_sup8 = 0x24;
+constexpr uint64_t DW_FORM_strx1 = 0x25;
+constexpr uint64_t DW_FORM_strx2 = 0x26;
+constexpr uint64_t DW_FORM_strx3 = 0x27;
+constexpr uint64_t DW_FORM_strx4 = 0x28;
+constexpr uint64_t DW_FORM_addrx1 = 0x29;
+constexpr uint64_t DW_FORM_addrx2 = 0x2a;
+constexpr uint64_t DW_FORM_addrx3 = 0x2b;
+constexpr uint64_t DW_FORM_addrx4 = 0x2c;
+constexpr uint64_t DW_FORM_GNU_ref_alt = 0x1f20;
+constexpr uint64_t DW_FORM_GNU_strp_alt = 0x1f21;
+
+constexpr uint8_t DW_UT_compile = 0x01;
+constexpr uint8_t DW_UT_partial = 0x03;
+
+
+// sequential reader over one debug section. Reading past the end sets failed,
+// which sticks; reads then return 0 (or what they got so far) and callers check
+// failed once after a group of reads instead of after each one. The byte order is
+// a template parameter, picked once per file through visit_elf
+template<bool big_endian>
+struct DwarfReader {
+    bool need(size_t size) {
+        if (failed || pos > bytes.size() || bytes.size() - pos < size) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t fixed(size_t size) {
+        if (!need(size)) {
+            return 0;
+        }
+        const uint8_t* p = bytes.data() + pos;
+        pos += size;
+        switch (size) {
+            case 1: return *p;
+            case 2: return load_bytes<uint16_t, big_endian>(p);
+            case 4: return load_bytes<uint32_t, big_endian>(p);
+            case 8: return load_bytes<uint64_t, big_endian>(p);
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            value = (value << 8) | p[big_endian ? i : size - 1 - i];
+        }
+        return value;
+    }
+
+    uint64_t uleb() {
+        uint64_t value = 0;
+        for (uint32_t shift = 0;; shift += 7) {
+            if (!need(1)) {
+                return 0;
+            }
+            uint8_t byte = bytes[pos++];
+            if (shift < 64) {
+                value |= uint64_t(byte & 0x7f) << shift;
+            }
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+    }
+
+    std::string c_string() {
+        std::string result;
+        while (need(1)) {
+            char ch = static_cast<char>(bytes[pos++]);
+            if (ch == 0) {
+                break;
+            }
+            result += ch;
+        }
+        return result;
+    }
+
+    void skip(size_t size) {
+        if (need(size)) {
+            pos += size;
+        }
+    }
+
+    ByteView bytes;
+    size_t pos = 0;
+    bool failed = false;
+};
+
+
+struct DebugSections {
+    ByteView get(const std::string& name) const {
+        auto found = views.find(name);
+        return (found == views.end()) ? ByteView() : found->second;
+    }
+
+    std::map<std::string, ByteView> views;
+    // backing storage in streaming mode
+    std::map<std::string, std::vector<uint8_t>> scratch;
+};
+
+DebugSections load_debug_sections(const ParsedElf& elf) {
+    static const char* wanted[] = {
+        ".debug_info", ".debug_abbrev", ".debug_aranges", ".debug_str",
+        ".debug_line_str", ".debug_str_offsets", ".debug_addr",
+    };
+
+    DebugSections sections;
+
+    for (const auto& shdr : elf.shdrs) {
+        if (shdr.shtype == SHT_NOBITS || shdr.file_offset > elf.file_size || elf.file_size - shdr.file_offset < shdr.size) {
+            continue;
+        }
+
+        auto name = elf.shnstrtab().get(shdr.name);
+        for (auto candidate : wanted) {
+            if (name != candidate) {
+                continue;
+            }
+            if (shdr.flags & SHF_COMPRESSED) {
+                return {};
+            }
+            sections.views[name] = elf.bytes(shdr.file_offset, shdr.file_offset + shdr.size, sections.scratch[name]);
+        }
+    }
+
+    return sections;
+}
+
+// unit_length, switching to 64-bit offsets on the 0xffffffff escape
+template<class Reader>
+std::tuple<uint64_t, size_t> read_unit_length(Reader& r) {
+    uint64_t length = r.fixed(4);
+    if (length == 0xffffffff) {
+        return {r.fixed(8), 8};
+    }
+    return {length, 4};
+}
+
+template<bool big_endian>
+std::map<uint64_t, std::vector<std::tuple<uint64_t, uint64_t>>> parse_aranges(ByteView aranges) {
+    std::map<uint64_t, std::vector<std::tuple<uint64_t, uint64_t>>> result;
+    DwarfReader<big_endian> r{aranges};
+
+    while (r.pos < aranges.size()) {
+        size_t set_start = r.pos;
+        auto [length, offset_size] = read_unit_length(r);
+        if (r.failed || length > aranges.size() - r.pos) {
+            break;
+        }
+
+        size_t set_end = r.pos + length;
+
+        r.fixed(2);
+        uint64_t info_offset = r.fixed(offset_size);
+        size_t addr_size = r.fixed(1);
+        size_t segment_size = r.fixed(1);
+
+        size_t tuple_size = 2 * addr_size + segment_size;
+        if (!r.failed && addr_size != 0 && tuple_size != 0) {
+            // tuples are aligned to their size from the start of the set
+            size_t misalignment = (r.pos - set_start) % tuple_size;
+            if (misalignment != 0) {
+                r.skip(tuple_size - misalignment);
+            }
+
+            // a set cut short keeps the tuples decoded before the cut
+            while (!r.failed && r.pos + tuple_size <= set_end) {
+                r.skip(segment_size);
+                uint64_t start = r.fixed(addr_size);
+                uint64_t size = r.fixed(addr_size);
+                if (r.failed || (start == 0 && size == 0)) {
+                    break;
+                }
+                result[info_offset].emplace_back(start, start + size);
+            }
+        }
+
+        r = DwarfReader<big_endian>{aranges, set_end};
+    }
+
+    return result;
+}
+
+struct RootDie {
+    std::optional<std::string> name;
+    std::optional<uint64_t> name_strx;
+    std::optional<uint64_t> low_pc;
+    std::optional<uint64_t> low_pc_addrx;
+    std::optional<uint64_t> high_pc;
+    bool high_pc_is_offset = false;
+    uint64_t str_offsets_base = 0;
+    uint64_t addr_base = 0;
+};
+
+struct UnitContext {
+    const DebugSections& sections;
+    uint16_t version;
+    size_t offset_size;
+    size_t addr_size;
+};
+
+std::string string_at(ByteView section, uint64_t offset) {
+    std::string result;
+    for (size_t i = offset; i < section.size() && section[i] != 0; ++i) {
+        result += static_cast<char>(section[i]);
+    }
+    return result;
+}
+
+template<bool big_endian>
+std::optional<uint64_t> word_at(ByteView section, uint64_t offset, size_t size) {
+    DwarfReader<big_endian> r{section, offset};
+    auto value = r.fixed(size);
+    return r.failed ? std::nullopt : std::optional<uint64_t>(value);
+}
+
+// reads or skips one attribute value, keeping the ones RootDie cares about; false
+// for forms whose size isn't known, after which the rest of the DIE can't be found
+template<class Reader>
+bool read_attribute(Reader& r, const UnitContext& unit, uint64_t attribute, uint64_t form, int64_t implicit, RootDie& die) {
+    auto store_name = [&](std::string value) {
+        if (attribute == DW_AT_name) {
+            die.name = std::move(value);
+        }
+    };
+    auto store_constant = [&](uint64_t value) {
+        if (attribute == DW_AT_high_pc) {
+            die.high_pc = value;
+            die.high_pc_is_offset = true;
+        } else if (attribute == DW_AT_str_offsets_base) {
+            die.str_offsets_base = value;
+        } else if (attribute == DW_AT_addr_base) {
+            die.addr_base = value;
+        }
+    };
+    auto store_strx = [&](uint64_t index) {
+        if (attribute == DW_AT_name) {
+            die.name_strx = index;
+        }
+    };
+    auto store_addrx = [&](uint64_t index) {
+        if (attribute == DW_AT_low_pc) {
+            die.low_pc_addrx = index;
+        }
+    };
+
+    switch (form) {
+        case DW_FORM_addr: {
+            uint64_t value = r.fixed(unit.addr_size);
+            if (attribute == DW_AT_low_pc) {
+                die.low_pc = value;
+            } else if (attribute == DW_AT_high_pc) {
+                die.high_pc = value;
+            }
+            break;
+        }
+        case DW_FORM_data1: store_constant(r.fixed(1)); break;
+        case DW_FORM_data2: store_constant(r.fixed(2)); break;
+        case DW_FORM_data4: store_constant(r.fixed(4)); break;
+        case DW_FORM_data8: store_constant(r.fixed(8)); break;
+        case DW_FORM_udata: store_constant(r.uleb()); break;
+        case DW_FORM_sec_offset: store_constant(r.fixed(unit.offset_size)); break;
+        case DW_FORM_implicit_const: store_constant(static_cast<uint64_t>(implicit)); break;
+        case DW_FORM_sdata: r.uleb(); break;
+        case DW_FORM_string: store_name(r.c_string()); break;
+        case DW_FORM_strp: store_name(string_at(unit.sections.get(".debug_str"), r.fixed(unit.offset_size))); break;
+        case DW_FORM_line_strp: store_name(string_at(unit.sections.get(".debug_line_str"), r.fixed(unit.offset_size))); break;
+        case DW_FORM_strx: store_strx(r.uleb()); break;
+        case DW_FORM_strx1: store_strx(r.fixed(1)); break;
+        case DW_FORM_strx2: store_strx(r.fixed(2)); break;
+        case DW_FORM_strx3: store_strx(r.fixed(3)); break;
+        case DW_FORM_strx4: store_strx(r.fixed(4)); break;
+        case DW_FORM_addrx: store_addrx(r.uleb()); break;
+        case DW_FORM_addrx1: store_addrx(r.fixed(1)); break;
+        case DW_FORM_addrx2: store_addrx(r.fixed(2)); break;
+        case DW_FORM_addrx3: store_addrx(r.fixed(3)); break;
+        case DW_FORM_addrx4: store_addrx(r.fixed(4)); break;
+        case DW_FORM_flag:
+        case DW_FORM_ref1: r.skip(1); break;
+        case DW_FORM_ref2: r.skip(2); break;
+        case DW_FORM_ref4:
+        case DW_FORM_ref_sup4: r.skip(4); break;
+        case DW_FORM_ref8:
+        case DW_FORM_ref_sig8:
+        case DW_FORM_ref_sup8: r.skip(8); break;
+        case DW_FORM_data16: r.skip(16); break;
+        case DW_FORM_ref_udata:
+        case DW_FORM_loclistx:
+        case DW_FORM_rnglistx: r.uleb(); break;
+        case DW_FORM_ref_addr: r.skip(unit.version <= 2 ? unit.addr_size : unit.offset_size); break;
+        case DW_FORM_strp_sup:
+        case DW_FORM_GNU_ref_alt:
+        case DW_FORM_GNU_strp_alt: r.skip(unit.offset_size); break;
+        case DW_FORM_flag_present: break;
+        case DW_FORM_block1: r.skip(r.fixed(1)); break;
+        case DW_FORM_block2: r.skip(r.fixed(2)); break;
+        case DW_FORM_block4: r.skip(r.fixed(4)); break;
+        case DW_FORM_block:
+        case DW_FORM_exprloc: r.skip(r.uleb()); break;
+        case DW_FORM_indirect: {
+            // one level is all producers use; a chain of them would recurse once per byte
+            auto actual = r.uleb();
+            return actual != DW_FORM_indirect && read_attribute(r, unit, attribute, actual, implicit, die);
+        }
+        default:
+            return false;
+    }
+    return true;
+}
+
+// (attribute, form, implicit const) list of abbreviation code in the table at offset
+template<bool big_endian>
+std::optional<std::vector<std::tuple<uint64_t, uint64_t, int64_t>>> find_abbrev(ByteView abbrevs, uint64_t offset, uint64_t code) {
+    DwarfReader<big_endian> r{abbrevs, offset};
+
+    for (;;) {
+        uint64_t entry_code = r.uleb();
+        if (r.failed || entry_code == 0) {
+            return std::nullopt;
+        }
+
+        r.uleb();
+        r.fixed(1);
+
+        std::vector<std::tuple<uint64_t, uint64_t, int64_t>> attributes;
+        for (;;) {
+            uint64_t attribute = r.uleb();
+            uint64_t form = r.uleb();
+            if (r.failed) {
+                return std::nullopt;
+            }
+            if (attribute == 0 && form == 0) {
+                break;
+            }
+            int64_t implicit = (form == DW_FORM_implicit_const) ? static_cast<int64_t>(r.uleb()) : 0;
+            attributes.emplace_back(attribute, form, implicit);
+        }
+
+        if (entry_code == code) {
+            return attributes;
+        }
+    }
+}
+
+// the root DIE of the unit whose header r is at, just past unit_length, with
+// indexed names and addresses resolved; nullopt for type units and split
+// skeletons, which don't describe code of their own, and for malformed units
+template<bool big_endian>
+std::optional<RootDie> read_root_die(DwarfReader<big_endian>& r, const DebugSections& sections, size_t offset_size) {
+    uint16_t version = r.fixed(2);
+    uint8_t unit_type = DW_UT_compile;
+    uint64_t abbrev_offset;
+    size_t addr_size;
+
+    if (version >= 5) {
+        unit_type = r.fixed(1);
+        addr_size = r.fixed(1);
+        abbrev_offset = r.fixed(offset_size);
+    } else {
+        abbrev_offset = r.fixed(offset_size);
+        addr_size = r.fixed(1);
+    }
+
+    if (unit_type != DW_UT_compile && unit_type != DW_UT_partial) {
+        return std::nullopt;
+    }
+
+    UnitContext unit{sections, version, offset_size, addr_size};
+    RootDie die;
+
+    uint64_t code = r.uleb();
+    auto attributes = r.failed ? std::nullopt : find_abbrev<big_endian>(sections.get(".debug_abbrev"), abbrev_offset, code);
+    if (!attributes) {
+        return std::nullopt;
+    }
+    for (const auto& [attribute, form, implicit] : *attributes) {
+        if (!read_attribute(r, unit, attribute, form, implicit, die)) {
+            return std::nullopt;
+        }
+    }
+    if (r.failed) {
+        return std::nullopt;
+    }
+
+    if (!die.name && die.name_strx) {
+        auto offsets = sections.get(".debug_str_offsets");
+        auto entry = word_at<big_endian>(offsets, die.str_offsets_base + *die.name_strx * offset_size, offset_size);
+        if (!entry) {
+            return std::nullopt;
+        }
+        die.name = string_at(sections.get(".debug_str"), *entry);
+    }
+    if (!die.low_pc && die.low_pc_addrx) {
+        die.low_pc = word_at<big_endian>(sections.get(".debug_addr"), die.addr_base + *die.low_pc_addrx * addr_size, addr_size);
+        if (!die.low_pc) {
+            return std::nullopt;
+        }
+    }
+
+    return die;
+}
+
+template<bool big_endian>
+std::vector<CompileUnitRange> compile_unit_ranges(const DebugSections& sections) {
+    auto info = sections.get(".debug_info");
+    auto aranges = parse_aranges<big_endian>(sections.get(".debug_aranges"));
+
+    std::vector<CompileUnitRange> result;
+    DwarfReader<big_endian> r{info};
+
+    while (r.pos < info.size()) {
+        size_t unit_offset = r.pos;
+        auto [length, offset_size] = read_unit_length(r);
+        if (r.failed || length > info.size() - r.pos) {
+            break;
+        }
+
+        size_t unit_end = r.pos + length;
+
+        // a malformed unit is skipped, the next one may still be fine
+        if (auto die = read_root_die(r, sections, offset_size)) {
+            auto name = die->name ? *die->name : "[unnamed unit @ " + std::to_string(unit_offset) + "]";
+
+            auto found = aranges.find(unit_offset);
+            if (found != aranges.end()) {
+                for (auto [start, end] : found->second) {
+                    result.push_back({start, end, name});
+                }
+            } else if (die->low_pc && die->high_pc) {
+                uint64_t end = die->high_pc_is_offset ? *die->low_pc + *die->high_pc : *die->high_pc;
+                if (end > *die->low_pc) {
+                    result.push_back({*die->low_pc, end, name});
+                }
+            }
+        }
+
+        r = DwarfReader<big_endian>{info, unit_end};
+    }
+
+    return result;
+}
+
+}
+
+
+std::vector<CompileUnitRange> parse_compile_unit_ranges(const ParsedElf& elf) {
+    STATS_PHASE(phase, "dwarf");
+
+    auto sections = load_debug_sections(elf);
+
+    if (sections.get(".debug_info").empty() || sections.get(".debug_abbrev").empty()) {
+        return elf.debug_file ? parse_compile_unit_ranges(*elf.debug_file) : std::vector<CompileUnitRange>();
+    }
+
+    std::vector<CompileUnitRange> result;
+    visit_elf(elf.ident, [&](auto layout) {
+        result = compile_unit_ranges<decltype(layout)::big_endian>(sections);
+    });
+    return result;
+}
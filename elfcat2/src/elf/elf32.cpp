@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "include/elf32.hpp"
 
 
@@ -5,131 +7,96 @@ std::string Elf32Ehdr::describe() {
     return "file header";
 }
 
-Elf32Ehdr Elf32Ehdr::from_le_bytes(const std::vector<uint8_t>& buf) {
-    return {
-        to_array<16>(byte_range(buf, 0, 16)),
-        Elf32Half::from_le_bytes(byte_range(buf, 16, 18)),
-        Elf32Half::from_le_bytes(byte_range(buf, 18, 20)),
-        Elf32Word::from_le_bytes(byte_range(buf, 20, 24)),
-        Elf32Addr::from_le_bytes(byte_range(buf, 24, 28)),
-        Elf32Off:: from_le_bytes(byte_range(buf, 28, 32)),
-        Elf32Off:: from_le_bytes(byte_range(buf, 32, 36)),
-        Elf32Word::from_le_bytes(byte_range(buf, 36, 40)),
-        Elf32Half::from_le_bytes(byte_range(buf, 40, 42)),
-        Elf32Half::from_le_bytes(byte_range(buf, 42, 44)),
-        Elf32Half::from_le_bytes(byte_range(buf, 44, 46)),
-        Elf32Half::from_le_bytes(byte_range(buf, 46, 48)),
-        Elf32Half::from_le_bytes(byte_range(buf, 48, 50)),
-        Elf32Half::from_le_bytes(byte_range(buf, 50, 52)),
-    };
-}
-
-Elf32Ehdr Elf32Ehdr::from_be_bytes(const std::vector<uint8_t>& buf) {
-    return Elf32Ehdr{
-        to_array<16>(byte_range(buf, 0, 16)),
-        Elf32Half::from_be_bytes(byte_range(buf, 16, 18)),
-        Elf32Half::from_be_bytes(byte_range(buf, 18, 20)),
-        Elf32Word::from_be_bytes(byte_range(buf, 20, 24)),
-        Elf32Addr::from_be_bytes(byte_range(buf, 24, 28)),
-        Elf32Off:: from_be_bytes(byte_range(buf, 28, 32)),
-        Elf32Off:: from_be_bytes(byte_range(buf, 32, 36)),
-        Elf32Word::from_be_bytes(byte_range(buf, 36, 40)),
-        Elf32Half::from_be_bytes(byte_range(buf, 40, 42)),
-        Elf32Half::from_be_bytes(byte_range(buf, 42, 44)),
-        Elf32Half::from_be_bytes(byte_range(buf, 44, 46)),
-        Elf32Half::from_be_bytes(byte_range(buf, 46, 48)),
-        Elf32Half::from_be_bytes(byte_range(buf, 48, 50)),
-        Elf32Half::from_be_bytes(byte_range(buf, 50, 52)),
+template<bool big_endian>
+Elf32Ehdr Elf32Ehdr::read(const uint8_t* p) {
+    Elf32Ehdr ehdr{
+        {},
+        Elf32Half::read<big_endian>(p + 16),
+        Elf32Half::read<big_endian>(p + 18),
+        Elf32Word::read<big_endian>(p + 20),
+        Elf32Addr::read<big_endian>(p + 24),
+        Elf32Off:: read<big_endian>(p + 28),
+        Elf32Off:: read<big_endian>(p + 32),
+        Elf32Word::read<big_endian>(p + 36),
+        Elf32Half::read<big_endian>(p + 40),
+        Elf32Half::read<big_endian>(p + 42),
+        Elf32Half::read<big_endian>(p + 44),
+        Elf32Half::read<big_endian>(p + 46),
+        Elf32Half::read<big_endian>(p + 48),
+        Elf32Half::read<big_endian>(p + 50),
     };
+    std::copy(p, p + 16, ehdr.e_ident.begin());
+    return ehdr;
 }
 
-Elf32Ehdr Elf32Ehdr::from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    if (endianness == ELF_DATA2LSB) {
-        return from_le_bytes(buf);
-    }
-    return from_be_bytes(buf);
-}
+template Elf32Ehdr Elf32Ehdr::read<false>(const uint8_t* p);
+template Elf32Ehdr Elf32Ehdr::read<true>(const uint8_t* p);
 
 std::string Elf32Phdr::describe() {
     return "program header";
 }
 
-Elf32Phdr Elf32Phdr::from_le_bytes(const std::vector<uint8_t>& buf) {
-    return Elf32Phdr{
-        Elf32Word::from_le_bytes(byte_range(buf, 0, 4)),
-        Elf32Off:: from_le_bytes(byte_range(buf, 4, 8)),
-        Elf32Addr::from_le_bytes(byte_range(buf, 8, 12)),
-        Elf32Addr::from_le_bytes(byte_range(buf, 12, 16)),
-        Elf32Word::from_le_bytes(byte_range(buf, 16, 20)),
-        Elf32Word::from_le_bytes(byte_range(buf, 20, 24)),
-        Elf32Word::from_le_bytes(byte_range(buf, 24, 28)),
-        Elf32Word::from_le_bytes(byte_range(buf, 28, 32)),
-    };
-}
-
-Elf32Phdr Elf32Phdr::from_be_bytes(const std::vector<uint8_t>& buf) {
+template<bool big_endian>
+Elf32Phdr Elf32Phdr::read(const uint8_t* p) {
     return Elf32Phdr{
-        Elf32Word::from_be_bytes(byte_range(buf, 0, 4)),
-        Elf32Off:: from_be_bytes(byte_range(buf, 4, 8)),
-        Elf32Addr::from_be_bytes(byte_range(buf, 8, 12)),
-        Elf32Addr::from_be_bytes(byte_range(buf, 12, 16)),
-        Elf32Word::from_be_bytes(byte_range(buf, 16, 20)),
-        Elf32Word::from_be_bytes(byte_range(buf, 20, 24)),
-        Elf32Word::from_be_bytes(byte_range(buf, 24, 28)),
-        Elf32Word::from_be_bytes(byte_range(buf, 28, 32)),
+        Elf32Word::read<big_endian>(p + 0),
+        Elf32Off:: read<big_endian>(p + 4),
+        Elf32Addr::read<big_endian>(p + 8),
+        Elf32Addr::read<big_endian>(p + 12),
+        Elf32Word::read<big_endian>(p + 16),
+        Elf32Word::read<big_endian>(p + 20),
+        Elf32Word::read<big_endian>(p + 24),
+        Elf32Word::read<big_endian>(p + 28),
     };
 }
 
-Elf32Phdr Elf32Phdr::from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    if (endianness == ELF_DATA2LSB) {
-        return from_le_bytes(buf);
-    }
-    return from_be_bytes(buf);
-}
+template Elf32Phdr Elf32Phdr::read<false>(const uint8_t* p);
+template Elf32Phdr Elf32Phdr::read<true>(const uint8_t* p);
 
 std::string Elf32Shdr::describe() {
     return "section header";
 }
 
-Elf32Shdr Elf32Shdr::from_le_bytes(const std::vector<uint8_t>& buf) {
-    return  Elf32Shdr{
-        Elf32Word::from_le_bytes(byte_range(buf, 0, 4)),
-        Elf32Word::from_le_bytes(byte_range(buf, 4, 8)),
-        Elf32Word::from_le_bytes(byte_range(buf, 8, 12)),
-        Elf32Addr::from_le_bytes(byte_range(buf, 12, 16)),
-        Elf32Off:: from_le_bytes(byte_range(buf, 16, 20)),
-        Elf32Word::from_le_bytes(byte_range(buf, 20, 24)),
-        Elf32Word::from_le_bytes(byte_range(buf, 24, 28)),
-        Elf32Word::from_le_bytes(byte_range(buf, 28, 32)),
-        Elf32Word::from_le_bytes(byte_range(buf, 32, 36)),
-        Elf32Word::from_le_bytes(byte_range(buf, 36, 40)),
+template<bool big_endian>
+Elf32Shdr Elf32Shdr::read(const uint8_t* p) {
+    return Elf32Shdr{
+        Elf32Word::read<big_endian>(p + 0),
+        Elf32Word::read<big_endian>(p + 4),
+        Elf32Word::read<big_endian>(p + 8),
+        Elf32Addr::read<big_endian>(p + 12),
+        Elf32Off:: read<big_endian>(p + 16),
+        Elf32Word::read<big_endian>(p + 20),
+        Elf32Word::read<big_endian>(p + 24),
+        Elf32Word::read<big_endian>(p + 28),
+        Elf32Word::read<big_endian>(p + 32),
+        Elf32Word::read<big_endian>(p + 36),
     };
 }
 
-Elf32Shdr Elf32Shdr::from_be_bytes(const std::vector<uint8_t>& buf) {
-    return Elf32Shdr{
-        Elf32Word::from_be_bytes(byte_range(buf, 0, 4)),
-        Elf32Word::from_be_bytes(byte_range(buf, 4, 8)),
-        Elf32Word::from_be_bytes(byte_range(buf, 8, 12)),
-        Elf32Addr::from_be_bytes(byte_range(buf, 12, 16)),
-        Elf32Off:: from_be_bytes(byte_range(buf, 16, 20)),
-        Elf32Word::from_be_bytes(byte_range(buf, 20, 24)),
-        Elf32Word::from_be_bytes(byte_range(buf, 24, 28)),
-        Elf32Word::from_be_bytes(byte_range(buf, 28, 32)),
-        Elf32Word::from_be_bytes(byte_range(buf, 32, 36)),
-        Elf32Word::from_be_bytes(byte_range(buf, 36, 40)),
-    };
+template Elf32Shdr Elf32Shdr::read<false>(const uint8_t* p);
+template Elf32Shdr Elf32Shdr::read<true>(const uint8_t* p);
+
+std::string Elf32Sym::describe() {
+    return "symbol";
 }
 
-Elf32Shdr Elf32Shdr::from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    if (endianness == ELF_DATA2LSB) {
-        return from_le_bytes(buf);
-    }
-    return from_be_bytes(buf);
+template<bool big_endian>
+Elf32Sym Elf32Sym::read(const uint8_t* p) {
+    return Elf32Sym{
+        Elf32Word::read<big_endian>(p + 0),
+        Elf32Addr::read<big_endian>(p + 4),
+        Elf32Word::read<big_endian>(p + 8),
+        Elf32Byte::read<big_endian>(p + 12),
+        Elf32Byte::read<big_endian>(p + 13),
+        Elf32Half::read<big_endian>(p + 14),
+    };
 }
 
-void Elf32::add_ehdr_ranges(const Elf32Ehdr& ehdr, Ranges& ranges) {
-    ranges.add_range(0, static_cast<size_t>(ehdr.e_ehsize), new RangeTypeFileHeader());
+template Elf32Sym Elf32Sym::read<false>(const uint8_t* p);
+template Elf32Sym Elf32Sym::read<true>(const uint8_t* p);
+
+void Elf32::add_ehdr_ranges(size_t ehsize, Ranges& ranges) {
+    ranges.add_range(0, ehsize, new RangeTypeFileHeader());
     ranges.add_range(16, 2, new RangeTypeHeaderField("e_type"));
     ranges.add_range(18, 2, new RangeTypeHeaderField("e_machine"));
     ranges.add_range(20, 4, new RangeTypeHeaderField("e_version"));
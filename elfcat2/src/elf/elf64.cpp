@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "include/elf64.hpp"
 
 
@@ -5,131 +7,96 @@ std::string Elf64Ehdr::describe() {
     return "file header";
 }
 
-Elf64Ehdr Elf64Ehdr::from_le_bytes(const std::vector<uint8_t>& buf) {
-    return Elf64Ehdr{
-        to_array<16>(byte_range(buf, 0, 16)),
-        Elf64Half::from_le_bytes(byte_range(buf, 16, 18)),
-        Elf64Half::from_le_bytes(byte_range(buf, 18, 20)),
-        Elf64Word::from_le_bytes(byte_range(buf, 20, 24)),
-        Elf64Addr::from_le_bytes(byte_range(buf, 24, 32)),
-        Elf64Off:: from_le_bytes(byte_range(buf, 32, 40)),
-        Elf64Off:: from_le_bytes(byte_range(buf, 40, 48)),
-        Elf64Word::from_le_bytes(byte_range(buf, 48, 52)),
-        Elf64Half::from_le_bytes(byte_range(buf, 52, 54)),
-        Elf64Half::from_le_bytes(byte_range(buf, 54, 56)),
-        Elf64Half::from_le_bytes(byte_range(buf, 56, 58)),
-        Elf64Half::from_le_bytes(byte_range(buf, 58, 60)),
-        Elf64Half::from_le_bytes(byte_range(buf, 60, 62)),
-        Elf64Half::from_le_bytes(byte_range(buf, 62, 64)),
-    };
-}
-
-Elf64Ehdr Elf64Ehdr::from_be_bytes(const std::vector<uint8_t>& buf) {
-    return Elf64Ehdr{
-        to_array<16>(byte_range(buf, 0, 16)),
-        Elf64Half::from_be_bytes(byte_range(buf, 16, 18)),
-        Elf64Half::from_be_bytes(byte_range(buf, 18, 20)),
-        Elf64Word::from_be_bytes(byte_range(buf, 20, 24)),
-        Elf64Addr::from_be_bytes(byte_range(buf, 24, 32)),
-        Elf64Off:: from_be_bytes(byte_range(buf, 32, 40)),
-        Elf64Off:: from_be_bytes(byte_range(buf, 40, 48)),
-        Elf64Word::from_be_bytes(byte_range(buf, 48, 52)),
-        Elf64Half::from_be_bytes(byte_range(buf, 52, 54)),
-        Elf64Half::from_be_bytes(byte_range(buf, 54, 56)),
-        Elf64Half::from_be_bytes(byte_range(buf, 56, 58)),
-        Elf64Half::from_be_bytes(byte_range(buf, 58, 60)),
-        Elf64Half::from_be_bytes(byte_range(buf, 60, 62)),
-        Elf64Half::from_be_bytes(byte_range(buf, 62, 64)),
+template<bool big_endian>
+Elf64Ehdr Elf64Ehdr::read(const uint8_t* p) {
+    Elf64Ehdr ehdr{
+        {},
+        Elf64Half::read<big_endian>(p + 16),
+        Elf64Half::read<big_endian>(p + 18),
+        Elf64Word::read<big_endian>(p + 20),
+        Elf64Addr::read<big_endian>(p + 24),
+        Elf64Off:: read<big_endian>(p + 32),
+        Elf64Off:: read<big_endian>(p + 40),
+        Elf64Word::read<big_endian>(p + 48),
+        Elf64Half::read<big_endian>(p + 52),
+        Elf64Half::read<big_endian>(p + 54),
+        Elf64Half::read<big_endian>(p + 56),
+        Elf64Half::read<big_endian>(p + 58),
+        Elf64Half::read<big_endian>(p + 60),
+        Elf64Half::read<big_endian>(p + 62),
     };
+    std::copy(p, p + 16, ehdr.e_ident.begin());
+    return ehdr;
 }
 
-Elf64Ehdr Elf64Ehdr::from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    if (endianness == ELF_DATA2LSB) {
-        return from_le_bytes(buf);
-    }
-    return from_be_bytes(buf);
-}
+template Elf64Ehdr Elf64Ehdr::read<false>(const uint8_t* p);
+template Elf64Ehdr Elf64Ehdr::read<true>(const uint8_t* p);
 
 std::string Elf64Phdr::describe() {
     return "program header";
 }
 
-Elf64Phdr Elf64Phdr::from_le_bytes(const std::vector<uint8_t>& buf) {
+template<bool big_endian>
+Elf64Phdr Elf64Phdr::read(const uint8_t* p) {
     return Elf64Phdr{
-        Elf64Word:: from_le_bytes(byte_range(buf, 0, 4)),
-        Elf64Word:: from_le_bytes(byte_range(buf, 4, 8)),
-        Elf64Off::  from_le_bytes(byte_range(buf, 8, 16)),
-        Elf64Addr:: from_le_bytes(byte_range(buf, 16, 24)),
-        Elf64Addr:: from_le_bytes(byte_range(buf, 24, 32)),
-        Elf64Xword::from_le_bytes(byte_range(buf, 32, 40)),
-        Elf64Xword::from_le_bytes(byte_range(buf, 40, 48)),
-        Elf64Xword::from_le_bytes(byte_range(buf, 48, 56)),
+        Elf64Word:: read<big_endian>(p + 0),
+        Elf64Word:: read<big_endian>(p + 4),
+        Elf64Off::  read<big_endian>(p + 8),
+        Elf64Addr:: read<big_endian>(p + 16),
+        Elf64Addr:: read<big_endian>(p + 24),
+        Elf64Xword::read<big_endian>(p + 32),
+        Elf64Xword::read<big_endian>(p + 40),
+        Elf64Xword::read<big_endian>(p + 48),
     };
 }
 
-Elf64Phdr Elf64Phdr::from_be_bytes(const std::vector<uint8_t>& buf) {
-    return Elf64Phdr{
-        Elf64Word:: from_be_bytes(byte_range(buf, 0, 4)),
-        Elf64Word:: from_be_bytes(byte_range(buf, 4, 8)),
-        Elf64Off::  from_be_bytes(byte_range(buf, 8, 16)),
-        Elf64Addr:: from_be_bytes(byte_range(buf, 16, 24)),
-        Elf64Addr:: from_be_bytes(byte_range(buf, 24, 32)),
-        Elf64Xword::from_be_bytes(byte_range(buf, 32, 40)),
-        Elf64Xword::from_be_bytes(byte_range(buf, 40, 48)),
-        Elf64Xword::from_be_bytes(byte_range(buf, 48, 56)),
-    };
-}
-
-Elf64Phdr Elf64Phdr::from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    if (endianness == ELF_DATA2LSB) {
-        return from_le_bytes(buf);
-    }
-    return from_be_bytes(buf);
-}
+template Elf64Phdr Elf64Phdr::read<false>(const uint8_t* p);
+template Elf64Phdr Elf64Phdr::read<true>(const uint8_t* p);
 
 std::string Elf64Shdr::describe() {
     return "section header";
 }
 
-Elf64Shdr Elf64Shdr::from_le_bytes(const std::vector<uint8_t>& buf) {
+template<bool big_endian>
+Elf64Shdr Elf64Shdr::read(const uint8_t* p) {
     return Elf64Shdr{
-        Elf64Word:: from_le_bytes(byte_range(buf, 0, 4)),
-        Elf64Word:: from_le_bytes(byte_range(buf, 4, 8)),
-        Elf64Xword::from_le_bytes(byte_range(buf, 8, 16)),
-        Elf64Addr:: from_le_bytes(byte_range(buf, 16, 24)),
-        Elf64Off::  from_le_bytes(byte_range(buf, 24, 32)),
-        Elf64Xword::from_le_bytes(byte_range(buf, 32, 40)),
-        Elf64Word:: from_le_bytes(byte_range(buf, 40, 44)),
-        Elf64Word:: from_le_bytes(byte_range(buf, 44, 48)),
-        Elf64Xword::from_le_bytes(byte_range(buf, 48, 56)),
-        Elf64Xword::from_le_bytes(byte_range(buf, 56, 64)),
+        Elf64Word:: read<big_endian>(p + 0),
+        Elf64Word:: read<big_endian>(p + 4),
+        Elf64Xword::read<big_endian>(p + 8),
+        Elf64Addr:: read<big_endian>(p + 16),
+        Elf64Off::  read<big_endian>(p + 24),
+        Elf64Xword::read<big_endian>(p + 32),
+        Elf64Word:: read<big_endian>(p + 40),
+        Elf64Word:: read<big_endian>(p + 44),
+        Elf64Xword::read<big_endian>(p + 48),
+        Elf64Xword::read<big_endian>(p + 56),
     };
 }
 
-Elf64Shdr Elf64Shdr::from_be_bytes(const std::vector<uint8_t>& buf) {
-    return Elf64Shdr{
-        Elf64Word:: from_be_bytes(byte_range(buf, 0, 4)),
-        Elf64Word:: from_be_bytes(byte_range(buf, 4, 8)),
-        Elf64Xword::from_be_bytes(byte_range(buf, 8, 16)),
-        Elf64Addr:: from_be_bytes(byte_range(buf, 16, 24)),
-        Elf64Off::  from_be_bytes(byte_range(buf, 24, 32)),
-        Elf64Xword::from_be_bytes(byte_range(buf, 32, 40)),
-        Elf64Word:: from_be_bytes(byte_range(buf, 40, 44)),
-        Elf64Word:: from_be_bytes(byte_range(buf, 44, 48)),
-        Elf64Xword::from_be_bytes(byte_range(buf, 48, 56)),
-        Elf64Xword::from_be_bytes(byte_range(buf, 56, 64)),
-    };
+template Elf64Shdr Elf64Shdr::read<false>(const uint8_t* p);
+template Elf64Shdr Elf64Shdr::read<true>(const uint8_t* p);
+
+std::string Elf64Sym::describe() {
+    return "symbol";
 }
 
-Elf64Shdr Elf64Shdr::from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    if (endianness == ELF_DATA2LSB) {
-        return from_le_bytes(buf);
-    }
-    return from_be_bytes(buf);
+template<bool big_endian>
+Elf64Sym Elf64Sym::read(const uint8_t* p) {
+    return Elf64Sym{
+        Elf64Word:: read<big_endian>(p + 0),
+        Elf64Byte:: read<big_endian>(p + 4),
+        Elf64Byte:: read<big_endian>(p + 5),
+        Elf64Half:: read<big_endian>(p + 6),
+        Elf64Addr:: read<big_endian>(p + 8),
+        Elf64Xword::read<big_endian>(p + 16),
+    };
 }
 
-void Elf64::add_ehdr_ranges(const Elf64Ehdr& ehdr, Ranges& ranges) {
-    ranges.add_range(0, static_cast<uint32_t>(ehdr.e_ehsize), new RangeTypeFileHeader());
+template Elf64Sym Elf64Sym::read<false>(const uint8_t* p);
+template Elf64Sym Elf64Sym::read<true>(const uint8_t* p);
+
+void Elf64::add_ehdr_ranges(size_t ehsize, Ranges& ranges) {
+    ranges.add_range(0, ehsize, new RangeTypeFileHeader());
     ranges.add_range(16, 2, new RangeTypeHeaderField("e_type"));
     ranges.add_range(18, 2, new RangeTypeHeaderField("e_machine"));
     ranges.add_range(20, 4, new RangeTypeHeaderField("e_version"));
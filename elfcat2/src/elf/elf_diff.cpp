@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <array>
+#include <map>
+#include <unordered_map>
+
+#include <hash.hpp>
+#include <parallel.hpp>
+#include <stats.hpp>
+
+#include "include/defs.hpp"
+#include "include/elf_diff.hpp"
+#include "include/parser.hpp"
+
+
+namespace {
+
+// chunks average about MIN_CHUNK + 256 bytes: small enough to pin an edit to a
+// function or two, large enough that the hash lookups stay cheap
+constexpr size_t MIN_CHUNK = 64;
+constexpr size_t MAX_CHUNK = 4096;
+constexpr uint64_t CHUNK_MASK = 0xff00000000000000ULL;
+
+constexpr std::array<uint64_t, 256> make_gear_table() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x6a09e667f3bcc909ULL;
+    for (auto& entry : table) {
+        // splitmix64
+        state += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        entry = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr auto GEAR = make_gear_table();
+
+
+struct Chunk {
+    size_t start;
+    size_t end;
+    uint64_t hash;
+};
+
+
+// the top bits of the gear hash depend on the last 64 bytes only, so the same
+// content produces the same boundaries wherever it sits
+std::vector<Chunk> chunk(const ByteView& bytes) {
+    std::vector<Chunk> chunks;
+    size_t start = 0;
+
+    while (start < bytes.size()) {
+        size_t limit = std::min(bytes.size(), start + MAX_CHUNK);
+        size_t end = limit;
+        uint64_t gear = 0;
+
+        for (size_t i = start; i < limit; ++i) {
+            gear = (gear << 1) + GEAR[bytes[i]];
+            if (i + 1 - start >= MIN_CHUNK && (gear & CHUNK_MASK) == 0) {
+                end = i + 1;
+                break;
+            }
+        }
+
+        chunks.push_back({start, end, xxhash64(bytes.subview(start, end))});
+        start = end;
+    }
+
+    return chunks;
+}
+
+ByteView section_bytes(const ParsedElf& elf, const ParsedShdr& shdr) {
+    if (shdr.shtype == SHT_NOBITS) {
+        return {};
+    }
+    auto [start, end] = elf.file_range(shdr.file_offset, shdr.size);
+    return elf.contents.subview(start, end);
+}
+
+ByteView segment_bytes(const ParsedElf& elf, const ParsedPhdr& phdr) {
+    auto [start, end] = elf.file_range(phdr.file_offset, phdr.file_size);
+    return elf.contents.subview(start, end);
+}
+
+void add_changed(SectionDiff& diff, uint64_t start, uint64_t end) {
+    if (!diff.changed.empty() && std::get<1>(diff.changed.back()) == start) {
+        std::get<1>(diff.changed.back()) = end;
+    } else {
+        diff.changed.emplace_back(start, end);
+    }
+    diff.changed_bytes += end - start;
+}
+
+void compare_chunks(SectionDiff& diff, const ByteView& base, const ByteView& current, uint64_t file_offset) {
+    auto base_chunks = chunk(base);
+    auto current_chunks = chunk(current);
+
+    // first offset of every base chunk, and whether anything matched it
+    std::unordered_map<uint64_t, std::tuple<size_t, bool>> known;
+    known.reserve(base_chunks.size());
+    for (const auto& piece : base_chunks) {
+        known.emplace(piece.hash, std::make_tuple(piece.start, false));
+    }
+
+    for (const auto& piece : current_chunks) {
+        auto found = known.find(piece.hash);
+        if (found == known.end()) {
+            add_changed(diff, file_offset + piece.start, file_offset + piece.end);
+            continue;
+        }
+        auto& [base_start, matched] = found->second;
+        matched = true;
+        if (base_start != piece.start) {
+            diff.moved_bytes += piece.end - piece.start;
+        }
+    }
+
+    for (const auto& piece : base_chunks) {
+        if (!std::get<1>(known[piece.hash])) {
+            diff.removed_bytes += piece.end - piece.start;
+        }
+    }
+}
+
+// pairs up the i-th item with a given key on both sides, keeping current order
+template<class Key>
+std::vector<std::tuple<std::optional<size_t>, std::optional<size_t>>> match(const std::vector<Key>& base,
+        const std::vector<Key>& current) {
+    std::map<Key, std::vector<size_t>> unmatched;
+    for (size_t i = base.size(); i-- > 0;) {
+        unmatched[base[i]].push_back(i);
+    }
+
+    std::vector<std::tuple<std::optional<size_t>, std::optional<size_t>>> pairs;
+    std::vector<bool> used(base.size());
+
+    for (size_t i = 0; i < current.size(); ++i) {
+        auto& candidates = unmatched[current[i]];
+        if (candidates.empty()) {
+            pairs.emplace_back(std::nullopt, i);
+        } else {
+            used[candidates.back()] = true;
+            pairs.emplace_back(candidates.back(), i);
+            candidates.pop_back();
+        }
+    }
+
+    for (size_t i = 0; i < base.size(); ++i) {
+        if (!used[i]) {
+            pairs.emplace_back(i, std::nullopt);
+        }
+    }
+
+    return pairs;
+}
+
+DiffStatus status_of(bool in_base, bool in_current, bool changed) {
+    if (!in_base) {
+        return DiffStatus::added;
+    }
+    if (!in_current) {
+        return DiffStatus::removed;
+    }
+    return changed ? DiffStatus::changed : DiffStatus::same;
+}
+
+void diff_section(SectionDiff& diff, const ParsedElf& base, const ParsedElf& current) {
+    const ParsedShdr* base_shdr = diff.base_index ? &base.shdrs[*diff.base_index] : nullptr;
+    const ParsedShdr* shdr = diff.index ? &current.shdrs[*diff.index] : nullptr;
+
+    ByteView base_contents;
+    ByteView contents;
+
+    if (base_shdr) {
+        base_contents = section_bytes(base, *base_shdr);
+        diff.base_size = base_shdr->size;
+        diff.base_hash = base_shdr->shtype == SHT_NOBITS ? 0 : xxhash64(base_contents);
+    }
+    if (shdr) {
+        contents = section_bytes(current, *shdr);
+        diff.size = shdr->size;
+        diff.hash = shdr->shtype == SHT_NOBITS ? 0 : xxhash64(contents);
+    }
+
+    if (!base_shdr || !shdr) {
+        diff.status = status_of(base_shdr, shdr, true);
+        if (shdr && !contents.empty()) {
+            add_changed(diff, shdr->file_offset, shdr->file_offset + contents.size());
+        }
+        if (base_shdr) {
+            diff.removed_bytes = base_contents.size();
+        }
+        return;
+    }
+
+    diff.header_changed = base_shdr->addr != shdr->addr || base_shdr->flags != shdr->flags
+        || base_shdr->size != shdr->size || base_shdr->addralign != shdr->addralign
+        || base_shdr->entsize != shdr->entsize;
+    diff.contents_changed = diff.base_hash != diff.hash || base_contents.size() != contents.size();
+    diff.status = status_of(true, true, diff.header_changed || diff.contents_changed);
+
+    if (!diff.contents_changed) {
+        return;
+    }
+
+    if (shdr->shtype == SHT_NOTE) {
+        // the report nests note subranges inside note sections; changed ranges
+        // must not straddle them, and notes are tiny anyway
+        add_changed(diff, shdr->file_offset, shdr->file_offset + contents.size());
+        diff.removed_bytes = base_contents.size();
+        return;
+    }
+
+    compare_chunks(diff, base_contents, contents, shdr->file_offset);
+}
+
+std::tuple<uint32_t, std::string> section_key(const ParsedElf& elf, const ParsedShdr& shdr) {
+    return {shdr.shtype, elf.shnstrtab().get(shdr.name)};
+}
+
+}
+
+
+ElfDiff ElfDiff::build(const ParsedElf& base, const ParsedElf& current, size_t jobs) {
+    STATS_PHASE(phase, "diff");
+
+    ElfDiff result;
+    result.base_filename = base.filename;
+
+    auto base_header = base.contents.subview(0, std::min(base.ehsize, base.file_size));
+    auto current_header = current.contents.subview(0, std::min(current.ehsize, current.file_size));
+    result.header_changed = !std::equal(base_header.begin(), base_header.end(),
+            current_header.begin(), current_header.end());
+
+    // names are resolved up front: the string table caches aren't thread safe
+    std::vector<std::tuple<uint32_t, std::string>> base_keys;
+    std::vector<std::tuple<uint32_t, std::string>> current_keys;
+    for (const auto& shdr : base.shdrs) {
+        base_keys.push_back(section_key(base, shdr));
+    }
+    for (const auto& shdr : current.shdrs) {
+        current_keys.push_back(section_key(current, shdr));
+    }
+
+    for (const auto& [base_index, index] : match(base_keys, current_keys)) {
+        SectionDiff diff;
+        const auto& key = index ? current_keys[*index] : base_keys[*base_index];
+        diff.shtype = std::get<0>(key);
+        diff.name = std::get<1>(key);
+        diff.base_index = base_index;
+        diff.index = index;
+        result.sections.push_back(std::move(diff));
+    }
+
+    parallel_for(result.sections.size(), jobs, [&](size_t i) {
+        diff_section(result.sections[i], base, current);
+    });
+
+    std::vector<uint32_t> base_types;
+    std::vector<uint32_t> current_types;
+    for (const auto& phdr : base.phdrs) {
+        base_types.push_back(phdr.ptype);
+    }
+    for (const auto& phdr : current.phdrs) {
+        current_types.push_back(phdr.ptype);
+    }
+
+    std::map<uint32_t, size_t> ordinals;
+    for (const auto& [base_index, index] : match(base_types, current_types)) {
+        SegmentDiff diff;
+        diff.ptype = index ? current_types[*index] : base_types[*base_index];
+        diff.ordinal = ordinals[diff.ptype]++;
+        diff.base_index = base_index;
+        diff.index = index;
+        result.segments.push_back(diff);
+    }
+
+    parallel_for(result.segments.size(), jobs, [&](size_t i) {
+        auto& diff = result.segments[i];
+        if (!diff.base_index || !diff.index) {
+            diff.status = status_of(diff.base_index.has_value(), diff.index.has_value(), true);
+            return;
+        }
+
+        const auto& base_phdr = base.phdrs[*diff.base_index];
+        const auto& phdr = current.phdrs[*diff.index];
+
+        diff.header_changed = base_phdr.flags != phdr.flags || base_phdr.file_offset != phdr.file_offset
+            || base_phdr.file_size != phdr.file_size || base_phdr.vaddr != phdr.vaddr
+            || base_phdr.memsz != phdr.memsz || base_phdr.alignment != phdr.alignment;
+        auto base_contents = segment_bytes(base, base_phdr);
+        auto contents = segment_bytes(current, phdr);
+        diff.contents_changed = base_contents.size() != contents.size()
+            || xxhash64(base_contents) != xxhash64(contents);
+        diff.status = status_of(true, true, diff.header_changed || diff.contents_changed);
+    });
+
+    return result;
+}
+
+bool ElfDiff::identical() const {
+    auto same = [](const auto& diff) { return diff.status == DiffStatus::same; };
+    return !header_changed && std::all_of(sections.begin(), sections.end(), same)
+        && std::all_of(segments.begin(), segments.end(), same);
+}
+
+std::vector<std::tuple<size_t, size_t>> ElfDiff::changed_spans() const {
+    std::vector<std::tuple<size_t, size_t>> spans;
+    for (const auto& section : sections) {
+        for (const auto& [start, end] : section.changed) {
+            spans.emplace_back(start, end - start);
+        }
+    }
+    std::sort(spans.begin(), spans.end());
+
+    // sections can overlap; the report needs disjoint spans
+    std::vector<std::tuple<size_t, size_t>> disjoint;
+    size_t covered = 0;
+    for (auto [start, length] : spans) {
+        auto end = start + length;
+        start = std::max(start, covered);
+        if (start < end) {
+            disjoint.emplace_back(start, end - start);
+            covered = end;
+        }
+    }
+    return disjoint;
+}
+
+std::string diff_status_to_string(DiffStatus status) {
+    static const std::map<DiffStatus, std::string> status_mapping {
+        {DiffStatus::same, "same"},
+        {DiffStatus::changed, "changed"},
+        {DiffStatus::added, "added"},
+        {DiffStatus::removed, "removed"},
+    };
+
+    return status_mapping.at(status);
+}
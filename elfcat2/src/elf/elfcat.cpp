@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include "include/elfcat.hpp"
+#include "include/elfxx.hpp"
+
+
+namespace {
+
+size_t align4(size_t value) {
+    return (value + 3) & ~size_t(3);
+}
+
+// clamps a file range to the mapped contents
+ByteView file_bytes(const ParsedElf& elf, size_t offset, size_t size) {
+    if (offset >= elf.contents.size()) {
+        return {};
+    }
+    size_t end = offset + std::min(size, elf.contents.size() - offset);
+    return elf.contents.subview(offset, end);
+}
+
+bool intersects(size_t offset, size_t size, size_t start, size_t end) {
+    return size != 0 && offset < end && start < offset + size;
+}
+
+}
+
+
+SegmentView segment_view(const ParsedElf& elf, size_t idx) {
+    const auto& phdr = elf.phdrs[idx];
+    return SegmentView{idx, phdr, file_bytes(elf, phdr.file_offset, phdr.file_size)};
+}
+
+SectionView section_view(const ParsedElf& elf, size_t idx) {
+    const auto& shdr = elf.shdrs[idx];
+    auto bytes = (shdr.shtype == SHT_NOBITS) ? ByteView() : file_bytes(elf, shdr.file_offset, shdr.size);
+    return SectionView{idx, shdr, elf.shnstrtab().get_view(shdr.name), bytes};
+}
+
+size_t NoteIterator::entry_size() const {
+    size_t left = area.size() - pos;
+    if (left < 12) {
+        return left;
+    }
+
+    size_t namesz = read_word(area.data() + pos);
+    size_t descsz = read_word(area.data() + pos + 4);
+    size_t size = 12 + align4(namesz) + align4(descsz);
+
+    return std::min(size, left);
+}
+
+NoteView NoteIterator::operator*() const {
+    const uint8_t* p = area.data() + pos;
+    size_t left = area.size() - pos;
+
+    if (left < 12) {
+        return NoteView{area_offset + pos, 0, {}, {}};
+    }
+
+    size_t namesz = std::min<size_t>(read_word(p), left - 12);
+    size_t descsz = read_word(p + 4);
+    uint32_t ntype = read_word(p + 8);
+    size_t desc_start = std::min(12 + align4(namesz), left);
+    descsz = std::min(descsz, left - desc_start);
+
+    size_t name_len = namesz;
+    if (name_len != 0 && p[12 + name_len - 1] == 0) {
+        --name_len;
+    }
+
+    return NoteView{
+        area_offset + pos,
+        ntype,
+        std::string_view(reinterpret_cast<const char*>(p + 12), name_len),
+        ByteView(p + desc_start, descsz),
+    };
+}
+
+NoteIterator& NoteIterator::operator++() {
+    pos += entry_size();
+    return *this;
+}
+
+IteratorRange<SegmentIterator> segments(const ParsedElf& elf) {
+    return {{&elf, 0}, {&elf, elf.phdrs.size()}};
+}
+
+IteratorRange<SectionIterator> sections(const ParsedElf& elf) {
+    return {{&elf, 0}, {&elf, elf.shdrs.size()}};
+}
+
+IteratorRange<NoteIterator> notes_in(const ParsedElf& elf, size_t area_offset, size_t area_size) {
+    auto area = file_bytes(elf, area_offset, area_size);
+    auto read_word = visit_elf(elf.ident, [](auto layout) {
+        return &load_bytes<uint32_t, decltype(layout)::big_endian>;
+    });
+    return {{area, area_offset, 0, read_word}, {area, area_offset, area.size(), read_word}};
+}
+
+IteratorRange<NoteIterator> notes_in(const ParsedElf& elf, const SegmentView& segment) {
+    return notes_in(elf, segment.header.file_offset, segment.header.file_size);
+}
+
+IteratorRange<NoteIterator> notes_in(const ParsedElf& elf, const SectionView& section) {
+    return notes_in(elf, section.header.file_offset, section.bytes.size());
+}
+
+std::vector<size_t> segments_in(const ParsedElf& elf, size_t start, size_t end) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+        if (intersects(elf.phdrs[i].file_offset, elf.phdrs[i].file_size, start, end)) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+std::vector<size_t> sections_in(const ParsedElf& elf, size_t start, size_t end) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+        const auto& shdr = elf.shdrs[i];
+        if (shdr.shtype != SHT_NOBITS && intersects(shdr.file_offset, shdr.size, start, end)) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+std::vector<size_t> segments_at(const ParsedElf& elf, size_t offset) {
+    return segments_in(elf, offset, offset + 1);
+}
+
+std::vector<size_t> sections_at(const ParsedElf& elf, size_t offset) {
+    return sections_in(elf, offset, offset + 1);
+}
+
+ElfFile ElfFile::open(const std::string& path) {
+    ElfFile result;
+    result.file = MappedFile::open(path);
+    result.elf = ParsedElf::from_bytes(path, result.file.view());
+    return result;
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <tuple>
+
+#include <hash.hpp>
+#include <parallel.hpp>
+#include <stats.hpp>
+
+#include "include/hash_manifest.hpp"
+#include "include/parser.hpp"
+
+
+namespace {
+
+// both digests are updated a piece at a time, so that the bytes are read from
+// memory once and hashed twice while in cache
+constexpr size_t HASH_PIECE = 256 * 1024;
+
+
+struct HashJob {
+    ManifestEntry* entry;
+    size_t start;
+    size_t end;
+};
+
+}
+
+
+HashManifest HashManifest::build(const ParsedElf& elf, const std::set<std::string>& ignored, size_t jobs) {
+    STATS_PHASE(phase, "manifest");
+
+    HashManifest manifest;
+    std::vector<HashJob> hash_jobs;
+    // file image of every ignored section
+    std::vector<std::tuple<size_t, size_t>> holes;
+
+    // shnstrtab() fills its cache on first use, so the names are read here, before
+    // parallel_for starts; the hash jobs only get byte ranges
+    manifest.sections.reserve(elf.shdrs.size());
+    for (size_t i = 1; i < elf.shdrs.size(); ++i) {
+        const auto& shdr = elf.shdrs[i];
+        auto name = elf.shnstrtab().get(shdr.name);
+        auto [start, end] = (shdr.shtype == SHT_NOBITS) ? std::make_tuple(size_t(0), size_t(0)) : elf.file_range(shdr.file_offset, shdr.size);
+
+        if (ignored.count(name) != 0) {
+            manifest.ignored.push_back(name);
+            holes.emplace_back(start, end);
+            continue;
+        }
+
+        manifest.sections.push_back({name});
+        hash_jobs.push_back({nullptr, start, end});
+    }
+
+    std::map<uint32_t, size_t> ordinals;
+    manifest.segments.reserve(elf.phdrs.size());
+    for (const auto& phdr : elf.phdrs) {
+        auto [start, end] = elf.file_range(phdr.file_offset, phdr.file_size);
+        manifest.segments.push_back({ptype_to_string(phdr.ptype) + "#" + std::to_string(ordinals[phdr.ptype]++)});
+        hash_jobs.push_back({nullptr, start, end});
+    }
+
+    // pointers only now that both vectors are filled
+    for (size_t i = 0; i < hash_jobs.size(); ++i) {
+        hash_jobs[i].entry = (i < manifest.sections.size()) ? &manifest.sections[i] : &manifest.segments[i - manifest.sections.size()];
+    }
+
+    std::sort(holes.begin(), holes.end());
+
+    std::vector<size_t> order(hash_jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return hash_jobs[a].end - hash_jobs[a].start > hash_jobs[b].end - hash_jobs[b].start;
+    });
+
+    parallel_for(order.size(), jobs, [&](size_t i) {
+        const auto& job = hash_jobs[order[i]];
+        Sha256 sha;
+        Xxh64 xxh;
+        uint64_t size = 0;
+
+        auto hash = [&](size_t start, size_t end) {
+            for (size_t piece = start; piece < end; piece += HASH_PIECE) {
+                auto bytes = elf.contents.subview(piece, std::min(end, piece + HASH_PIECE));
+                sha.update(bytes.data(), bytes.size());
+                xxh.update(bytes.data(), bytes.size());
+            }
+            size += end - start;
+        };
+
+        size_t position = job.start;
+        for (const auto& [hole_start, hole_end] : holes) {
+            if (hole_end <= position || hole_start >= hole_end) {
+                continue;
+            }
+            if (hole_start >= job.end) {
+                break;
+            }
+            hash(position, std::max(position, hole_start));
+            position = std::max(position, hole_end);
+        }
+        hash(position, std::max(position, job.end));
+
+        job.entry->size = size;
+        job.entry->sha256 = sha.finish();
+        job.entry->xxh64 = xxh.digest();
+    });
+
+    return manifest;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "parser.hpp"
+
+
+// Half-open [start, end) interval owned by the segment or section at index.
+struct Interval {
+    uint64_t start;
+    uint64_t end;
+    size_t index;
+};
+
+
+// Sorted, non-overlapping intervals with O(log n) point lookup. Overlapping
+// input is resolved in favour of the interval that starts first; the later one
+// is trimmed to what's left of it, or dropped.
+struct IntervalSet {
+    static IntervalSet build(std::vector<Interval> intervals);
+    const Interval* find(uint64_t point) const;
+
+    std::vector<Interval> intervals;
+};
+
+
+struct AddressLocation {
+    // PT_LOAD segment and SHF_ALLOC section covering the address, if any
+    std::optional<size_t> segment;
+    std::optional<size_t> section;
+    std::optional<uint64_t> vaddr;
+    // none for addresses past p_filesz (.bss and friends)
+    std::optional<uint64_t> file_offset;
+};
+
+
+// vaddr <-> file offset translation. Built once from the program and section
+// headers; every lookup is a couple of binary searches and touches no contents.
+struct AddressIndex {
+    static AddressIndex build(const ParsedElf& elf);
+
+    AddressLocation from_vaddr(uint64_t vaddr) const;
+    AddressLocation from_offset(uint64_t offset) const;
+
+    const ParsedElf* elf = nullptr;
+    // PT_LOAD segments by [p_vaddr, p_vaddr + p_memsz) and [p_offset, p_offset + p_filesz)
+    IntervalSet segments_by_vaddr;
+    IntervalSet segments_by_offset;
+    // SHF_ALLOC sections by address (TLS .tbss excluded, it takes no address space
+    // of its own) and every section with file contents by offset
+    IntervalSet sections_by_vaddr;
+    IntervalSet sections_by_offset;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <utils.hpp>
+
+#include "parser.hpp"
+
+
+struct ArchiveMember {
+    // long GNU ("/123") and BSD ("#1/N") names already resolved
+    std::string name;
+    // of the ar header, which is what the symbol index points at
+    size_t header_offset;
+    // of the contents, within the archive
+    size_t offset;
+    size_t size;
+};
+
+
+struct ArchiveSymbol {
+    std::string name;
+    // index into Archive::members
+    size_t member;
+};
+
+
+// The member table of a System V / GNU or BSD ar archive. The symbol index
+// ("/", "/SYM64/" or "__.SYMDEF*") and the GNU long name table ("//") are
+// decoded, not listed as members. Thin archives, whose members live in other
+// files, are rejected.
+struct Archive {
+    static bool is_archive(const ByteView& buf);
+    static Archive from_bytes(const ByteView& buf);
+
+    std::vector<ArchiveMember> members;
+    std::vector<ArchiveSymbol> symbols;
+};
+
+
+// An archive with each member parsed as a ParsedElf whose contents are a view of
+// the archive's buffer, nothing copied. Members are parsed on jobs threads;
+// members that aren't ELF files (LLVM bitcode, stray text files) keep the error
+// instead.
+struct ParsedArchive {
+    static ParsedArchive from_bytes(const std::string& filename, const ByteView& buf, size_t jobs = 0);
+
+    std::string filename;
+    size_t file_size = 0;
+    Archive archive;
+    // one per member, empty where error isn't
+    std::vector<std::optional<ParsedElf>> elves;
+    std::vector<std::string> errors;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <mapped_file.hpp>
+#include <utils.hpp>
+
+
+struct ParsedElf;
+
+
+// longer build-ids (sha1 is 20 bytes, md5 and uuid 16, xxhash 8) aren't indexed
+constexpr size_t BUILD_ID_MAX = 32;
+
+
+struct BuildIdEntry {
+    std::vector<uint8_t> build_id;
+    std::string path;
+    uint64_t file_size = 0;
+    uint16_t machine = 0;
+    uint8_t elf_class = 0;
+};
+
+
+// The on-disk layout, in host byte order: a header, count fixed-size records
+// sorted by build-id, then the paths they point at. Lookups are a binary search
+// over the mapped records, nothing is read up front.
+struct BuildIdIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t paths_offset;
+};
+
+struct BuildIdRecord {
+    // zero padded, so records compare with memcmp
+    uint8_t build_id[BUILD_ID_MAX];
+    uint8_t build_id_size;
+    uint8_t elf_class;
+    uint16_t machine;
+    uint32_t path_size;
+    // from the start of the paths
+    uint64_t path_offset;
+    uint64_t file_size;
+};
+
+
+struct BuildIdIndex {
+    static void write(const std::string& path, std::vector<BuildIdEntry> entries);
+    static BuildIdIndex open(const std::string& path);
+
+    // every file with this build-id, usually one; copies of a binary get a record each
+    std::vector<BuildIdEntry> lookup(const ByteView& build_id) const;
+    size_t size() const { return count; }
+
+    MappedFile file;
+    const BuildIdRecord* records = nullptr;
+    size_t count = 0;
+    ByteView paths;
+};
+
+
+// the NT_GNU_BUILD_ID note, if the file has one; only note areas are read
+std::optional<std::vector<uint8_t>> find_build_id(const ParsedElf& elf);
+// build-ids of every ELF file under roots, headers and notes parsed on jobs
+// threads; other files and ELF files without a build-id are skipped
+std::vector<BuildIdEntry> scan_build_ids(const std::vector<std::string>& roots, size_t jobs = 0);
+// "0x" and separators aren't accepted, build-ids are plain hex like readelf prints them
+std::optional<std::vector<uint8_t>> parse_build_id(std::string_view text);
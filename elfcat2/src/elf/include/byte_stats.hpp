@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <utils.hpp>
+
+
+struct ParsedElf;
+
+
+// zero bytes only count as padding in runs at least this long
+constexpr size_t ZERO_RUN_MIN = 16;
+// bytes per cell of the entropy strip next to the dump: 16 rows of it
+constexpr size_t ENTROPY_BLOCK = 256;
+constexpr size_t ENTROPY_LEVELS = 8;
+
+
+// Byte histogram and zero runs of a contiguous range. Stats of adjacent ranges
+// merge exactly, runs crossing the boundary included, so a large range can be
+// counted in pieces on several threads.
+struct ByteStats {
+    static ByteStats of(const ByteView& bytes);
+    // appends the stats of the range right after this one
+    void merge(const ByteStats& next);
+    // Shannon entropy, 0 to 8 bits per byte
+    double entropy() const;
+    uint64_t zero_run_bytes() const;
+
+    std::array<uint64_t, 256> histogram{};
+    uint64_t size = 0;
+    // zeros at either edge, which may continue into a neighbour; size when all zero
+    uint64_t leading_zeros = 0;
+    uint64_t trailing_zeros = 0;
+    // bytes of runs that touch neither edge
+    uint64_t inner_zero_run_bytes = 0;
+};
+
+
+// what the report shows of a ByteStats; the histogram itself is 2 KiB
+struct ByteSummary {
+    uint64_t size = 0;
+    double entropy = 0;
+    uint64_t zero_run_bytes = 0;
+    // most frequent byte values with their counts, most frequent first
+    std::vector<std::tuple<uint8_t, uint64_t>> common;
+
+    static ByteSummary of(const ByteStats& stats);
+};
+
+
+// Statistics of the file image of every section and segment (SHT_NOBITS ones
+// stay empty), plus the entropy strip: one level, '0' to '7', per ENTROPY_BLOCK
+// bytes of the file. Ranges are cut into pieces that are counted on jobs
+// threads; streamed files are read sequentially, the block cache being
+// single-threaded.
+struct ElfByteStats {
+    static ElfByteStats build(const ParsedElf& elf, size_t jobs = 0);
+
+    std::vector<ByteSummary> sections;
+    std::vector<ByteSummary> segments;
+    std::string entropy_levels;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+struct CoreThread {
+    int32_t pid;
+    int32_t signal;
+    // only known for x86, x86-64 and aarch64
+    std::optional<uint64_t> pc;
+    std::optional<uint64_t> sp;
+};
+
+
+struct CoreMapping {
+    uint64_t start;
+    uint64_t end;
+    uint64_t file_offset;
+    std::string path;
+};
+
+
+struct CoreSigInfo {
+    int32_t signo;
+    int32_t code;
+    int32_t errno_;
+    // faulting address, only for the signals that carry one
+    std::optional<uint64_t> addr;
+};
+
+
+struct CoreSegment {
+    size_t phdr_idx;
+    uint64_t vaddr;
+    uint64_t memsz;
+    uint64_t file_offset;
+    uint64_t file_size;
+    // part of the file image that isn't a hole; file_size when holes can't be detected
+    uint64_t data_bytes;
+};
+
+
+// What a core file says about the crashed process. Built from the notes and the
+// program headers only: segment contents are never read, holes are found with
+// SEEK_DATA/SEEK_HOLE, so this stays cheap on cores of any size.
+struct CoreInfo {
+    std::string process_name;
+    std::string process_args;
+    std::vector<CoreThread> threads;
+    uint64_t page_size = 0;
+    std::vector<CoreMapping> mappings;
+    // (type, value) pairs up to AT_NULL
+    std::vector<std::tuple<uint64_t, uint64_t>> auxv;
+    std::optional<CoreSigInfo> siginfo;
+    std::vector<CoreSegment> segments;
+};
+
+
+CoreInfo parse_core(const ParsedElf& elf);
+std::string auxv_type_to_string(uint64_t type);
+std::string signal_to_string(int32_t signo);
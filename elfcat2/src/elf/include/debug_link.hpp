@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+struct DebugLink {
+    std::string filename;
+    uint32_t crc;
+};
+
+
+// Build-ids and .gnu_debuglink CRCs of candidate debug files, kept across runs
+// so that multi-GB debug files are hashed once. An entry is only trusted while
+// the file's size and modification time stay the same.
+struct DebugFileCache {
+    struct Entry {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        std::optional<uint32_t> crc;
+        // empty for files without one, unset until looked at
+        std::optional<std::vector<uint8_t>> build_id;
+    };
+
+    // $XDG_CACHE_HOME/elfcat/debug-files, or ~/.cache/elfcat/debug-files
+    static std::string default_path();
+    // a missing or unreadable cache is an empty one
+    static DebugFileCache load(const std::string& path);
+    // creates the directory if needed; failures are ignored, the cache is only an optimization
+    void save() const;
+
+    // the entry of file, reset if the file changed since; null when it doesn't exist
+    Entry* entry(const std::string& file);
+    std::optional<uint32_t> crc(const std::string& file);
+    std::optional<std::vector<uint8_t>> build_id(const std::string& file);
+
+    std::string path;
+    std::map<std::string, Entry> entries;
+    bool dirty = false;
+};
+
+
+// Finds the separate debug file of a stripped binary the way gdb does: by
+// build-id under <root>/.build-id/xx/yyyy.debug, then by .gnu_debuglink next to
+// the binary, in its .debug directory and under <root>/<binary's directory>.
+// Candidates only count when their build-id or CRC matches.
+struct DebugResolver {
+    std::optional<std::string> resolve(const ParsedElf& elf);
+
+    // searched in order, before /usr/lib/debug
+    std::vector<std::string> roots;
+    DebugFileCache cache;
+};
+
+
+std::optional<DebugLink> find_debug_link(const ParsedElf& elf);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 constexpr uint8_t ELF_EI_MAG0 = 0;
 constexpr uint8_t ELF_EI_MAG1 = 1;
@@ -60,7 +62,26 @@ constexpr uint32_t PF_MASKPROC = 0xff000000;
 
 constexpr uint32_t NT_GNU_BUILD_ID = 0x3;
 
+// core file notes, owner "CORE" (NT_SIGINFO and NT_FILE are linux specific)
+constexpr uint32_t NT_PRSTATUS = 1;
+constexpr uint32_t NT_PRPSINFO = 3;
+constexpr uint32_t NT_AUXV = 6;
+constexpr uint32_t NT_SIGINFO = 0x53494749;
+constexpr uint32_t NT_FILE = 0x46494c45;
+
+constexpr uint16_t EM_386 = 3;
+constexpr uint16_t EM_X86_64 = 62;
+constexpr uint16_t EM_AARCH64 = 183;
+
 constexpr uint16_t SHN_UNDEF = 0;
+constexpr uint16_t SHN_LORESERVE = 0xff00;
+constexpr uint16_t SHN_ABS = 0xfff1;
+constexpr uint16_t SHN_COMMON = 0xfff2;
+// e_shstrndx (or a symbol's st_shndx) doesn't fit, see section 0 (or SHT_SYMTAB_SHNDX)
+constexpr uint16_t SHN_XINDEX = 0xffff;
+
+// e_phnum doesn't fit, the real count is sh_info of section 0
+constexpr uint16_t PN_XNUM = 0xffff;
 
 constexpr uint32_t SHT_NULL = 0;
 constexpr uint32_t SHT_PROGBITS = 1;
@@ -76,6 +97,7 @@ constexpr uint32_t SHT_SHLIB = 10;
 constexpr uint32_t SHT_DYNSYM = 11;
 constexpr uint32_t SHT_INIT_ARRAY = 14;
 constexpr uint32_t SHT_FINI_ARRAY = 15;
+constexpr uint32_t SHT_SYMTAB_SHNDX = 18;
 constexpr uint32_t SHT_LOOS = 0x60000000;
 constexpr uint32_t SHT_GNU_HASH = 0x6ffffff6;
 constexpr uint32_t SHT_VER_NEED = 0x6ffffffe;
@@ -86,14 +108,191 @@ constexpr uint32_t SHT_HIPROC = 0x7fffffff;
 constexpr uint64_t SHF_WRITE = 0b001;
 constexpr uint64_t SHF_ALLOC = 0b010;
 constexpr uint64_t SHF_EXECINSTR = 0b100;
+constexpr uint64_t SHF_TLS = 0x400;
+constexpr uint64_t SHF_COMPRESSED = 0x800;
 constexpr uint64_t SHF_MASKOS = 0x0f000000;
 constexpr uint64_t SHF_MASKPROC = 0xf0000000;
 
+constexpr uint8_t STT_NOTYPE = 0;
+constexpr uint8_t STT_OBJECT = 1;
+constexpr uint8_t STT_FUNC = 2;
+constexpr uint8_t STT_SECTION = 3;
+constexpr uint8_t STT_FILE = 4;
+constexpr uint8_t STT_TLS = 6;
+
+constexpr uint8_t STB_LOCAL = 0;
+constexpr uint8_t STB_GLOBAL = 1;
+constexpr uint8_t STB_WEAK = 2;
+
+
+struct ValueName {
+    uint64_t value;
+    std::string_view name;
+};
+
+
+template<size_t N>
+constexpr bool sorted_by_value(const ValueName (&table)[N]) {
+    for (size_t i = 1; i < N; ++i) {
+        if (table[i - 1].value >= table[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// binary search of a table sorted by value; empty when it doesn't have value
+template<size_t N>
+constexpr std::string_view lookup_name(const ValueName (&table)[N], uint64_t value) {
+    size_t low = 0;
+    size_t high = N;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (table[middle].value < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return (low < N && table[low].value == value) ? table[low].name : std::string_view();
+}
+
+
+constexpr ValueName ELF_TYPE_NAMES[] = {
+    {ELF_ET_NONE, "None (NONE)"},
+    {ELF_ET_REL, "Relocatable object file (REL)"},
+    {ELF_ET_EXEC, "Executable file (EXEC)"},
+    {ELF_ET_DYN, "Shared object file (DYN)"},
+    {ELF_ET_CORE, "Core file (CORE)"},
+    {ELF_ET_LOOS | ELF_ET_HIOS, "Environment-specific use"},
+    {ELF_ET_LOPROC | ELF_ET_HIPROC, "Processor-specific use"},
+};
+
+constexpr ValueName ABI_NAMES[] = {
+    {ELF_OSABI_SYSV, "SysV"},
+    {ELF_OSABI_HPUX, "HP-UX"},
+    {2, "NetBSD"},
+    {3, "Linux"},
+    {4, "Hurd"},
+    {6, "Solaris"},
+    {7, "AIX"},
+    {8, "IRIX"},
+    {9, "FreeBSD"},
+    {10, "Tru64"},
+    {11, "Modesto"},
+    {12, "OpenBSD"},
+    {13, "OpenVMS"},
+    {255, "Standalone"},
+};
+
+constexpr ValueName MACHINE_NAMES[] = {
+    {0, "None"},
+    {1, "AT&T WE 32100"},
+    {2, "SPARC"},
+    {3, "x86"},
+    {4, "Motorolla 68000"},
+    {5, "Motorolla 88000"},
+    {6, "Intel MCU"},
+    {7, "Intel 80860"},
+    {8, "MIPS"},
+    {9, "IBM System/370"},
+    {10, "MIPS RS3000 little-endian"},
+    {14, "HP PA-RISC"},
+    {19, "Intel 80960"},
+    {20, "PowerPC"},
+    {21, "PowerPC 64-bit"},
+    {22, "S390"},
+    {40, "ARM Aarch32"},
+    {50, "Itanium IA-64"},
+    {62, "x86-64"},
+    {183, "ARM Aarch64"},
+    {190, "CUDA"},
+    {224, "AMDGPU"},
+    {243, "RISC-V"},
+};
+
+constexpr ValueName PTYPE_NAMES[] = {
+    {PT_NULL, "NULL"},
+    {PT_LOAD, "LOAD"},
+    {PT_DYNAMIC, "DYNAMIC"},
+    {PT_INTERP, "INTERP"},
+    {PT_NOTE, "NOTE"},
+    {PT_SHLIB, "SHLIB"},
+    {PT_PHDR, "PHDR"},
+    {PT_TLS, "TLS"},
+    {PT_LOOS, "LOOS"},
+    {PT_GNU_EH_FRAME, "GNU_EH_FRAME (OS-specific)"},
+    {PT_GNU_STACK, "GNU_STACK (OS-specific)"},
+    {PT_GNU_RELRO, "GNU_RELRO (OS-specific)"},
+    {PT_HIOS, "HIOS"},
+    {PT_LOPROC, "LOPROC"},
+    {PT_HIPROC, "HIPROC"},
+};
+
+constexpr ValueName SHTYPE_NAMES[] = {
+    {SHT_NULL, "NULL"},
+    {SHT_PROGBITS, "PROGBITS"},
+    {SHT_SYMTAB, "SYMTAB"},
+    {SHT_STRTAB, "STRTAB"},
+    {SHT_RELA, "RELA"},
+    {SHT_HASH, "HASH"},
+    {SHT_DYNAMIC, "DYNAMIC"},
+    {SHT_NOTE, "NOTE"},
+    {SHT_NOBITS, "NOBITS"},
+    {SHT_REL, "REL"},
+    {SHT_SHLIB, "SHLIB"},
+    {SHT_DYNSYM, "DYNSYM"},
+    {SHT_INIT_ARRAY, "INIT_ARRAY"},
+    {SHT_FINI_ARRAY, "FINI_ARRAY"},
+    {SHT_LOOS, "LOOS"},
+    {SHT_GNU_HASH, "GNU_HASH (OS-specific)"},
+    {SHT_VER_NEED, "VER_NEED (OS-specific)"},
+    {SHT_HIOS, "HIOS"},
+    {SHT_LOPROC, "LOPROC"},
+    {SHT_HIPROC, "HIPROC"},
+};
+
+static_assert(sorted_by_value(ELF_TYPE_NAMES) && sorted_by_value(ABI_NAMES) && sorted_by_value(MACHINE_NAMES)
+        && sorted_by_value(PTYPE_NAMES) && sorted_by_value(SHTYPE_NAMES), "lookup_name needs tables sorted by value");
+
+
+// names of known values, empty for others; usable in constant expressions
+constexpr std::string_view type_name(uint16_t e_type) {
+    return lookup_name(ELF_TYPE_NAMES, e_type);
+}
+
+constexpr std::string_view abi_name(uint8_t abi) {
+    return lookup_name(ABI_NAMES, abi);
+}
+
+constexpr std::string_view machine_name(uint16_t e_machine) {
+    return lookup_name(MACHINE_NAMES, e_machine);
+}
+
+constexpr std::string_view ptype_name(uint32_t ptype) {
+    return lookup_name(PTYPE_NAMES, ptype);
+}
+
+constexpr std::string_view shtype_name(uint32_t shtype) {
+    return lookup_name(SHTYPE_NAMES, shtype);
+}
+
+// R, W and X in that order, indexed by the three permission bits
+constexpr std::string_view pflags_to_string(uint32_t flags) {
+    constexpr std::string_view names[] = {"", "X", "W", "WX", "R", "RX", "RW", "RWX"};
+    return names[flags & (PF_R | PF_W | PF_X)];
+}
+
+// W, A and X in that order, "0" for none of them
+constexpr std::string_view shflags_to_string(uint64_t flags) {
+    constexpr std::string_view names[] = {"0", "W", "A", "WA", "X", "WX", "AX", "WAX"};
+    return names[flags & (SHF_WRITE | SHF_ALLOC | SHF_EXECINSTR)];
+}
+
 
+// the names above, or "Unknown <value>"
 std::string type_to_string(uint16_t e_type);
 std::string abi_to_string(uint8_t abi);
 std::string machine_to_string(uint16_t e_machine);
 std::string ptype_to_string(uint32_t ptype);
-std::string pflags_to_string(uint32_t flags);
 std::string shtype_to_string(uint32_t shtype);
-std::string shflags_to_string(uint64_t flags);
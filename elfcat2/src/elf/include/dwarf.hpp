@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+struct CompileUnitRange {
+    uint64_t start;
+    uint64_t end;
+    std::string name;
+};
+
+
+// Address ranges of every compilation unit, from .debug_aranges, with the unit
+// names (DW_AT_name of the root DIE) from .debug_info. Units missing from
+// .debug_aranges fall back to their DW_AT_low_pc/DW_AT_high_pc. Only what's
+// needed for that is decoded; compressed debug sections are skipped, so the
+// result is empty for files without usable DWARF here or in their debug file.
+std::vector<CompileUnitRange> parse_compile_unit_ranges(const ParsedElf& elf);
@@ -6,20 +6,20 @@
 
 #include <utils.hpp>
 
-#include "elfxx.hpp"
+#include "parser.hpp"
 
 
 using Elf32Addr = ser_integral_t<uint32_t>;
 using Elf32Half = ser_integral_t<uint16_t>;
 using Elf32Off = ser_integral_t<uint32_t>;
 using Elf32Word = ser_integral_t<uint32_t>;
+using Elf32Byte = ser_integral_t<uint8_t>;
 
 
 struct Elf32Ehdr {
     static std::string describe();
-    static Elf32Ehdr from_le_bytes(const std::vector<uint8_t>& buf);
-    static Elf32Ehdr from_be_bytes(const std::vector<uint8_t>& buf);
-    static Elf32Ehdr from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness);
+    template<bool big_endian>
+    static Elf32Ehdr read(const uint8_t* p);
 
     std::array<uint8_t, 16> e_ident;
     Elf32Half e_type;
@@ -40,9 +40,8 @@ struct Elf32Ehdr {
 
 struct Elf32Phdr {
     static std::string describe();
-    static Elf32Phdr from_le_bytes(const std::vector<uint8_t>& buf);
-    static Elf32Phdr from_be_bytes(const std::vector<uint8_t>& buf);
-    static Elf32Phdr from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness);
+    template<bool big_endian>
+    static Elf32Phdr read(const uint8_t* p);
 
     Elf32Word p_type;
     Elf32Off p_offset;
@@ -57,9 +56,8 @@ struct Elf32Phdr {
 
 struct Elf32Shdr {
     static std::string describe();
-    static Elf32Shdr from_le_bytes(const std::vector<uint8_t>& buf);
-    static Elf32Shdr from_be_bytes(const std::vector<uint8_t>& buf);
-    static Elf32Shdr from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness);
+    template<bool big_endian>
+    static Elf32Shdr read(const uint8_t* p);
 
     Elf32Word sh_name;
     Elf32Word sh_type;
@@ -74,8 +72,28 @@ struct Elf32Shdr {
 };
 
 
-struct Elf32 : ElfXX<Elf32Ehdr, Elf32Phdr, Elf32Shdr, Elf32Addr, Elf32Half, Elf32Word, Elf32Off, Elf32Word> {
-    void add_ehdr_ranges(const Elf32Ehdr& ehdr, Ranges& ranges);
-    void add_phdr_ranges(size_t start, Ranges& ranges);
-    void add_shdr_ranges(size_t start, Ranges& ranges);
+struct Elf32Sym {
+    static std::string describe();
+    template<bool big_endian>
+    static Elf32Sym read(const uint8_t* p);
+
+    Elf32Word st_name;
+    Elf32Addr st_value;
+    Elf32Word st_size;
+    Elf32Byte st_info;
+    Elf32Byte st_other;
+    Elf32Half st_shndx;
+};
+
+
+// the layout of ELFCLASS32 files, for ElfXX
+struct Elf32 {
+    using Ehdr = Elf32Ehdr;
+    using Phdr = Elf32Phdr;
+    using Shdr = Elf32Shdr;
+    using Sym = Elf32Sym;
+
+    static void add_ehdr_ranges(size_t ehsize, Ranges& ranges);
+    static void add_phdr_ranges(size_t start, Ranges& ranges);
+    static void add_shdr_ranges(size_t start, Ranges& ranges);
 };
@@ -6,7 +6,6 @@
 #include <cstdint>
 #include <string>
 
-#include "elfxx.hpp"
 #include "parser.hpp"
 
 
@@ -15,13 +14,13 @@ using Elf64Off = ser_integral_t<uint64_t>;
 using Elf64Half = ser_integral_t<uint16_t>;
 using Elf64Word = ser_integral_t<uint32_t>;
 using Elf64Xword = ser_integral_t<uint64_t>;
+using Elf64Byte = ser_integral_t<uint8_t>;
 
 
 struct Elf64Ehdr {
     static std::string describe();
-    static Elf64Ehdr from_le_bytes(const std::vector<uint8_t>& buf);
-    static Elf64Ehdr from_be_bytes(const std::vector<uint8_t>& buf);
-    static Elf64Ehdr from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness);
+    template<bool big_endian>
+    static Elf64Ehdr read(const uint8_t* p);
 
     std::array<uint8_t, 16> e_ident;
     Elf64Half e_type;
@@ -41,9 +40,8 @@ struct Elf64Ehdr {
 
 struct Elf64Phdr {
     static std::string describe();
-    static Elf64Phdr from_le_bytes(const std::vector<uint8_t>& buf);
-    static Elf64Phdr from_be_bytes(const std::vector<uint8_t>& buf);
-    static Elf64Phdr from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness);
+    template<bool big_endian>
+    static Elf64Phdr read(const uint8_t* p);
 
     Elf64Word p_type;
     Elf64Word p_flags;
@@ -57,9 +55,8 @@ struct Elf64Phdr {
 
 struct Elf64Shdr {
     static std::string describe();
-    static Elf64Shdr from_le_bytes(const std::vector<uint8_t>& buf);
-    static Elf64Shdr from_be_bytes(const std::vector<uint8_t>& buf);
-    static Elf64Shdr from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness);
+    template<bool big_endian>
+    static Elf64Shdr read(const uint8_t* p);
 
     Elf64Word sh_name;
     Elf64Word sh_type;
@@ -74,8 +71,28 @@ struct Elf64Shdr {
 };
 
 
-struct Elf64 : ElfXX<Elf64Ehdr, Elf64Phdr, Elf64Shdr, Elf64Addr, Elf64Half, Elf64Word, Elf64Off, Elf64Xword> {
-    void add_ehdr_ranges(const Elf64Ehdr& ehdr, Ranges& ranges);
-    void add_phdr_ranges(size_t start, Ranges& ranges);
-    void add_shdr_ranges(size_t start, Ranges& ranges);
+struct Elf64Sym {
+    static std::string describe();
+    template<bool big_endian>
+    static Elf64Sym read(const uint8_t* p);
+
+    Elf64Word st_name;
+    Elf64Byte st_info;
+    Elf64Byte st_other;
+    Elf64Half st_shndx;
+    Elf64Addr st_value;
+    Elf64Xword st_size;
+};
+
+
+// the layout of ELFCLASS64 files, for ElfXX
+struct Elf64 {
+    using Ehdr = Elf64Ehdr;
+    using Phdr = Elf64Phdr;
+    using Shdr = Elf64Shdr;
+    using Sym = Elf64Sym;
+
+    static void add_ehdr_ranges(size_t ehsize, Ranges& ranges);
+    static void add_phdr_ranges(size_t start, Ranges& ranges);
+    static void add_shdr_ranges(size_t start, Ranges& ranges);
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+enum class DiffStatus {
+    same,
+    changed,
+    added,
+    removed,
+};
+
+
+// One section of either file, matched by (name, type) and, among duplicates,
+// by order of appearance.
+struct SectionDiff {
+    std::string name;
+    uint32_t shtype;
+    std::optional<size_t> base_index;
+    std::optional<size_t> index;
+    DiffStatus status = DiffStatus::same;
+    // address, flags or size differ
+    bool header_changed = false;
+    bool contents_changed = false;
+    uint64_t base_size = 0;
+    uint64_t size = 0;
+    // xxh64 of the contents, 0 for SHT_NOBITS
+    uint64_t base_hash = 0;
+    uint64_t hash = 0;
+    // file offsets [start, end) in the current file holding bytes not found
+    // anywhere in the base section; the whole section when it was added
+    std::vector<std::tuple<uint64_t, uint64_t>> changed;
+    uint64_t changed_bytes = 0;
+    // found in the base section, at another offset
+    uint64_t moved_bytes = 0;
+    // bytes of the base section found nowhere in the current one
+    uint64_t removed_bytes = 0;
+};
+
+
+// Segments are matched by type and order among the segments of that type.
+struct SegmentDiff {
+    uint32_t ptype;
+    size_t ordinal;
+    std::optional<size_t> base_index;
+    std::optional<size_t> index;
+    DiffStatus status = DiffStatus::same;
+    bool header_changed = false;
+    bool contents_changed = false;
+};
+
+
+// Structural comparison of two builds of the same file. Sections whose
+// contents hash the same are done; the others are split by content-defined
+// chunking (a gear rolling hash picks chunk boundaries from the bytes
+// themselves, so an insertion only disturbs the chunks around it) and chunks
+// are looked up by hash in the base section, telling moved blocks from new
+// ones without a byte-by-byte compare. Hashing and chunking run on jobs
+// threads; both files must be mapped.
+struct ElfDiff {
+    static ElfDiff build(const ParsedElf& base, const ParsedElf& current, size_t jobs = 0);
+
+    bool identical() const;
+    // (offset, length) of every changed range of every section, in file order
+    std::vector<std::tuple<size_t, size_t>> changed_spans() const;
+
+    std::string base_filename;
+    bool header_changed = false;
+    // current order first, then sections only the base has
+    std::vector<SectionDiff> sections;
+    std::vector<SegmentDiff> segments;
+};
+
+
+std::string diff_status_to_string(DiffStatus status);
@@ -0,0 +1,112 @@
+#pragma once
+
+// Public API of libelfcat: everything a tool needs to inspect an ELF file
+// without going through the HTML report. Views point into the mapped file and
+// never copy contents; they stay valid as long as the ElfFile (or the buffer
+// given to ParsedElf::from_bytes) is alive.
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <mapped_file.hpp>
+#include <utils.hpp>
+
+#include "address_index.hpp"
+#include "defs.hpp"
+#include "parser.hpp"
+
+
+struct SegmentView {
+    size_t index;
+    const ParsedPhdr& header;
+    ByteView bytes;
+};
+
+
+struct SectionView {
+    size_t index;
+    const ParsedShdr& header;
+    std::string_view name;
+    // empty for SHT_NOBITS
+    ByteView bytes;
+};
+
+
+struct NoteView {
+    size_t offset;
+    uint32_t ntype;
+    // without the terminating NUL
+    std::string_view name;
+    ByteView desc;
+};
+
+
+// Random-access-ish iterator producing views by index; View is built by make_view.
+template<class View, View (*make_view)(const ParsedElf&, size_t)>
+struct IndexIterator {
+    View operator*() const { return make_view(*elf, idx); }
+    IndexIterator& operator++() { ++idx; return *this; }
+    bool operator!=(const IndexIterator& other) const { return idx != other.idx; }
+    bool operator==(const IndexIterator& other) const { return idx == other.idx; }
+
+    const ParsedElf* elf;
+    size_t idx;
+};
+
+
+template<class Iterator>
+struct IteratorRange {
+    Iterator begin() const { return first; }
+    Iterator end() const { return last; }
+
+    Iterator first;
+    Iterator last;
+};
+
+
+SegmentView segment_view(const ParsedElf& elf, size_t idx);
+SectionView section_view(const ParsedElf& elf, size_t idx);
+
+using SegmentIterator = IndexIterator<SegmentView, segment_view>;
+using SectionIterator = IndexIterator<SectionView, section_view>;
+
+
+// Walks the notes of one PT_NOTE segment or SHT_NOTE section in place.
+struct NoteIterator {
+    NoteView operator*() const;
+    NoteIterator& operator++();
+    bool operator!=(const NoteIterator& other) const { return pos != other.pos; }
+    bool operator==(const NoteIterator& other) const { return pos == other.pos; }
+
+    size_t entry_size() const;
+
+    ByteView area;
+    size_t area_offset;
+    size_t pos;
+    // load_bytes<uint32_t, ...> for the file's byte order, picked once in notes_in
+    uint32_t (*read_word)(const uint8_t*);
+};
+
+
+IteratorRange<SegmentIterator> segments(const ParsedElf& elf);
+IteratorRange<SectionIterator> sections(const ParsedElf& elf);
+IteratorRange<NoteIterator> notes_in(const ParsedElf& elf, size_t area_offset, size_t area_size);
+IteratorRange<NoteIterator> notes_in(const ParsedElf& elf, const SegmentView& segment);
+IteratorRange<NoteIterator> notes_in(const ParsedElf& elf, const SectionView& section);
+
+// Indices of segments/sections whose file image intersects [start, end).
+std::vector<size_t> segments_in(const ParsedElf& elf, size_t start, size_t end);
+std::vector<size_t> sections_in(const ParsedElf& elf, size_t start, size_t end);
+std::vector<size_t> segments_at(const ParsedElf& elf, size_t offset);
+std::vector<size_t> sections_at(const ParsedElf& elf, size_t offset);
+
+
+// A mapped file together with its parsed headers.
+struct ElfFile {
+    static ElfFile open(const std::string& path);
+
+    MappedFile file;
+    ParsedElf elf;
+};
@@ -1,40 +1,246 @@
 #pragma once
 
-#include <stdexcept>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include "defs.hpp"
+#include "elf32.hpp"
+#include "elf64.hpp"
 #include "parser.hpp"
 
-template<class EhdrT, class PhdrT, class ShdrT, class ElfXXAddr, class ElfXXHalf, class ElfXXWord, class ElfXXOff, class ElfXXXword>
+// the header passes for one class (Elf32 or Elf64) and one byte order. each of the
+// four combinations is compiled on its own, so the loops over the tables neither test
+// the byte order nor call through a vtable; visit_elf picks one per file.
+template<class Class, bool big_endian_v>
 struct ElfXX {
-    virtual ~ElfXX() = default;
+    using EhdrT = typename Class::Ehdr;
+    using PhdrT = typename Class::Phdr;
+    using ShdrT = typename Class::Shdr;
+    using SymT = typename Class::Sym;
 
-    void parse(const std::vector<uint8_t>& buf, const ParsedIdent& ident, ParsedElf& elf) {
+    static constexpr bool big_endian = big_endian_v;
+
+    // never throws: what doesn't fit in the file is recorded in elf.diagnostics and left out
+    template<class Buffer>
+    void parse(const Buffer& buf, ParsedElf& elf) {
         auto ehdr_size = sizeof(EhdrT);
 
         if (buf.size() < ehdr_size) {
-            throw std::runtime_error("file is smaller than ELF file header");
+            elf.diagnostics.push_back({0, EhdrT::describe(), "file is smaller than ELF file header", true});
+            return;
         }
 
-        auto ehdr = EhdrT::from_bytes(byte_range(buf, 0, ehdr_size), ident.endianness);
+        std::vector<uint8_t> scratch;
+        auto ehdr = EhdrT::template read<big_endian>(view_range(buf, 0, ehdr_size, scratch).data());
+
+        elf.type = ehdr.e_type;
+        elf.machine = ehdr.e_machine;
+        elf.ehsize = ehdr.e_ehsize;
+        elf.phoff = ehdr.e_phoff;
+        elf.phentsize = ehdr.e_phentsize;
+        elf.shoff = ehdr.e_shoff;
+        elf.shentsize = ehdr.e_shentsize;
+
+        auto [phnum, shnum, shstrndx] = header_counts(buf, ehdr, elf.diagnostics);
 
-        elf.shstrndx = ehdr.e_shstrndx;
+        elf.shstrndx = shstrndx;
 
-        parse_ehdr(ehdr, elf);
+        push_ehdr_info(ehdr, phnum, shnum, elf.information);
 
-        parse_phdrs(buf, ident.endianness, ehdr, elf);
+        check_entry_sizes(ehdr, phnum, shnum, elf.diagnostics);
 
-        parse_shdrs(buf, ident.endianness, ehdr, elf);
+        parse_phdrs(buf, ehdr, phnum, elf);
+
+        parse_shdrs(buf, ehdr, shnum, elf);
+
+        validate_headers(elf);
     }
 
-    void parse_ehdr(const EhdrT& ehdr, ParsedElf& elf) {
-        push_ehdr_info(ehdr, elf.information);
+    // extended numbering: counts that don't fit the 16-bit ehdr fields are stored in
+    // section 0 (sh_size for e_shnum, sh_link for e_shstrndx, sh_info for e_phnum)
+    template<class Buffer>
+    std::tuple<size_t, size_t, size_t> header_counts(const Buffer& buf, const EhdrT& ehdr,
+            std::vector<ParseDiagnostic>& diagnostics) {
+        size_t phnum = ehdr.e_phnum;
+        size_t shnum = ehdr.e_shnum;
+        size_t shstrndx = ehdr.e_shstrndx;
+
+        bool extended = shnum == 0 || phnum == PN_XNUM || shstrndx == SHN_XINDEX;
+        size_t shoff = ehdr.e_shoff;
 
-        add_ehdr_ranges(ehdr, elf.ranges);
+        if (!extended || shoff == 0) {
+            return {phnum, shnum, shstrndx};
+        }
+
+        if (shoff > buf.size() || buf.size() - shoff < sizeof(ShdrT)) {
+            diagnostics.push_back({shoff, ShdrT::describe() + " 0", "holds the extended header counts but is past the end of the file"});
+            return {(phnum == PN_XNUM) ? 0 : phnum, shnum, (shstrndx == SHN_XINDEX) ? 0 : shstrndx};
+        }
+
+        std::vector<uint8_t> scratch;
+        auto shdr0 = ShdrT::template read<big_endian>(view_range(buf, shoff, shoff + sizeof(ShdrT), scratch).data());
+
+        if (shnum == 0) {
+            shnum = shdr0.sh_size;
+        }
+        if (phnum == PN_XNUM) {
+            phnum = shdr0.sh_info;
+        }
+        if (shstrndx == SHN_XINDEX) {
+            shstrndx = shdr0.sh_link;
+        }
+
+        return {phnum, shnum, shstrndx};
+    }
+
+    // the tables are always read with the entry sizes of this class
+    void check_entry_sizes(const EhdrT& ehdr, size_t phnum, size_t shnum, std::vector<ParseDiagnostic>& diagnostics) {
+        auto check = [&](size_t value, size_t expected, const char* field) {
+            if (value != expected) {
+                diagnostics.push_back({0, EhdrT::describe(),
+                    std::string(field) + " is " + std::to_string(value) + ", not " + std::to_string(expected)});
+            }
+        };
+
+        check(ehdr.e_ehsize, sizeof(EhdrT), "e_ehsize");
+        if (phnum != 0) {
+            check(ehdr.e_phentsize, sizeof(PhdrT), "e_phentsize");
+        }
+        if (shnum != 0) {
+            check(ehdr.e_shentsize, sizeof(ShdrT), "e_shentsize");
+        }
+    }
+
+    // a corrupt count must not make us allocate or read far past the end of the file:
+    // only the entries that are inside it are read
+    template<class Buffer>
+    size_t entries_in_file(const Buffer& buf, size_t offset, size_t num, size_t entsize, const std::string& what,
+            std::vector<ParseDiagnostic>& diagnostics) {
+        size_t fit = (offset > buf.size()) ? 0 : (buf.size() - offset) / entsize;
+        if (num <= fit) {
+            return num;
+        }
+        diagnostics.push_back({offset, what + " table",
+            std::to_string(num) + " entries, only " + std::to_string(fit) + " of them inside the file"});
+        return fit;
+    }
+
+    // what the later passes would read: they clamp it with ParsedElf::file_range, so
+    // these are only recorded
+    void validate_headers(ParsedElf& elf) {
+        auto past_end = [&](size_t offset, size_t size) {
+            return offset > elf.file_size || elf.file_size - offset < size;
+        };
+        auto sum = [&](size_t offset, size_t size) {
+            return " (" + std::to_string(offset) + " + " + std::to_string(size) + " > " + std::to_string(elf.file_size) + ")";
+        };
+
+        size_t start = elf.phoff;
+
+        for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+            const auto& phdr = elf.phdrs[i];
+            auto what = PhdrT::describe() + " " + std::to_string(i);
+
+            if (phdr.file_size != 0 && past_end(phdr.file_offset, phdr.file_size)) {
+                elf.diagnostics.push_back({start, what,
+                    "p_offset + p_filesz is past the end of the file" + sum(phdr.file_offset, phdr.file_size)});
+            }
+            if (phdr.ptype == PT_LOAD && phdr.file_size > phdr.memsz) {
+                elf.diagnostics.push_back({start, what, "p_filesz is larger than p_memsz"});
+            }
+
+            start += sizeof(PhdrT);
+        }
+
+        start = elf.shoff;
+
+        for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+            const auto& shdr = elf.shdrs[i];
+            auto what = ShdrT::describe() + " " + std::to_string(i);
+
+            if (shdr.shtype != SHT_NOBITS && shdr.size != 0 && past_end(shdr.file_offset, shdr.size)) {
+                elf.diagnostics.push_back({start, what,
+                    "sh_offset + sh_size is past the end of the file" + sum(shdr.file_offset, shdr.size)});
+            }
+            if (links_section(shdr.shtype) && shdr.link >= elf.shdrs.size()) {
+                elf.diagnostics.push_back({start, what, "sh_link " + std::to_string(shdr.link) + " is not a section"});
+            }
+
+            start += sizeof(ShdrT);
+        }
+
+        if (elf.shstrndx != SHN_UNDEF && elf.shstrndx >= elf.shdrs.size()) {
+            elf.diagnostics.push_back({0, EhdrT::describe(), "e_shstrndx " + std::to_string(elf.shstrndx) + " is not a section"});
+        } else if (elf.shstrndx != SHN_UNDEF && elf.shdrs[elf.shstrndx].shtype != SHT_STRTAB) {
+            elf.diagnostics.push_back({0, EhdrT::describe(), "e_shstrndx " + std::to_string(elf.shstrndx) + " is not a string table"});
+        }
     }
 
-    void push_ehdr_info(const EhdrT& ehdr, std::vector<InfoTuple>& information) {
+    // sh_link of these names another section (string table, symbol table)
+    static bool links_section(uint32_t shtype) {
+        switch (shtype) {
+            case SHT_SYMTAB:
+            case SHT_DYNSYM:
+            case SHT_DYNAMIC:
+            case SHT_HASH:
+            case SHT_GNU_HASH:
+            case SHT_REL:
+            case SHT_RELA:
+            case SHT_SYMTAB_SHNDX:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // registers the header structures and the segments/sections they describe.
+    // called lazily from ParsedElf::build_ranges, after parse has filled elf.
+    void add_ranges(const ParsedElf& elf, Ranges& ranges) {
+        // a bogus e_ehsize is reported by validate_headers; mark what was actually read
+        bool ehsize_fits = elf.ehsize != 0 && elf.ehsize <= elf.file_size;
+        Class::add_ehdr_ranges(ehsize_fits ? elf.ehsize : sizeof(EhdrT), ranges);
+
+        size_t start = elf.phoff;
+        size_t phsize = sizeof(PhdrT);
+
+        for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+            const auto& phdr = elf.phdrs[i];
+
+            auto [segment_start, segment_end] = elf.file_range(phdr.file_offset, phdr.file_size);
+
+            if (segment_start != 0 && segment_end != segment_start) {
+                ranges.add_range(segment_start, segment_end - segment_start, new RangeTypeSegment(static_cast<uint32_t>(i)));
+            }
+
+            ranges.add_range(start, phsize, new RangeTypeProgramHeader(static_cast<uint32_t>(i)));
+
+            Class::add_phdr_ranges(start, ranges);
+
+            start += phsize;
+        }
+
+        start = elf.shoff;
+        size_t shsize = sizeof(ShdrT);
+
+        for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+            const auto& shdr = elf.shdrs[i];
+
+            auto [section_start, section_end] = elf.file_range(shdr.file_offset, shdr.size);
+
+            if (section_start != 0 && section_end != section_start && shdr.shtype != SHT_NOBITS) {
+                ranges.add_range(section_start, section_end - section_start, new RangeTypeSection(static_cast<uint32_t>(i)));
+            }
+
+            ranges.add_range(start, shsize, new RangeTypeSectionHeader(static_cast<uint32_t>(i)));
+
+            Class::add_shdr_ranges(start, ranges);
+
+            start += shsize;
+        }
+    }
+
+    void push_ehdr_info(const EhdrT& ehdr, size_t phnum, size_t shnum, std::vector<InfoTuple>& information) {
         information.emplace_back("e_type", "Type", type_to_string(ehdr.e_type));
 
         information.emplace_back(
@@ -48,17 +254,13 @@ struct ElfXX {
         information.emplace_back(
             "ph",
             "Program headers",
-            std::string("<span id='info_e_phnum'>") + std::to_string(ehdr.e_phnum) + std::string("</span> * ") +
-            std::string("<span id='info_e_phentsize'>") + std::to_string(ehdr.e_phentsize) + std::string("</span> @ ") +
-            std::string("<span id='info_e_phoff'>") + std::to_string(ehdr.e_phoff) + std::string("</span>")
+            std::to_string(phnum) + " * " + std::to_string(ehdr.e_phentsize) + " @ " + std::to_string(ehdr.e_phoff)
         );
 
         information.emplace_back(
             "sh",
             "Section headers",
-            std::string("<span id='info_e_shnum'>") + std::to_string(ehdr.e_shnum) + std::string("</span> * ") +
-            std::string("<span id='info_e_shentsize'>") + std::to_string(ehdr.e_shentsize) + std::string("</span> @ ") +
-            std::string("<span id='info_e_shoff'>") + std::to_string(ehdr.e_shoff) + std::string("</span>")
+            std::to_string(shnum) + " * " + std::to_string(ehdr.e_shentsize) + " @ " + std::to_string(ehdr.e_shoff)
         );
 
         if (static_cast<uint32_t>(ehdr.e_flags) != 0) {
@@ -66,28 +268,25 @@ struct ElfXX {
         }
     }
 
-    virtual void add_ehdr_ranges(const EhdrT& ehdr, Ranges& ranges) = 0;
-
-    void parse_phdrs(const std::vector<uint8_t>& buf, uint8_t endianness, const EhdrT& ehdr, ParsedElf& elf) {
+    template<class Buffer>
+    void parse_phdrs(const Buffer& buf, const EhdrT& ehdr, size_t phnum, ParsedElf& elf) {
         size_t start = ehdr.e_phoff;
         size_t phsize = sizeof(PhdrT);
 
-        for (int i = 0; i < ehdr.e_phnum; ++i) {
-            PhdrT phdr = PhdrT::from_bytes(byte_range(buf, start, start + phsize), endianness);
-            auto parsed = parse_phdr(phdr);
-            auto& ranges = elf.ranges;
-
-            if (parsed.file_offset != 0 && parsed.file_size != 0) {
-                ranges.add_range(parsed.file_offset, parsed.file_size, new RangeTypeSegment(i));
-            }
+        phnum = entries_in_file(buf, start, phnum, phsize, PhdrT::describe(), elf.diagnostics);
+        if (phnum == 0) {
+            return;
+        }
 
-            ranges.add_range(start, phsize, new RangeTypeProgramHeader(static_cast<uint32_t>(i)));
+        std::vector<uint8_t> scratch;
+        auto table = view_range(buf, start, start + phnum * phsize, scratch);
 
-            add_phdr_ranges(start, ranges);
+        elf.phdrs.reserve(phnum);
 
-            elf.phdrs.emplace_back(parsed);
+        for (size_t i = 0; i < phnum; ++i) {
+            auto phdr = PhdrT::template read<big_endian>(table.data() + i * phsize);
 
-            start += phsize;
+            elf.phdrs.emplace_back(parse_phdr(phdr));
         }
     }
 
@@ -100,7 +299,7 @@ struct ElfXX {
 
         return ParsedPhdr{
             phdr.p_type,
-            pflags_to_string(phdr.p_flags),
+            phdr.p_flags,
             file_offset,
             file_size,
             vaddr,
@@ -109,32 +308,29 @@ struct ElfXX {
         };
     }
 
-    virtual void add_phdr_ranges(size_t start, Ranges& ranges) = 0;
-
-    void parse_shdrs(const std::vector<uint8_t>& buf, uint8_t endianness, const EhdrT& ehdr, ParsedElf& elf) {
+    template<class Buffer>
+    void parse_shdrs(const Buffer& buf, const EhdrT& ehdr, size_t shnum, ParsedElf& elf) {
         size_t start = ehdr.e_shoff;
         size_t shsize = sizeof(ShdrT);
 
-        for (int i = 0; i < ehdr.e_shnum; ++i) {
-            auto shdr = ShdrT::from_bytes(byte_range(buf, start, start + shsize), endianness);
-            auto parsed = parse_shdr(buf, shdr);
-            auto& ranges = elf.ranges;
+        shnum = entries_in_file(buf, start, shnum, shsize, ShdrT::describe(), elf.diagnostics);
+        if (shnum == 0) {
+            return;
+        }
 
-            if (parsed.file_offset != 0 && parsed.size != 0 && parsed.shtype != SHT_NOBITS) {
-                ranges.add_range(parsed.file_offset, parsed.size, new RangeTypeSection(i));
-            }
+        std::vector<uint8_t> scratch;
+        auto table = view_range(buf, start, start + shnum * shsize, scratch);
 
-            ranges.add_range(start, shsize, new RangeTypeSectionHeader(static_cast<uint32_t>(i)));
+        elf.shdrs.reserve(shnum);
 
-            add_shdr_ranges(start, ranges);
+        for (size_t i = 0; i < shnum; ++i) {
+            auto shdr = ShdrT::template read<big_endian>(table.data() + i * shsize);
 
-            elf.shdrs.emplace_back(parsed);
-
-            start += shsize;
+            elf.shdrs.emplace_back(parse_shdr(shdr));
         }
     }
 
-    ParsedShdr parse_shdr(const std::vector<uint8_t>& buf, const ShdrT& shdr) {
+    ParsedShdr parse_shdr(const ShdrT& shdr) {
         auto name = shdr.sh_name;
         auto addr = shdr.sh_addr;
         auto file_offset = shdr.sh_offset;
@@ -157,6 +353,17 @@ struct ElfXX {
             entsize,
         };
     }
+};
+
 
-    virtual void add_shdr_ranges(size_t start, Ranges& ranges) = 0;
-};
\ No newline at end of file
+// the one place the class and byte order of a file are looked at: calls visitor with the
+// ElfXX for them. unknown classes are read as 64-bit and unknown byte orders as big endian
+template<class Visitor>
+decltype(auto) visit_elf(const ParsedIdent& ident, Visitor&& visitor) {
+    bool big_endian = ident.endianness != ELF_DATA2LSB;
+
+    if (ident.class_ == ELF_CLASS32) {
+        return big_endian ? visitor(ElfXX<Elf32, true>()) : visitor(ElfXX<Elf32, false>());
+    }
+    return big_endian ? visitor(ElfXX<Elf64, true>()) : visitor(ElfXX<Elf64, false>());
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+// sections that differ between builds of the same sources: build-ids, and the
+// CRC of the separate debug file
+constexpr const char* VOLATILE_SECTIONS[] = {
+    ".note.gnu.build-id",
+    ".note.go.buildid",
+    ".gnu_debuglink",
+    ".gnu_debugaltlink",
+};
+
+
+struct ManifestEntry {
+    // a section's name, or a segment's type and ordinal among segments of that type ("LOAD#1")
+    std::string name;
+    // bytes hashed: the file image, less the ignored sections
+    uint64_t size = 0;
+    std::array<uint8_t, 32> sha256 = {};
+    uint64_t xxh64 = 0;
+};
+
+
+// SHA-256 and XXH64 of the file image of every section and segment, for telling
+// whether two builds are the same. Ignored sections are left out, and so are
+// their bytes from the digests of the segments holding them. Ranges are hashed
+// concurrently on jobs threads, largest first, straight from the mapped file
+// (streamed files aren't supported). Each range is one sequential SHA-256, so
+// the largest section bounds the time taken.
+struct HashManifest {
+    static HashManifest build(const ParsedElf& elf, const std::set<std::string>& ignored, size_t jobs = 0);
+
+    std::vector<ManifestEntry> sections;
+    std::vector<ManifestEntry> segments;
+    // names of the sections left out, in section order
+    std::vector<std::string> ignored;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+
+enum class NameKind : uint8_t {
+    section,
+    function,
+    object,
+    other,
+};
+
+
+struct NamedRange {
+    std::string name;
+    NameKind kind;
+    uint64_t file_offset;
+    uint64_t size;
+};
+
+
+// Every named section with contents and every symbol whose bytes are in the file,
+// sorted bytewise by name, so that all names starting with a prefix are one range
+// found by two binary searches. Symbols are placed through their section, which
+// also covers relocatable objects.
+struct NameIndex {
+    static NameIndex build(const ParsedElf& elf);
+
+    std::vector<NamedRange> names;
+};
@@ -1,12 +1,24 @@
 #pragma once
 
 #include <array>
+#include <map>
 #include <memory>
+#include <optional>
 #include <tuple>
 #include <vector>
 #include <set>
+#include <string>
+#include <string_view>
 
+#include <block_cache.hpp>
+#include <utils.hpp>
+
+#include "byte_stats.hpp"
+#include "core.hpp"
 #include "defs.hpp"
+#include "repeated_rows.hpp"
+#include "segment_map.hpp"
+#include "symbols.hpp"
 //#include "elf32.hpp"
 //#include "elf64.hpp"
 //#include "elfxx.hpp"
@@ -136,24 +148,24 @@ struct RangeTypeShdrField : ConfigurableRangeType<true> {
 
 
 struct RangeTypeSegment : ConfigurableRangeType<true, true, true> {
-    RangeTypeSegment(uint16_t v);
+    RangeTypeSegment(uint32_t v);
 
     std::string id() const;
     std::string class_() const;
     bool always_highlight() const;
 
-    const uint16_t value;
+    const uint32_t value;
 };
 
 
 struct RangeTypeSection : ConfigurableRangeType<true, true, true> {
-    RangeTypeSection(uint16_t v);
+    RangeTypeSection(uint32_t v);
 
     std::string id() const;
     std::string class_() const;
     bool always_highlight() const;
 
-    const uint16_t value;
+    const uint32_t value;
 };
 
 
@@ -163,20 +175,43 @@ struct RangeTypeSegmentSubrange : ConfigurableRangeType<true, false, true> {
 };
 
 
+// bytes that differ from the base file of a --diff
+struct RangeTypeChanged : ConfigurableRangeType<true> {
+    std::string class_() const;
+};
+
+
+// Range boundaries keyed by file offset. Only offsets where some range starts or
+// ends are stored, so memory is proportional to the number of ranges rather than
+// the file size.
 // Interval tree that allows querying point for all intervals that intersect it should be better.
 // We can't beat O(n * m) but the average case should improve.
 struct Ranges {
+    Ranges() = default;
+    Ranges(const Ranges&) = delete;
+    Ranges& operator=(const Ranges&) = delete;
     ~Ranges();
-    Ranges(size_t capacity);
     void add_range(size_t start, size_t end, RangeType* range_type);
+    const std::vector<RangeType*>& at(size_t point) const;
     size_t lookup_range_ends(size_t point) const;
-
-    std::vector<std::vector<RangeType*>> data;
+    // first offset >= point with a range boundary, or SIZE_MAX
+    size_t next_point(size_t point) const;
+    // the ranges that started before point and are still open there, outermost first
+    std::vector<const RangeType*> open_at(size_t point) const;
+    // once all ranges are added: records what's open every CHECKPOINT_INTERVAL points,
+    // so that open_at doesn't have to replay everything from the start of the file
+    void add_checkpoints();
+
+    static constexpr size_t CHECKPOINT_INTERVAL = 1024;
+
+    std::map<size_t, std::vector<RangeType*>> data;
+    // (point, what's open just before it), in order of point
+    std::vector<std::tuple<size_t, std::vector<const RangeType*>>> checkpoints;
 };
 
 
 struct ParsedIdent {
-    static ParsedIdent from_bytes(const std::vector<uint8_t>& buf);
+    static ParsedIdent from_bytes(const ByteView& buf);
 
     std::array<uint8_t, 4> magic;
     uint8_t class_;
@@ -189,17 +224,25 @@ struct ParsedIdent {
 
 struct StrTab {
     static StrTab empty();
-    void populate(const std::vector<uint8_t>& section, size_t section_size);
+    void populate(const ByteView& section);
+    void populate(const BlockCache& cache, size_t offset, size_t size);
     std::string get(size_t idx) const;
+    // only for tables resident in memory; streamed tables return an empty view
+    std::string_view get_view(size_t idx) const;
 
-    std::vector<uint8_t> strings;
-    size_t section_size;
+    ByteView strings;
+    const BlockCache* source = nullptr;
+    size_t source_offset = 0;
+    size_t source_size = 0;
 };
 
 
 struct Note {
-    static std::tuple<Note, size_t> from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness);
-    static std::tuple<uint32_t, uint32_t, uint32_t> read_header(const std::vector<uint8_t>& buf, uint8_t endianness);
+    template<bool big_endian>
+    static std::tuple<Note, size_t> from_bytes(const std::vector<uint8_t>& buf);
+    // n_namesz, n_descsz, n_type of the 12 byte header at p
+    template<bool big_endian>
+    static std::tuple<uint32_t, uint32_t, uint32_t> read_header(const uint8_t* p);
 
     std::vector<uint8_t> name;
     std::vector<uint8_t> desc;
@@ -209,7 +252,8 @@ struct Note {
 
 struct ParsedPhdr {
     uint32_t ptype;
-    std::string flags;
+    // PF_R | PF_W | PF_X, pflags_to_string when shown
+    uint32_t flags;
     size_t file_offset;
     size_t file_size;
     size_t vaddr;
@@ -218,6 +262,19 @@ struct ParsedPhdr {
 };
 
 
+// A problem with the file found while parsing it. Parsing never stops at these: the
+// broken structure is clamped to the file or left out and everything else is kept.
+struct ParseDiagnostic {
+    // where the broken structure starts in the file
+    size_t offset;
+    // "file header", "program header 3", "note 1 in segment 4", ...
+    std::string structure;
+    std::string problem;
+    // the headers couldn't be read at all (not an ELF file, shorter than its header)
+    bool fatal = false;
+};
+
+
 struct ParsedShdr {
     size_t name;
     uint32_t shtype;
@@ -232,25 +289,144 @@ struct ParsedShdr {
 };
 
 
+// The ELF header and the program/section header tables are decoded by parse, which
+// checks every offset, size and count in them against the file once and records what
+// doesn't fit in diagnostics; later passes read contents through file_range.
+// Everything derived from file contents or from both header tables (ranges, string
+// tables, notes, symbols, core info, section-to-segment mapping, byte statistics)
+// is computed on first access and cached, so callers that only need the header
+// information never touch the rest of the file. The caches are not synchronized: compute them before
+// sharing a ParsedElf between threads.
 struct ParsedElf {
-    static ParsedElf from_bytes(const std::string& filename, const std::vector<uint8_t>& buf);
+    // never throws: a file without usable headers gets a fatal diagnostic and no tables
+    static ParsedElf parse(const std::string& filename, const ByteView& buf);
+    // like parse, but throws std::runtime_error on a fatal diagnostic
+    static ParsedElf from_bytes(const std::string& filename, const ByteView& buf);
+    // streaming mode: contents stay empty and every read goes through the cache; never
+    // throws either
+    static ParsedElf parse(const std::string& filename, const BlockCache& source);
+    template<class Buffer>
+    static void parse_headers(ParsedElf& elf, const ParsedIdent& ident, const Buffer& buf);
+    template<bool big_endian>
+    void validate_notes();
+    // [start, end) of the part of offset + size that is inside the file
+    std::tuple<size_t, size_t> file_range(size_t offset, size_t size) const;
+    bool headers_parsed() const;
+    std::vector<uint8_t> read_bytes(size_t start, size_t end) const;
+    // a view of [start, end): into contents when mapped, into scratch when streamed
+    ByteView bytes(size_t start, size_t end, std::vector<uint8_t>& scratch) const;
     void push_file_info();
     void push_ident_info(const ParsedIdent& ident);
-    void add_ident_ranges();
-    std::optional<ParsedShdr> find_strtab_shdr(const std::vector<ParsedShdr>& shdrs);
-    void parse_string_tables();
-    void parse_notes(uint8_t endianness);
-    void parse_note_area(size_t area_start, size_t area_size, uint8_t endianness);
+    void add_ident_ranges(Ranges& ranges) const;
+    void add_note_ranges(Ranges& ranges) const;
+    void add_highlight_ranges(Ranges& ranges) const;
+    std::optional<ParsedShdr> find_strtab_shdr(const std::vector<ParsedShdr>& shdrs) const;
+    void parse_string_tables() const;
+    void parse_notes() const;
+    template<bool big_endian>
+    void parse_note_area(size_t offset, size_t size) const;
+    void build_ranges() const;
+
+    const Ranges& ranges() const {
+        if (!ranges_cache) {
+            build_ranges();
+        }
+        return *ranges_cache;
+    }
+
+    const StrTab& strtab() const {
+        if (!strtab_cache) {
+            parse_string_tables();
+        }
+        return *strtab_cache;
+    }
+
+    const StrTab& shnstrtab() const {
+        if (!shnstrtab_cache) {
+            parse_string_tables();
+        }
+        return *shnstrtab_cache;
+    }
+
+    const std::vector<Note>& notes() const {
+        if (!notes_cache) {
+            parse_notes();
+        }
+        return *notes_cache;
+    }
+
+    const std::vector<ParsedSymbol>& symbols() const {
+        if (!symbols_cache) {
+            symbols_cache = parse_symbols(*this);
+        }
+        return *symbols_cache;
+    }
+
+    const SegmentMapping& segment_mapping() const {
+        if (!segment_mapping_cache) {
+            segment_mapping_cache = SegmentMapping::build(*this);
+        }
+        return *segment_mapping_cache;
+    }
+
+    const ElfByteStats& byte_stats() const {
+        if (!byte_stats_cache) {
+            byte_stats_cache = ElfByteStats::build(*this, jobs);
+        }
+        return *byte_stats_cache;
+    }
+
+    const std::vector<RepeatedRows>& repeated_rows() const {
+        if (!repeated_rows_cache) {
+            repeated_rows_cache = find_repeated_rows(*this);
+        }
+        return *repeated_rows_cache;
+    }
+
+    // only meaningful for ET_CORE files
+    const CoreInfo& core() const {
+        if (!core_cache) {
+            core_cache = parse_core(*this);
+        }
+        return *core_cache;
+    }
 
     std::string filename;
-    size_t file_size;
-    std::vector<std::tuple<std::string, std::string, std::string>> information;
-    std::vector<uint8_t> contents;
-    Ranges ranges;
+    size_t file_size = 0;
+    // plain-text (id, description, value) rows; the report generator adds markup
+    std::vector<InfoTuple> information;
+    ByteView contents;
+    const BlockCache* source = nullptr;
+    ParsedIdent ident = {};
+    uint16_t type = 0;
+    uint16_t machine = 0;
+    size_t ehsize = 0;
+    size_t phoff = 0;
+    size_t phentsize = 0;
+    size_t shoff = 0;
+    size_t shentsize = 0;
     std::vector<ParsedPhdr> phdrs;
     std::vector<ParsedShdr> shdrs;
-    StrTab strtab;
-    uint16_t shstrndx;
-    StrTab shnstrtab;
-    std::vector<Note> notes;
+    // already resolved through section 0 when the file uses extended numbering
+    size_t shstrndx = 0;
+    std::vector<ParseDiagnostic> diagnostics;
+    // (offset, length) of disjoint spans the report marks as changed; set before the ranges are built
+    std::vector<std::tuple<size_t, size_t>> highlight_spans;
+    // threads for the passes that run in parallel, 0 for one per core
+    size_t jobs = 0;
+    // separate debug file of a stripped binary (see include/debug_link.hpp); symbols and
+    // DWARF missing here are read from it. Set before either is read
+    const ParsedElf* debug_file = nullptr;
+
+    mutable std::unique_ptr<Ranges> ranges_cache;
+    mutable std::optional<StrTab> strtab_cache;
+    mutable std::optional<StrTab> shnstrtab_cache;
+    mutable std::optional<std::vector<Note>> notes_cache;
+    mutable std::optional<CoreInfo> core_cache;
+    mutable std::optional<SegmentMapping> segment_mapping_cache;
+    mutable std::optional<std::vector<ParsedSymbol>> symbols_cache;
+    mutable std::optional<ElfByteStats> byte_stats_cache;
+    mutable std::optional<std::vector<RepeatedRows>> repeated_rows_cache;
+    // (offset, length) of every note parsed into notes_cache, for the segment subranges
+    mutable std::vector<std::tuple<size_t, size_t>> note_spans;
 };
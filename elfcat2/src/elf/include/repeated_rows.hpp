@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+// bytes per row of the dump
+constexpr size_t DUMP_ROW_SIZE = 16;
+// shorter runs are dumped as is: the marker replacing a run takes a row itself
+constexpr size_t REPEAT_MIN_ROWS = 2;
+
+
+// rows first_row .. first_row + rows - 1 are copies of row first_row - 1
+struct RepeatedRows {
+    size_t first_row;
+    size_t rows;
+};
+
+
+// Runs of identical consecutive dump rows (zero padding, fill, alignment NOPs)
+// that the report collapses into one marker row. Only full rows take part, and
+// no range starts or ends inside a run, so collapsing one never drops a span
+// boundary. Found with one sequential pass over the contents; runs are in order.
+std::vector<RepeatedRows> find_repeated_rows(const ParsedElf& elf);
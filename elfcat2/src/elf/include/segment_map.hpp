@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+
+struct ParsedElf;
+
+
+// Which sections each segment contains, as in the "Section to Segment mapping"
+// of readelf -l. Computed with one sort-and-sweep over both interval sets, so it
+// stays near-linear with tens of thousands of sections.
+struct SegmentMapping {
+    static SegmentMapping build(const ParsedElf& elf);
+
+    // section indices by segment, in index order like readelf prints them
+    std::vector<std::vector<size_t>> sections_in_segment;
+    // the inverse: segment indices by section
+    std::vector<std::vector<size_t>> segments_of_section;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+enum class SizeLevel {
+    segments,
+    sections,
+    symbols,
+    compile_units,
+};
+
+
+struct SizeRow {
+    std::string label;
+    uint64_t file_size = 0;
+    uint64_t vm_size = 0;
+};
+
+
+struct SizeDelta {
+    std::string label;
+    int64_t file_delta = 0;
+    int64_t vm_delta = 0;
+    // the base sizes, for relative changes
+    uint64_t base_file_size = 0;
+    uint64_t base_vm_size = 0;
+};
+
+
+// bloaty-style attribution: every byte of the file, and separately every byte of
+// the PT_LOAD memory image, goes to exactly one label of the chosen level.
+// Levels nest: bytes no symbol or compile unit claims are labelled with their
+// section ("[section .text]"), bytes no section claims are "[unclaimed]", or
+// "[alignment]" when they only pad up to the alignment of the next section.
+// Each level is an interval sweep over the headers, the symbol table and
+// .debug_aranges; no other contents are read.
+struct SizeReport {
+    static SizeReport build(const ParsedElf& elf, SizeLevel level);
+
+    // largest first, by file size then VM size
+    std::vector<SizeRow> rows;
+    uint64_t file_total = 0;
+    uint64_t vm_total = 0;
+};
+
+
+std::optional<SizeLevel> parse_size_level(const std::string& text);
+// labels present in either report, largest absolute change first; unchanged ones are dropped
+std::vector<SizeDelta> diff_size_reports(const SizeReport& current, const SizeReport& base);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+enum class StringEncoding {
+    ascii,
+    utf16le,
+    utf16be,
+};
+
+
+struct FoundString {
+    // file offset and length in bytes
+    size_t offset;
+    size_t size;
+    // section holding it, none for bytes outside every section
+    std::optional<size_t> section;
+};
+
+
+// Printable runs of at least min_length characters (0x20-0x7e and tab), like
+// strings -a, but never crossing a section boundary. The mapped file is cut
+// into chunks scanned on jobs threads, 8 bytes at a time: a SWAR range check
+// classifies the word and only the places where printability flips are
+// visited. Runs cut by a chunk boundary are joined afterwards. UTF-16 strings
+// are looked for at both byte parities.
+std::vector<FoundString> scan_strings(const ParsedElf& elf, size_t min_length, StringEncoding encoding, size_t jobs = 0);
+
+// the characters of a found string, one byte each
+std::string string_text(const ParsedElf& elf, const FoundString& found, StringEncoding encoding);
+std::optional<StringEncoding> parse_string_encoding(const std::string& text);
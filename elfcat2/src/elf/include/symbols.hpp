@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+struct ParsedElf;
+
+
+struct ParsedSymbol {
+    std::string name;
+    uint64_t value;
+    uint64_t size;
+    uint8_t type;
+    uint8_t bind;
+    // already resolved through SHT_SYMTAB_SHNDX when st_shndx is SHN_XINDEX
+    uint32_t shndx;
+    // st_shndx is SHN_ABS, SHN_COMMON or another reserved value (SHN_XINDEX without a
+    // table entry included); shndx then holds it and names no section, even in files
+    // with that many
+    bool reserved_shndx = false;
+};
+
+
+// Entries of .symtab, of the debug file's .symtab or of .dynsym for stripped files, in table order
+// (the null symbol 0 included, so indices match the file).
+std::vector<ParsedSymbol> parse_symbols(const ParsedElf& elf);
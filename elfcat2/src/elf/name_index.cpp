@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include <stats.hpp>
+
+#include "include/defs.hpp"
+#include "include/name_index.hpp"
+
+
+namespace {
+
+NameKind symbol_kind(uint8_t type) {
+    switch (type) {
+        case STT_FUNC:
+            return NameKind::function;
+        case STT_OBJECT:
+        case STT_TLS:
+            return NameKind::object;
+        default:
+            return NameKind::other;
+    }
+}
+
+}
+
+
+NameIndex NameIndex::build(const ParsedElf& elf) {
+    STATS_PHASE(phase, "name_index");
+
+    NameIndex index;
+
+    for (const auto& shdr : elf.shdrs) {
+        auto name = elf.shnstrtab().get(shdr.name);
+        auto [start, end] = elf.file_range(shdr.file_offset, shdr.size);
+        if (name.empty() || shdr.shtype == SHT_NOBITS || start == end) {
+            continue;
+        }
+        index.names.push_back({name, NameKind::section, start, end - start});
+    }
+
+    // st_value of TLS symbols is relative to the TLS segment, except in relocatable objects
+    uint64_t tls_vaddr = 0;
+    for (const auto& phdr : elf.phdrs) {
+        if (phdr.ptype == PT_TLS) {
+            tls_vaddr = phdr.vaddr;
+        }
+    }
+    bool relocatable = elf.type == ELF_ET_REL;
+
+    for (const auto& symbol : elf.symbols()) {
+        if (symbol.name.empty() || symbol.type == STT_SECTION || symbol.type == STT_FILE
+                || symbol.reserved_shndx || symbol.shndx == SHN_UNDEF || symbol.shndx >= elf.shdrs.size()) {
+            continue;
+        }
+
+        const auto& shdr = elf.shdrs[symbol.shndx];
+        if (shdr.shtype == SHT_NOBITS) {
+            continue;
+        }
+
+        uint64_t value = symbol.value;
+        if (symbol.type == STT_TLS && !relocatable) {
+            value += tls_vaddr;
+        }
+
+        // offset into the section
+        uint64_t base = relocatable ? 0 : shdr.addr;
+        if (value < base || value - base > shdr.size) {
+            continue;
+        }
+        uint64_t start = shdr.file_offset + (value - base);
+        uint64_t size = std::min(symbol.size, shdr.size - (value - base));
+        if (start >= elf.file_size) {
+            continue;
+        }
+
+        auto [file_start, file_end] = elf.file_range(start, size);
+
+        index.names.push_back({symbol.name, symbol_kind(symbol.type), file_start, file_end - file_start});
+    }
+
+    // std::string compares bytes as unsigned char, which is the order the report's
+    // search expects
+    std::sort(index.names.begin(), index.names.end(), [](const auto& lhs, const auto& rhs) {
+        int order = lhs.name.compare(rhs.name);
+        return (order != 0) ? order < 0 : lhs.file_offset < rhs.file_offset;
+    });
+
+    return index;
+}
@@ -1,13 +1,14 @@
 #include <algorithm>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <variant>
 
+#include <stats.hpp>
 #include <utils.hpp>
 
 #include "include/parser.hpp"
-#include "include/elf32.hpp"
-#include "include/elf64.hpp"
+#include "include/elfxx.hpp"
 
 
 std::string RangeType::span_attributes() const {
@@ -76,7 +77,7 @@ std::string RangeTypeShdrField::class_() const {
     return value + std::string(" shdr_hover");
 }
 
-RangeTypeSegment::RangeTypeSegment(uint16_t v) : value(v) {}
+RangeTypeSegment::RangeTypeSegment(uint32_t v) : value(v) {}
 
 std::string RangeTypeSegment::id() const {
     return std::string("bin_segment") + std::to_string(value);
@@ -90,7 +91,7 @@ bool RangeTypeSegment::always_highlight() const {
     return true;
 }
 
-RangeTypeSection::RangeTypeSection(uint16_t v) : value(v) {}
+RangeTypeSection::RangeTypeSection(uint32_t v) : value(v) {}
 
 std::string RangeTypeSection::id() const {
     return std::string("bin_section") + std::to_string(value);
@@ -112,28 +113,93 @@ bool RangeTypeSegmentSubrange::always_highlight() const {
     return true;
 }
 
+std::string RangeTypeChanged::class_() const {
+    return std::string("changed");
+}
+
 Ranges::~Ranges() {
-    for (auto& range : data) {
+    for (auto& [point, range] : data) {
         for (auto range_type : range) {
             delete range_type;
         }
     }
 }
 
-Ranges::Ranges(size_t capacity) {
-    data.resize(capacity);
-}
-
 void Ranges::add_range(size_t start, size_t end, RangeType* range_type) {
     data[start].emplace_back(range_type);
     data[start + end - 1].emplace_back(new RangeTypeEnd());
 }
 
+const std::vector<RangeType*>& Ranges::at(size_t point) const {
+    static const std::vector<RangeType*> none;
+
+    auto found = data.find(point);
+    return (found == data.end()) ? none : found->second;
+}
+
 size_t Ranges::lookup_range_ends(size_t point) const {
-    return std::count_if(data[point].begin(), data[point].end(), [](const auto& item){ return item->is_end(); });
+    const auto& range = at(point);
+    return std::count_if(range.begin(), range.end(), [](const auto& item){ return item->is_end(); });
+}
+
+size_t Ranges::next_point(size_t point) const {
+    auto found = data.lower_bound(point);
+    return (found == data.end()) ? SIZE_MAX : found->first;
+}
+
+namespace {
+
+// the starts at one point are opened before its ends close the innermost spans, like
+// the markup of the dump does
+void apply_point(std::vector<const RangeType*>& open, const std::vector<RangeType*>& range_types) {
+    size_t ends = 0;
+    for (const auto& range_type : range_types) {
+        if (range_type->is_end()) {
+            ++ends;
+        } else {
+            open.push_back(range_type);
+        }
+    }
+    open.resize(open.size() - std::min(ends, open.size()));
+}
+
+}
+
+std::vector<const RangeType*> Ranges::open_at(size_t point) const {
+    // last checkpoint at or before point
+    auto checkpoint = std::upper_bound(checkpoints.cbegin(), checkpoints.cend(), point,
+        [](size_t point, const auto& checkpoint) { return point < std::get<0>(checkpoint); });
+
+    std::vector<const RangeType*> open;
+    auto it = data.cbegin();
+    if (checkpoint != checkpoints.cbegin()) {
+        --checkpoint;
+        open = std::get<1>(*checkpoint);
+        it = data.find(std::get<0>(*checkpoint));
+    }
+
+    for (; it != data.cend() && it->first < point; ++it) {
+        apply_point(open, it->second);
+    }
+
+    return open;
+}
+
+void Ranges::add_checkpoints() {
+    checkpoints.clear();
+
+    std::vector<const RangeType*> open;
+    size_t seen = 0;
+
+    for (const auto& [point, range_types] : data) {
+        if (seen++ % CHECKPOINT_INTERVAL == 0) {
+            checkpoints.emplace_back(point, open);
+        }
+        apply_point(open, range_types);
+    }
 }
 
-ParsedIdent ParsedIdent::from_bytes(const std::vector<uint8_t>& buf) {
+ParsedIdent ParsedIdent::from_bytes(const ByteView& buf) {
     return ParsedIdent{
         {buf[0], buf[1], buf[2], buf[3]},
         buf[static_cast<size_t>(ELF_EI_CLASS)],
@@ -144,48 +210,156 @@ ParsedIdent ParsedIdent::from_bytes(const std::vector<uint8_t>& buf) {
     };
 }
 
-ParsedElf ParsedElf::from_bytes(const std::string& filename, const std::vector<uint8_t>& buf) {
+ParsedElf ParsedElf::parse(const std::string& filename, const ByteView& buf) {
+    ParsedElf elf;
+    elf.filename = filename;
+    elf.file_size = buf.size();
+    elf.contents = buf;
+
     if (buf.size() < static_cast<size_t>(ELF_EI_NIDENT)) {
-        throw std::runtime_error("file is smaller than ELF header's e_ident");
+        elf.diagnostics.push_back({0, "e_ident", "file is smaller than ELF header's e_ident", true});
+        return elf;
+    }
+
+    parse_headers(elf, ParsedIdent::from_bytes(buf), buf);
+
+    return elf;
+}
+
+ParsedElf ParsedElf::from_bytes(const std::string& filename, const ByteView& buf) {
+    auto elf = parse(filename, buf);
+
+    if (!elf.headers_parsed()) {
+        throw std::runtime_error(elf.diagnostics.back().problem);
+    }
+
+    return elf;
+}
+
+ParsedElf ParsedElf::parse(const std::string& filename, const BlockCache& source) {
+    ParsedElf elf;
+    elf.filename = filename;
+    elf.file_size = source.size();
+    elf.source = &source;
+
+    if (source.size() < static_cast<size_t>(ELF_EI_NIDENT)) {
+        elf.diagnostics.push_back({0, "e_ident", "file is smaller than ELF header's e_ident", true});
+        return elf;
     }
 
-    auto ident = ParsedIdent::from_bytes(buf);
+    auto ident_bytes = byte_range(source, 0, ELF_EI_NIDENT);
 
+    parse_headers(elf, ParsedIdent::from_bytes(ident_bytes), source);
+
+    return elf;
+}
+
+template<class Buffer>
+void ParsedElf::parse_headers(ParsedElf& elf, const ParsedIdent& ident, const Buffer& buf) {
     if (ident.magic != std::array<uint8_t, 4>{0x7f, 'E', 'L', 'F'}) {
-        throw std::runtime_error("mismatched magic: not an ELF file");
+        elf.diagnostics.push_back({0, "e_ident", "mismatched magic: not an ELF file", true});
+        return;
     }
 
-    ParsedElf elf{
-        filename,
-        buf.size(),
-        {},
-        buf,
-        Ranges(buf.size()),
-        {},
-        {},
-        StrTab::empty(),
-        0,
-        StrTab::empty(),
-        {},
-    };
+    elf.ident = ident;
 
     elf.push_file_info();
 
     elf.push_ident_info(ident);
 
-    if (ident.class_ == ELF_CLASS32) {
-        Elf32().parse(buf, ident, elf);
-    } else {
-        Elf64().parse(buf, ident, elf);
+    if (ident.class_ != ELF_CLASS32 && ident.class_ != ELF_CLASS64) {
+        elf.diagnostics.push_back({ELF_EI_CLASS, "e_ident", "EI_CLASS is " + std::to_string(ident.class_) + ", read as 64-bit"});
+    }
+    if (ident.endianness != ELF_DATA2LSB && ident.endianness != ELF_DATA2MSB) {
+        elf.diagnostics.push_back({ELF_EI_DATA, "e_ident", "EI_DATA is " + std::to_string(ident.endianness) + ", read as big endian"});
     }
 
-    elf.add_ident_ranges();
+    visit_elf(ident, [&](auto layout) {
+        layout.parse(buf, elf);
+
+        if (elf.headers_parsed()) {
+            elf.validate_notes<decltype(layout)::big_endian>();
+        }
+    });
+}
 
-    elf.parse_string_tables();
+// notes are parsed when they're first asked for, but their headers are checked up front
+// so that the diagnostics are complete once parse returns
+template<bool big_endian>
+void ParsedElf::validate_notes() {
+    auto align4 = [](size_t value) { return (value + 3) & ~size_t(3); };
 
-    elf.parse_notes(ident.endianness);
+    for (size_t i = 0; i < phdrs.size(); ++i) {
+        if (phdrs[i].ptype != PT_NOTE) {
+            continue;
+        }
 
-    return elf;
+        auto [start, end] = file_range(phdrs[i].file_offset, phdrs[i].file_size);
+        size_t index = 0;
+
+        for (size_t at = start; at < end; ++index) {
+            auto what = "note " + std::to_string(index) + " in segment " + std::to_string(i);
+
+            if (end - at < 12) {
+                diagnostics.push_back({at, what, "header is cut off by the end of the segment"});
+                break;
+            }
+
+            auto [namesz, descsz, ntype] = Note::read_header<big_endian>(read_bytes(at, at + 12).data());
+            size_t size = 12 + align4(namesz) + align4(descsz);
+
+            if (size > end - at) {
+                diagnostics.push_back({at, what, "n_namesz + n_descsz run past the end of the segment ("
+                    + std::to_string(namesz) + " + " + std::to_string(descsz) + " > " + std::to_string(end - at - 12) + ")"});
+                break;
+            }
+
+            at += size;
+        }
+    }
+}
+
+std::tuple<size_t, size_t> ParsedElf::file_range(size_t offset, size_t size) const {
+    size_t start = std::min(offset, file_size);
+    return {start, start + std::min(size, file_size - start)};
+}
+
+bool ParsedElf::headers_parsed() const {
+    return diagnostics.empty() || !diagnostics.back().fatal;
+}
+
+std::vector<uint8_t> ParsedElf::read_bytes(size_t start, size_t end) const {
+    if (source != nullptr) {
+        return byte_range(*source, start, end);
+    }
+    return byte_range(contents, start, end);
+}
+
+ByteView ParsedElf::bytes(size_t start, size_t end, std::vector<uint8_t>& scratch) const {
+    if (source != nullptr) {
+        scratch.resize(end - start);
+        source->read(start, end, scratch.data());
+        return ByteView(scratch);
+    }
+    return contents.subview(start, end);
+}
+
+void ParsedElf::build_ranges() const {
+    STATS_PHASE(phase, "ranges");
+
+    auto ranges = std::make_unique<Ranges>();
+
+    visit_elf(ident, [&](auto layout) { layout.add_ranges(*this, *ranges); });
+
+    add_ident_ranges(*ranges);
+
+    add_note_ranges(*ranges);
+
+    add_highlight_ranges(*ranges);
+
+    ranges->add_checkpoints();
+
+    ranges_cache = std::move(ranges);
 }
 
 void ParsedElf::push_file_info() {
@@ -207,7 +381,7 @@ void ParsedElf::push_ident_info(const ParsedIdent& ident) {
             ident_class = "64-bit";
             break;
         default:
-            ident_class = "Unknown bitness: " + ident.class_;
+            ident_class = "Unknown bitness: " + std::to_string(ident.class_);
     }
     
     information.emplace_back(
@@ -257,7 +431,7 @@ void ParsedElf::push_ident_info(const ParsedIdent& ident) {
     }
 }
 
-void ParsedElf::add_ident_ranges() {
+void ParsedElf::add_ident_ranges(Ranges& ranges) const {
     ranges.add_range(0, static_cast<size_t>(ELF_EI_NIDENT), new RangeTypeIdent());
     ranges.add_range(0, 4, new RangeTypeHeaderField("magic"));
     ranges.add_range(4, 1, new RangeTypeHeaderField("class"));
@@ -268,7 +442,22 @@ void ParsedElf::add_ident_ranges() {
     ranges.add_range(9, 7, new RangeTypeHeaderField("pad"));
 }
 
-std::optional<ParsedShdr> ParsedElf::find_strtab_shdr(const std::vector<ParsedShdr>& shdrs) {
+void ParsedElf::add_note_ranges(Ranges& ranges) const {
+    notes();
+
+    for (auto [start, len] : note_spans) {
+        ranges.add_range(start, len, new RangeTypeSegmentSubrange());
+    }
+}
+
+// added last so that they open inside the section spans starting at the same offset
+void ParsedElf::add_highlight_ranges(Ranges& ranges) const {
+    for (auto [start, len] : highlight_spans) {
+        ranges.add_range(start, len, new RangeTypeChanged());
+    }
+}
+
+std::optional<ParsedShdr> ParsedElf::find_strtab_shdr(const std::vector<ParsedShdr>& shdrs) const {
     for (const auto& shdr : shdrs) {
         if (shdr.shtype == SHT_STRTAB) {
             return shdr;
@@ -278,108 +467,138 @@ std::optional<ParsedShdr> ParsedElf::find_strtab_shdr(const std::vector<ParsedSh
     return std::nullopt;
 }
 
-void ParsedElf::parse_string_tables() {
+void ParsedElf::parse_string_tables() const {
+    STATS_PHASE(phase, "string_tables");
+
+    strtab_cache = StrTab::empty();
+    shnstrtab_cache = StrTab::empty();
+
     auto shdr = ParsedElf::find_strtab_shdr(shdrs);
 
-    if (shdr) {
-        const auto& section = byte_range(contents, shdr->file_offset, shdr->file_offset + shdr->size);
+    auto populate = [this](StrTab& table, const ParsedShdr& shdr) {
+        auto [start, end] = file_range(shdr.file_offset, shdr.size);
+        if (source != nullptr) {
+            table.populate(*source, start, end - start);
+        } else {
+            table.populate(contents.subview(start, end));
+        }
+    };
 
-        strtab.populate(section, shdr->size);
+    if (shdr) {
+        populate(*strtab_cache, *shdr);
     }
 
-    if (shstrndx != SHN_UNDEF) {
-        const auto& shdr = shdrs[static_cast<size_t>(shstrndx)];
-        const auto& section = byte_range(contents, shdr.file_offset, shdr.file_offset + shdr.size);
-
-        shnstrtab.populate(section, shdr.size);
+    if (shstrndx != SHN_UNDEF && shstrndx < shdrs.size()) {
+        populate(*shnstrtab_cache, shdrs[shstrndx]);
     }
 }
 
-void ParsedElf::parse_notes(uint8_t endianness) {
-    std::vector<std::tuple<size_t, size_t>> areas;
+void ParsedElf::parse_notes() const {
+    STATS_PHASE(phase, "notes");
 
-    for (const auto& phdr : phdrs) {
-        if (phdr.ptype == PT_NOTE) {
-            areas.emplace_back(phdr.file_offset, phdr.file_size);
-        }
-    }
+    notes_cache.emplace();
+    note_spans.clear();
 
-    for (auto[start, len] : areas) {
-        parse_note_area(start, len, endianness);
-    }
+    visit_elf(ident, [&](auto layout) {
+        for (const auto& phdr : phdrs) {
+            if (phdr.ptype == PT_NOTE) {
+                parse_note_area<decltype(layout)::big_endian>(phdr.file_offset, phdr.file_size);
+            }
+        }
+    });
 }
 
 // this is pretty ugly in terms of raw addressing, unwieldly offsets, etc.
 // area here stands for segment or section because notes may come from either of them.
-void ParsedElf::parse_note_area(size_t area_start, size_t area_size, uint8_t endianness) {
-    const auto& area = byte_range(contents, area_start, area_start + area_size);
-    auto start = 0;
+template<bool big_endian>
+void ParsedElf::parse_note_area(size_t offset, size_t size) const {
+    auto [area_start, area_end] = file_range(offset, size);
+    size_t area_size = area_end - area_start;
+    const auto& area = read_bytes(area_start, area_end);
+    size_t start = 0;
 
     for (;;) {
         if (start >= area_size) {
             break;
         }
 
-        const auto& [note, len_taken] = Note::from_bytes(byte_range(area, start, area_size), endianness);
+        const auto& [note, len_taken] = Note::from_bytes<big_endian>(byte_range(area, start, area_size));
 
-        ranges.add_range(
-            area_start + start,
-            len_taken,
-            new RangeTypeSegmentSubrange()
-        );
-        notes.emplace_back(note);
+        note_spans.emplace_back(area_start + start, len_taken);
+        notes_cache->emplace_back(note);
         start += len_taken;
     }
 }
 
-std::tuple<Note, size_t> Note::from_bytes(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    auto [namesz, descsz, ntype] = Note::read_header(buf, endianness);
+template<bool big_endian>
+std::tuple<Note, size_t> Note::from_bytes(const std::vector<uint8_t>& buf) {
+    if (buf.size() < 12) {
+        return {Note{{}, {}, 0}, buf.size()};
+    }
 
-    auto name = byte_range(buf, 12, 12 + namesz);
-    auto desc = byte_range(buf, 12 + namesz, 12 + namesz + descsz);
+    auto [namesz, descsz, ntype] = Note::read_header<big_endian>(buf.data());
 
-    size_t len = 12 + namesz + descsz;
+    // both name and desc are padded to 4 bytes; truncated notes are clamped to the area
+    auto align4 = [](size_t value) { return (value + 3) & ~size_t(3); };
+    size_t name_end = std::min<size_t>(12 + size_t(namesz), buf.size());
+    size_t desc_start = std::min<size_t>(12 + align4(namesz), buf.size());
+    size_t desc_end = std::min<size_t>(desc_start + descsz, buf.size());
 
-    while (len % 4 != 0) {
-        ++len;
-    }
+    auto name = byte_range(buf, 12, name_end);
+    auto desc = byte_range(buf, desc_start, desc_end);
+
+    size_t len = std::min<size_t>(desc_start + align4(descsz), buf.size());
 
     return {Note{name, desc, ntype}, len};
 }
 
-std::tuple<uint32_t, uint32_t, uint32_t> Note::read_header(const std::vector<uint8_t>& buf, uint8_t endianness) {
-    if (endianness == ELF_DATA2LSB) {
-        return std::make_tuple(
-            ::from_le_bytes<uint32_t>(byte_range(buf, 0, 4)),
-            ::from_le_bytes<uint32_t>(byte_range(buf, 4, 8)),
-            ::from_le_bytes<uint32_t>(byte_range(buf, 8, 12))
-        );
-    }
+template<bool big_endian>
+std::tuple<uint32_t, uint32_t, uint32_t> Note::read_header(const uint8_t* p) {
     return std::make_tuple(
-        from_be_bytes<uint32_t>(byte_range(buf, 0, 4)),
-        from_be_bytes<uint32_t>(byte_range(buf, 4, 8)),
-        from_be_bytes<uint32_t>(byte_range(buf, 8, 12))
+        load_bytes<uint32_t, big_endian>(p),
+        load_bytes<uint32_t, big_endian>(p + 4),
+        load_bytes<uint32_t, big_endian>(p + 8)
     );
 }
 
 // decently ugly
 StrTab StrTab::empty() {
-    return StrTab{{}, 0};
+    return StrTab{};
 }
 
-// something could be better than references with lifetimes
-void StrTab::populate(const std::vector<uint8_t>& section, size_t section_size) {
+// the view points into ParsedElf::contents and lives as long as it does
+void StrTab::populate(const ByteView& section) {
     strings = section;
-    section_size = section_size;
+}
+
+// streamed tables are read string by string through the cache, never as a whole
+void StrTab::populate(const BlockCache& cache, size_t offset, size_t size) {
+    source = &cache;
+    source_offset = offset;
+    source_size = size;
 }
 
 std::string StrTab::get(size_t idx) const {
-    auto start_idx = idx;
+    if (source == nullptr) {
+        return std::string(get_view(idx));
+    }
 
-    for (auto end_idx = start_idx; end_idx < start_idx + section_size; ++end_idx) {
-        if (strings[end_idx] == 0) {
-            return std::string(strings.cbegin() + start_idx, strings.cbegin() + end_idx);
+    std::string result;
+    for (auto end_idx = idx; end_idx < source_size; ++end_idx) {
+        auto ch = source->at(source_offset + end_idx);
+        if (ch == 0) {
+            return result;
         }
+        result += static_cast<char>(ch);
     }
     return "";
 }
+
+std::string_view StrTab::get_view(size_t idx) const {
+    for (auto end_idx = idx; end_idx < strings.size(); ++end_idx) {
+        if (strings[end_idx] == 0) {
+            return std::string_view(reinterpret_cast<const char*>(strings.data()) + idx, end_idx - idx);
+        }
+    }
+    return {};
+}
@@ -0,0 +1,73 @@
+#include <cstring>
+
+#include <stats.hpp>
+
+#include "include/parser.hpp"
+#include "include/repeated_rows.hpp"
+
+
+namespace {
+
+// rows compared per elf.bytes call; with --stream that MiB is all the scan keeps in memory
+constexpr size_t CHUNK_ROWS = (1 << 20) / DUMP_ROW_SIZE;
+
+}
+
+
+std::vector<RepeatedRows> find_repeated_rows(const ParsedElf& elf) {
+    const auto& ranges = elf.ranges();
+
+    STATS_PHASE(phase, "repeated_rows");
+
+    std::vector<RepeatedRows> runs;
+    size_t full_rows = elf.file_size / DUMP_ROW_SIZE;
+    if (full_rows < 2) {
+        return runs;
+    }
+
+    std::vector<uint8_t> scratch;
+    uint8_t previous[DUMP_ROW_SIZE];
+    size_t run_start = 0;
+    size_t run_rows = 0;
+    // first range start or end at or after the current row
+    size_t next_boundary = ranges.next_point(DUMP_ROW_SIZE);
+
+    auto close_run = [&] {
+        if (run_rows >= REPEAT_MIN_ROWS) {
+            runs.push_back({run_start, run_rows});
+        }
+        run_rows = 0;
+    };
+
+    std::memcpy(previous, elf.bytes(0, DUMP_ROW_SIZE, scratch).data(), DUMP_ROW_SIZE);
+
+    for (size_t chunk_start = 1; chunk_start < full_rows; chunk_start += CHUNK_ROWS) {
+        size_t chunk_end = std::min(full_rows, chunk_start + CHUNK_ROWS);
+        auto chunk = elf.bytes(chunk_start * DUMP_ROW_SIZE, chunk_end * DUMP_ROW_SIZE, scratch);
+
+        for (size_t row = chunk_start; row < chunk_end; ++row) {
+            const uint8_t* bytes = chunk.data() + (row - chunk_start) * DUMP_ROW_SIZE;
+            size_t row_offset = row * DUMP_ROW_SIZE;
+
+            if (next_boundary < row_offset) {
+                next_boundary = ranges.next_point(row_offset);
+            }
+
+            bool boundary = next_boundary < row_offset + DUMP_ROW_SIZE;
+            if (!boundary && std::memcmp(bytes, previous, DUMP_ROW_SIZE) == 0) {
+                if (run_rows == 0) {
+                    run_start = row;
+                }
+                ++run_rows;
+                continue;
+            }
+
+            close_run();
+            std::memcpy(previous, bytes, DUMP_ROW_SIZE);
+        }
+    }
+
+    close_run();
+
+    return runs;
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdint>
+
+#include <stats.hpp>
+
+#include "include/defs.hpp"
+#include "include/parser.hpp"
+#include "include/segment_map.hpp"
+
+
+namespace {
+
+bool is_tbss(const ParsedShdr& shdr) {
+    return (shdr.flags & SHF_TLS) && shdr.shtype == SHT_NOBITS;
+}
+
+// the readelf rules, roughly: allocated sections must sit inside the segment's
+// memory image, and inside its file image too when they have contents; .tbss
+// only belongs to PT_TLS; non-allocated sections only to non-PT_LOAD segments
+// (by file offset). Empty sections count when they start inside the segment.
+bool section_in_segment(const ParsedShdr& shdr, const ParsedPhdr& phdr) {
+    if (is_tbss(shdr) && phdr.ptype != PT_TLS) {
+        return false;
+    }
+
+    auto contains = [](uint64_t start, uint64_t size, uint64_t inner_start, uint64_t inner_size) {
+        if (inner_start < start) {
+            return false;
+        }
+        if (inner_size == 0) {
+            return inner_start < start + size || (size == 0 && inner_start == start);
+        }
+        return inner_start - start <= size && inner_size <= size - (inner_start - start);
+    };
+
+    bool has_file_image = shdr.shtype != SHT_NOBITS;
+
+    if (shdr.flags & SHF_ALLOC) {
+        if (!contains(phdr.vaddr, phdr.memsz, shdr.addr, shdr.size)) {
+            return false;
+        }
+        return !has_file_image || contains(phdr.file_offset, phdr.file_size, shdr.file_offset, shdr.size);
+    }
+
+    return phdr.ptype != PT_LOAD && has_file_image
+        && contains(phdr.file_offset, phdr.file_size, shdr.file_offset, shdr.size);
+}
+
+struct SweepItem {
+    uint64_t start;
+    uint64_t end;
+    size_t index;
+};
+
+// items sorted by start. Segments are added to the active set as the sweep
+// reaches them and dropped once they end before the current section starts;
+// only active segments are tested, and they rarely nest more than a few deep.
+template<class Accept>
+void sweep(std::vector<SweepItem>& sections, std::vector<SweepItem>& segments, Accept accept) {
+    auto by_start = [](const auto& lhs, const auto& rhs) { return lhs.start < rhs.start; };
+    std::sort(sections.begin(), sections.end(), by_start);
+    std::sort(segments.begin(), segments.end(), by_start);
+
+    std::vector<SweepItem> active;
+    size_t next_segment = 0;
+
+    for (const auto& section : sections) {
+        while (next_segment < segments.size() && segments[next_segment].start <= section.start) {
+            active.push_back(segments[next_segment]);
+            ++next_segment;
+        }
+
+        active.erase(std::remove_if(active.begin(), active.end(), [&](const auto& segment) {
+            // zero-sized segments still hold empty sections starting at their start
+            return segment.end < section.start || (segment.end == section.start && segment.start != segment.end);
+        }), active.end());
+
+        for (const auto& segment : active) {
+            accept(section.index, segment.index);
+        }
+    }
+}
+
+}
+
+
+SegmentMapping SegmentMapping::build(const ParsedElf& elf) {
+    STATS_PHASE(phase, "segment_map");
+
+    SegmentMapping mapping;
+    mapping.sections_in_segment.resize(elf.phdrs.size());
+    mapping.segments_of_section.resize(elf.shdrs.size());
+
+    auto accept = [&](size_t section, size_t segment) {
+        if (section_in_segment(elf.shdrs[section], elf.phdrs[segment])) {
+            mapping.sections_in_segment[segment].push_back(section);
+            mapping.segments_of_section[section].push_back(segment);
+        }
+    };
+
+    // allocated sections are swept in address space, the rest by file offset
+    std::vector<SweepItem> alloc_sections;
+    std::vector<SweepItem> file_sections;
+
+    for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+        const auto& shdr = elf.shdrs[i];
+        if (shdr.shtype == SHT_NULL) {
+            continue;
+        }
+        if (shdr.flags & SHF_ALLOC) {
+            alloc_sections.push_back({shdr.addr, shdr.addr + shdr.size, i});
+        } else if (shdr.shtype != SHT_NOBITS) {
+            file_sections.push_back({shdr.file_offset, shdr.file_offset + shdr.size, i});
+        }
+    }
+
+    std::vector<SweepItem> segment_vaddrs;
+    std::vector<SweepItem> segment_offsets;
+
+    for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+        const auto& phdr = elf.phdrs[i];
+        segment_vaddrs.push_back({phdr.vaddr, phdr.vaddr + phdr.memsz, i});
+        segment_offsets.push_back({phdr.file_offset, phdr.file_offset + phdr.file_size, i});
+    }
+
+    sweep(alloc_sections, segment_vaddrs, accept);
+    sweep(file_sections, segment_offsets, accept);
+
+    for (auto& sections : mapping.sections_in_segment) {
+        std::sort(sections.begin(), sections.end());
+    }
+
+    for (auto& segments : mapping.segments_of_section) {
+        std::sort(segments.begin(), segments.end());
+    }
+
+    return mapping;
+}
@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+#include <stats.hpp>
+
+#include "include/defs.hpp"
+#include "include/dwarf.hpp"
+#include "include/parser.hpp"
+#include "include/size_report.hpp"
+
+
+namespace {
+
+// labels are interned so that pieces stay small with millions of symbols
+struct Labels {
+    uint32_t id(const std::string& label) {
+        auto [found, inserted] = ids.emplace(label, static_cast<uint32_t>(names.size()));
+        if (inserted) {
+            names.push_back(label);
+        }
+        return found->second;
+    }
+
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+
+// [start, end) owned by label
+struct Piece {
+    uint64_t start;
+    uint64_t end;
+    uint32_t label;
+};
+
+
+// sorted by start with overlaps resolved in favour of whoever starts first
+std::vector<Piece> normalize(std::vector<Piece> claims) {
+    std::stable_sort(claims.begin(), claims.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.start < rhs.start;
+    });
+
+    std::vector<Piece> result;
+    result.reserve(claims.size());
+
+    for (auto claim : claims) {
+        if (!result.empty()) {
+            claim.start = std::max(claim.start, result.back().end);
+        }
+        if (claim.start < claim.end) {
+            result.push_back(claim);
+        }
+    }
+
+    return result;
+}
+
+// Lays claims over a partition: claimed bytes take the claim's label, the rest
+// keep the label of the piece below, passed through wrap. Both inputs are sorted
+// and non-overlapping, so this is one merge-like pass.
+template<class Wrap>
+std::vector<Piece> overlay(const std::vector<Piece>& base, std::vector<Piece> claims, Wrap wrap) {
+    claims = normalize(std::move(claims));
+
+    std::vector<Piece> result;
+    size_t next = 0;
+
+    auto emit = [&](uint64_t start, uint64_t end, uint32_t label) {
+        if (start >= end) {
+            return;
+        }
+        if (!result.empty() && result.back().end == start && result.back().label == label) {
+            result.back().end = end;
+        } else {
+            result.push_back({start, end, label});
+        }
+    };
+
+    for (const auto& piece : base) {
+        while (next < claims.size() && claims[next].end <= piece.start) {
+            ++next;
+        }
+
+        uint64_t pos = piece.start;
+        uint32_t below = wrap(piece.label);
+
+        for (size_t i = next; i < claims.size() && claims[i].start < piece.end; ++i) {
+            const auto& claim = claims[i];
+            uint64_t claim_start = std::max(claim.start, pos);
+            uint64_t claim_end = std::min(claim.end, piece.end);
+
+            emit(pos, claim_start, below);
+            emit(claim_start, claim_end, claim.label);
+            pos = std::max(pos, claim_end);
+        }
+
+        emit(pos, piece.end, below);
+    }
+
+    return result;
+}
+
+// most padding that may precede whatever starts at an offset: up to the alignment
+// for an aligned section, anything short of p_align in front of a segment (file
+// offsets only have to be congruent to the address there)
+using Padding = std::unordered_map<uint64_t, uint64_t>;
+
+void allow_padding(Padding& padding, uint64_t start, uint64_t align, bool congruent) {
+    if (align <= 1 || (!congruent && start % align != 0)) {
+        return;
+    }
+    auto& allowed = padding[start];
+    allowed = std::max(allowed, align - 1);
+}
+
+void mark_alignment(std::vector<Piece>& pieces, const Padding& padding, uint32_t unclaimed, uint32_t alignment) {
+    for (auto& piece : pieces) {
+        if (piece.label != unclaimed) {
+            continue;
+        }
+        auto found = padding.find(piece.end);
+        if (found != padding.end() && piece.end - piece.start <= found->second) {
+            piece.label = alignment;
+        }
+    }
+}
+
+
+struct Builder {
+    bool is_tbss(const ParsedShdr& shdr) const {
+        return (shdr.flags & SHF_TLS) && shdr.shtype == SHT_NOBITS;
+    }
+
+    std::string section_name(size_t idx) const {
+        auto name = elf.shnstrtab().get(elf.shdrs[idx].name);
+        return name.empty() ? "[section " + std::to_string(idx) + "]" : name;
+    }
+
+    // PT_LOAD pieces of the memory image, in address order
+    std::vector<Piece> vm_domain(bool label_segments) {
+        std::vector<Piece> loads;
+        for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+            const auto& phdr = elf.phdrs[i];
+            if (phdr.ptype == PT_LOAD) {
+                auto label = label_segments ? segment_label(i) : unclaimed;
+                loads.push_back({phdr.vaddr, phdr.vaddr + phdr.memsz, label});
+            }
+        }
+        return normalize(std::move(loads));
+    }
+
+    uint32_t segment_label(size_t idx) {
+        return labels.id("LOAD #" + std::to_string(idx) + " [" + std::string(pflags_to_string(elf.phdrs[idx].flags)) + "]");
+    }
+
+    std::vector<Piece> file_segments() {
+        std::vector<Piece> loads;
+        for (size_t i = 0; i < elf.phdrs.size(); ++i) {
+            const auto& phdr = elf.phdrs[i];
+            if (phdr.ptype == PT_LOAD) {
+                loads.push_back({phdr.file_offset, phdr.file_offset + phdr.file_size, segment_label(i)});
+            }
+        }
+        return overlay({{0, elf.file_size, labels.id("[unmapped]")}}, std::move(loads), [](uint32_t label) { return label; });
+    }
+
+    std::vector<Piece> header_claims() {
+        std::vector<Piece> claims;
+
+        claims.push_back({0, elf.ehsize, labels.id("[ELF header]")});
+        if (!elf.phdrs.empty()) {
+            claims.push_back({elf.phoff, elf.phoff + elf.phdrs.size() * elf.phentsize, labels.id("[program headers]")});
+        }
+        if (!elf.shdrs.empty()) {
+            claims.push_back({elf.shoff, elf.shoff + elf.shdrs.size() * elf.shentsize, labels.id("[section headers]")});
+        }
+
+        return claims;
+    }
+
+    std::vector<Piece> file_sections() {
+        auto claims = header_claims();
+        Padding padding;
+
+        if (!elf.shdrs.empty()) {
+            allow_padding(padding, elf.shoff, elf.ident.class_ == ELF_CLASS32 ? 4 : 8, false);
+        }
+        for (const auto& phdr : elf.phdrs) {
+            if (phdr.ptype == PT_LOAD) {
+                allow_padding(padding, phdr.file_offset, phdr.alignment, true);
+            }
+        }
+
+        for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+            const auto& shdr = elf.shdrs[i];
+            if (shdr.shtype == SHT_NULL || shdr.shtype == SHT_NOBITS) {
+                continue;
+            }
+            claims.push_back({shdr.file_offset, shdr.file_offset + shdr.size, labels.id(section_name(i))});
+            allow_padding(padding, shdr.file_offset, shdr.addralign, false);
+        }
+
+        auto pieces = overlay({{0, elf.file_size, unclaimed}}, std::move(claims), [](uint32_t label) { return label; });
+        mark_alignment(pieces, padding, unclaimed, alignment);
+        return pieces;
+    }
+
+    std::vector<Piece> vm_sections() {
+        std::vector<Piece> claims;
+        Padding padding;
+
+        // the headers are usually loaded along with the first segment
+        for (const auto& claim : header_claims()) {
+            file_to_vm(claim.start, claim.end, claim.label, claims);
+        }
+
+        for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+            const auto& shdr = elf.shdrs[i];
+            if (!(shdr.flags & SHF_ALLOC) || is_tbss(shdr)) {
+                continue;
+            }
+            claims.push_back({shdr.addr, shdr.addr + shdr.size, labels.id(section_name(i))});
+            allow_padding(padding, shdr.addr, shdr.addralign, false);
+        }
+
+        auto pieces = overlay(vm_domain(false), std::move(claims), [](uint32_t label) { return label; });
+        mark_alignment(pieces, padding, unclaimed, alignment);
+        return pieces;
+    }
+
+    // "[section .text]" for bytes of .text nobody finer-grained claims
+    uint32_t wrap_section(uint32_t label) {
+        const auto& name = labels.names[label];
+        if (!name.empty() && name[0] == '[') {
+            return label;
+        }
+        auto found = wrapped.find(label);
+        if (found != wrapped.end()) {
+            return found->second;
+        }
+        auto id = labels.id("[section " + name + "]");
+        wrapped[label] = id;
+        return id;
+    }
+
+    // file ranges backing [start, end) of the memory image, through the PT_LOADs
+    void vm_to_file(uint64_t start, uint64_t end, uint32_t label, std::vector<Piece>& out) const {
+        for (const auto& phdr : elf.phdrs) {
+            if (phdr.ptype != PT_LOAD) {
+                continue;
+            }
+            uint64_t file_end = phdr.vaddr + phdr.file_size;
+            uint64_t s = std::max(start, phdr.vaddr);
+            uint64_t e = std::min(end, file_end);
+            if (s < e) {
+                out.push_back({phdr.file_offset + (s - phdr.vaddr), phdr.file_offset + (e - phdr.vaddr), label});
+            }
+        }
+    }
+
+    void file_to_vm(uint64_t start, uint64_t end, uint32_t label, std::vector<Piece>& out) const {
+        for (const auto& phdr : elf.phdrs) {
+            if (phdr.ptype != PT_LOAD) {
+                continue;
+            }
+            uint64_t s = std::max<uint64_t>(start, phdr.file_offset);
+            uint64_t e = std::min<uint64_t>(end, phdr.file_offset + phdr.file_size);
+            if (s < e) {
+                out.push_back({phdr.vaddr + (s - phdr.file_offset), phdr.vaddr + (e - phdr.file_offset), label});
+            }
+        }
+    }
+
+    // (vm claims, file claims) of the symbols with a size
+    std::tuple<std::vector<Piece>, std::vector<Piece>> symbol_claims() {
+        std::vector<Piece> vm;
+        std::vector<Piece> file;
+        bool relocatable = elf.type == ELF_ET_REL;
+
+        for (const auto& symbol : elf.symbols()) {
+            if (symbol.size == 0 || symbol.type == STT_SECTION || symbol.type == STT_FILE || symbol.type == STT_TLS) {
+                continue;
+            }
+            if (symbol.reserved_shndx || symbol.shndx == SHN_UNDEF || symbol.shndx >= elf.shdrs.size()) {
+                continue;
+            }
+
+            auto label = labels.id(symbol.name.empty() ? "[unnamed symbol]" : symbol.name);
+
+            if (relocatable) {
+                // values are section-relative and nothing is loaded
+                const auto& shdr = elf.shdrs[symbol.shndx];
+                if (shdr.shtype != SHT_NOBITS) {
+                    uint64_t start = shdr.file_offset + symbol.value;
+                    file.push_back({start, start + symbol.size, label});
+                }
+                continue;
+            }
+
+            vm.push_back({symbol.value, symbol.value + symbol.size, label});
+            vm_to_file(symbol.value, symbol.value + symbol.size, label, file);
+        }
+
+        return {std::move(vm), std::move(file)};
+    }
+
+    std::tuple<std::vector<Piece>, std::vector<Piece>> compile_unit_claims() {
+        std::vector<Piece> vm;
+        std::vector<Piece> file;
+
+        for (const auto& unit : parse_compile_unit_ranges(elf)) {
+            auto label = labels.id(unit.name);
+            vm.push_back({unit.start, unit.end, label});
+            vm_to_file(unit.start, unit.end, label, file);
+        }
+
+        return {std::move(vm), std::move(file)};
+    }
+
+    std::tuple<std::vector<Piece>, std::vector<Piece>> pieces(SizeLevel level) {
+        if (level == SizeLevel::segments) {
+            return {vm_domain(true), file_segments()};
+        }
+
+        auto vm = vm_sections();
+        auto file = file_sections();
+
+        if (level == SizeLevel::sections) {
+            return {std::move(vm), std::move(file)};
+        }
+
+        auto [vm_claims, file_claims] = (level == SizeLevel::symbols) ? symbol_claims() : compile_unit_claims();
+        auto wrap = [this](uint32_t label) { return wrap_section(label); };
+
+        return {overlay(vm, std::move(vm_claims), wrap), overlay(file, std::move(file_claims), wrap)};
+    }
+
+    const ParsedElf& elf;
+    Labels labels = {};
+    std::unordered_map<uint32_t, uint32_t> wrapped = {};
+    uint32_t unclaimed = labels.id("[unclaimed]");
+    uint32_t alignment = labels.id("[alignment]");
+};
+
+}
+
+
+SizeReport SizeReport::build(const ParsedElf& elf, SizeLevel level) {
+    STATS_PHASE(phase, "sizes");
+
+    Builder builder{elf};
+    auto [vm, file] = builder.pieces(level);
+
+    std::vector<SizeRow> rows(builder.labels.names.size());
+    SizeReport report;
+
+    for (const auto& piece : file) {
+        rows[piece.label].file_size += piece.end - piece.start;
+        report.file_total += piece.end - piece.start;
+    }
+    for (const auto& piece : vm) {
+        rows[piece.label].vm_size += piece.end - piece.start;
+        report.vm_total += piece.end - piece.start;
+    }
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].file_size != 0 || rows[i].vm_size != 0) {
+            rows[i].label = builder.labels.names[i];
+            report.rows.push_back(std::move(rows[i]));
+        }
+    }
+
+    std::sort(report.rows.begin(), report.rows.end(), [](const auto& lhs, const auto& rhs) {
+        return std::make_tuple(lhs.file_size, lhs.vm_size, rhs.label) > std::make_tuple(rhs.file_size, rhs.vm_size, lhs.label);
+    });
+
+    return report;
+}
+
+std::optional<SizeLevel> parse_size_level(const std::string& text) {
+    static const std::map<std::string, SizeLevel> level_mapping {
+        {"segments", SizeLevel::segments},
+        {"sections", SizeLevel::sections},
+        {"symbols", SizeLevel::symbols},
+        {"compileunits", SizeLevel::compile_units},
+    };
+
+    auto iterator = level_mapping.find(text);
+
+    if (iterator != level_mapping.end()) {
+        return iterator->second;
+    }
+
+    return std::nullopt;
+}
+
+std::vector<SizeDelta> diff_size_reports(const SizeReport& current, const SizeReport& base) {
+    std::map<std::string, SizeDelta> deltas;
+
+    for (const auto& row : current.rows) {
+        auto& delta = deltas[row.label];
+        delta.file_delta += static_cast<int64_t>(row.file_size);
+        delta.vm_delta += static_cast<int64_t>(row.vm_size);
+    }
+    for (const auto& row : base.rows) {
+        auto& delta = deltas[row.label];
+        delta.file_delta -= static_cast<int64_t>(row.file_size);
+        delta.vm_delta -= static_cast<int64_t>(row.vm_size);
+        delta.base_file_size = row.file_size;
+        delta.base_vm_size = row.vm_size;
+    }
+
+    std::vector<SizeDelta> result;
+    for (auto& [label, delta] : deltas) {
+        if (delta.file_delta != 0 || delta.vm_delta != 0) {
+            delta.label = label;
+            result.push_back(std::move(delta));
+        }
+    }
+
+    auto magnitude = [](const SizeDelta& delta) {
+        return std::make_tuple(std::abs(delta.file_delta), std::abs(delta.vm_delta));
+    };
+    std::stable_sort(result.begin(), result.end(), [&](const auto& lhs, const auto& rhs) {
+        return magnitude(lhs) > magnitude(rhs);
+    });
+
+    return result;
+}
@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+
+#include <parallel.hpp>
+#include <stats.hpp>
+
+#include "include/address_index.hpp"
+#include "include/string_scan.hpp"
+
+
+namespace {
+
+constexpr size_t SCAN_CHUNK = 1 << 20;
+constexpr uint64_t ONES = 0x0101010101010101ULL;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+constexpr std::array<bool, 256> make_printable_table() {
+    std::array<bool, 256> table{};
+    for (size_t i = 0x20; i <= 0x7e; ++i) {
+        table[i] = true;
+    }
+    table['\t'] = true;
+    return table;
+}
+
+constexpr auto PRINTABLE = make_printable_table();
+
+
+// high bit of every byte in 0x20-0x7e; tabs aren't included and take the slow path
+uint64_t printable_mask(uint64_t word) {
+    uint64_t low = word & ~HIGH_BITS;
+    uint64_t at_least_20 = low + (0x80 - 0x20) * ONES;
+    uint64_t at_least_7f = low + (0x80 - 0x7f) * ONES;
+    return at_least_20 & ~at_least_7f & ~word & HIGH_BITS;
+}
+
+bool has_tab(uint64_t word) {
+    uint64_t x = word ^ ('\t' * ONES);
+    return ((x - ONES) & ~x & HIGH_BITS) != 0;
+}
+
+
+// [start, end) of the file inside one section, or outside all of them
+struct Region {
+    size_t start;
+    size_t end;
+    std::optional<size_t> section;
+};
+
+
+struct Piece {
+    size_t start;
+    size_t end;
+    size_t region;
+};
+
+
+// a run of printable characters; the first and last run of a piece may continue
+// into its neighbours, so these are kept whatever their length
+struct Run {
+    size_t start;
+    size_t end;
+};
+
+
+struct PieceRuns {
+    std::vector<Run> runs;
+    // the first run starts at the first character of the piece, the last ends at its last
+    bool open_start = false;
+    bool open_end = false;
+};
+
+
+void scan_ascii(const uint8_t* data, size_t start, size_t end, size_t min_length, PieceRuns& out) {
+    size_t run_start = start;
+    size_t i = start;
+    bool in_run = false;
+
+    auto close = [&](size_t at) {
+        bool at_edge = run_start == start;
+        if (at - run_start >= min_length || at_edge) {
+            out.runs.push_back({run_start, at});
+        }
+        in_run = false;
+    };
+
+    while (i < end) {
+        if (i + 8 <= end) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            uint64_t mask = printable_mask(word);
+
+            if (mask == HIGH_BITS) {
+                if (!in_run) {
+                    run_start = i;
+                    in_run = true;
+                }
+                i += 8;
+                continue;
+            }
+            if (!has_tab(word)) {
+                // one bit per byte, at the bottom of it; walk the places where
+                // printability flips instead of the bytes
+                uint64_t bits = mask >> 7;
+                uint64_t changes = bits ^ ((bits << 8) | (in_run ? 1 : 0));
+                while (changes != 0) {
+                    size_t byte = __builtin_ctzll(changes) / 8;
+                    if ((bits >> (byte * 8)) & 1) {
+                        run_start = i + byte;
+                        in_run = true;
+                    } else {
+                        close(i + byte);
+                    }
+                    changes &= changes - 1;
+                }
+                i += 8;
+                continue;
+            }
+        }
+
+        if (PRINTABLE[data[i]]) {
+            if (!in_run) {
+                run_start = i;
+                in_run = true;
+            }
+        } else if (in_run) {
+            close(i);
+        }
+        ++i;
+    }
+
+    if (in_run) {
+        out.runs.push_back({run_start, end});
+        out.open_end = true;
+    }
+    out.open_start = !out.runs.empty() && out.runs.front().start == start;
+}
+
+// units at offsets of the given parity, [start, end) holding their first bytes
+void scan_utf16(const uint8_t* data, size_t start, size_t end, size_t limit, size_t parity, bool big_endian,
+        size_t min_length, PieceRuns& out) {
+    size_t first = start + ((start % 2 == parity) ? 0 : 1);
+    size_t run_start = first;
+    bool in_run = false;
+    size_t i = first;
+
+    for (; i < end && i + 2 <= limit; i += 2) {
+        uint8_t character = big_endian ? data[i + 1] : data[i];
+        uint8_t high = big_endian ? data[i] : data[i + 1];
+        bool printable = high == 0 && PRINTABLE[character];
+
+        if (printable && !in_run) {
+            run_start = i;
+            in_run = true;
+        } else if (!printable && in_run) {
+            if ((i - run_start) / 2 >= min_length || run_start == first) {
+                out.runs.push_back({run_start, i});
+            }
+            in_run = false;
+        }
+    }
+
+    if (in_run) {
+        out.runs.push_back({run_start, i});
+        out.open_end = true;
+    }
+    out.open_start = !out.runs.empty() && out.runs.front().start == first;
+}
+
+std::vector<Region> regions_of(const ParsedElf& elf) {
+    auto index = AddressIndex::build(elf);
+    std::vector<Region> regions;
+    size_t pos = 0;
+
+    for (const auto& interval : index.sections_by_offset.intervals) {
+        auto end = std::min<size_t>(interval.end, elf.file_size);
+        if (interval.start >= end) {
+            continue;
+        }
+        if (pos < interval.start) {
+            regions.push_back({pos, interval.start, std::nullopt});
+        }
+        regions.push_back({interval.start, end, interval.index});
+        pos = end;
+    }
+    if (pos < elf.file_size) {
+        regions.push_back({pos, elf.file_size, std::nullopt});
+    }
+
+    return regions;
+}
+
+}
+
+
+std::vector<FoundString> scan_strings(const ParsedElf& elf, size_t min_length, StringEncoding encoding, size_t jobs) {
+    STATS_PHASE(phase, "strings");
+
+    min_length = std::max<size_t>(min_length, 1);
+
+    auto regions = regions_of(elf);
+    std::vector<Piece> pieces;
+    for (size_t r = 0; r < regions.size(); ++r) {
+        for (size_t start = regions[r].start; start < regions[r].end; start += SCAN_CHUNK) {
+            pieces.push_back({start, std::min(regions[r].end, start + SCAN_CHUNK), r});
+        }
+    }
+
+    bool utf16 = encoding != StringEncoding::ascii;
+    size_t unit = utf16 ? 2 : 1;
+    size_t passes = utf16 ? 2 : 1;
+    std::vector<PieceRuns> results(pieces.size() * passes);
+    const uint8_t* data = elf.contents.data();
+
+    parallel_for(results.size(), jobs, [&](size_t i) {
+        const auto& piece = pieces[i / passes];
+        if (utf16) {
+            scan_utf16(data, piece.start, piece.end, regions[piece.region].end, i % passes,
+                    encoding == StringEncoding::utf16be, min_length, results[i]);
+        } else {
+            scan_ascii(data, piece.start, piece.end, min_length, results[i]);
+        }
+    });
+
+    std::vector<FoundString> found;
+
+    for (size_t parity = 0; parity < passes; ++parity) {
+        // a run left open by the previous piece of the same region
+        std::optional<Run> pending;
+        std::optional<size_t> pending_region;
+
+        auto flush = [&] {
+            if (pending && (pending->end - pending->start) / unit >= min_length) {
+                found.push_back({pending->start, pending->end - pending->start, regions[*pending_region].section});
+            }
+            pending.reset();
+        };
+
+        for (size_t p = 0; p < pieces.size(); ++p) {
+            auto& result = results[p * passes + parity];
+            bool continues = pending && pending_region == pieces[p].region && result.open_start
+                && pending->end == result.runs.front().start;
+
+            for (size_t r = 0; r < result.runs.size(); ++r) {
+                auto run = result.runs[r];
+                if (r == 0 && continues) {
+                    run.start = pending->start;
+                    pending.reset();
+                } else {
+                    flush();
+                }
+                pending = run;
+                pending_region = pieces[p].region;
+                if (r + 1 < result.runs.size() || !result.open_end) {
+                    flush();
+                }
+            }
+            if (!result.open_end) {
+                flush();
+            }
+        }
+        flush();
+    }
+
+    if (passes > 1) {
+        std::sort(found.begin(), found.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.offset < rhs.offset;
+        });
+    }
+
+    return found;
+}
+
+std::string string_text(const ParsedElf& elf, const FoundString& found, StringEncoding encoding) {
+    const uint8_t* data = elf.contents.data() + found.offset;
+
+    if (encoding == StringEncoding::ascii) {
+        return std::string(reinterpret_cast<const char*>(data), found.size);
+    }
+
+    std::string text;
+    text.reserve(found.size / 2);
+    size_t low = encoding == StringEncoding::utf16le ? 0 : 1;
+    for (size_t i = 0; i + 1 < found.size; i += 2) {
+        text += static_cast<char>(data[i + low]);
+    }
+    return text;
+}
+
+std::optional<StringEncoding> parse_string_encoding(const std::string& text) {
+    // strings -e letters are accepted too
+    static const std::map<std::string, StringEncoding> encoding_mapping {
+        {"ascii", StringEncoding::ascii},
+        {"s", StringEncoding::ascii},
+        {"utf16le", StringEncoding::utf16le},
+        {"l", StringEncoding::utf16le},
+        {"utf16be", StringEncoding::utf16be},
+        {"b", StringEncoding::utf16be},
+    };
+
+    auto iterator = encoding_mapping.find(text);
+
+    if (iterator != encoding_mapping.end()) {
+        return iterator->second;
+    }
+
+    return std::nullopt;
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <optional>
+#include <tuple>
+
+#include <block_cache.hpp>
+#include <stats.hpp>
+
+#include "include/defs.hpp"
+#include "include/elfxx.hpp"
+#include "include/parser.hpp"
+#include "include/symbols.hpp"
+
+
+namespace {
+
+std::optional<size_t> find_symbol_table(const ParsedElf& elf) {
+    std::optional<size_t> dynsym;
+
+    for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+        if (elf.shdrs[i].shtype == SHT_SYMTAB) {
+            return i;
+        }
+        if (elf.shdrs[i].shtype == SHT_DYNSYM && !dynsym) {
+            dynsym = i;
+        }
+    }
+
+    return dynsym;
+}
+
+std::optional<size_t> find_shndx_table(const ParsedElf& elf, size_t symtab) {
+    for (size_t i = 0; i < elf.shdrs.size(); ++i) {
+        if (elf.shdrs[i].shtype == SHT_SYMTAB_SHNDX && elf.shdrs[i].link == symtab) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+template<class Layout>
+std::vector<ParsedSymbol> parse_symbol_table(const ParsedElf& elf, size_t symtab) {
+    using SymT = typename Layout::SymT;
+
+    const auto& shdr = elf.shdrs[symtab];
+    size_t entsize = sizeof(SymT);
+    auto [table_start, table_end] = elf.file_range(shdr.file_offset, shdr.size);
+    size_t count = (table_end - table_start) / entsize;
+
+    StrTab names = StrTab::empty();
+    if (shdr.link < elf.shdrs.size()) {
+        const auto& strtab = elf.shdrs[shdr.link];
+        auto [start, end] = elf.file_range(strtab.file_offset, strtab.size);
+        if (elf.source != nullptr) {
+            names.populate(*elf.source, start, end - start);
+        } else {
+            names.populate(elf.contents.subview(start, end));
+        }
+    }
+
+    std::optional<std::tuple<size_t, size_t>> shndx_range;
+    if (auto shndx_table = find_shndx_table(elf, symtab)) {
+        const auto& table = elf.shdrs[*shndx_table];
+        shndx_range = elf.file_range(table.file_offset, table.size);
+    }
+
+    std::vector<ParsedSymbol> symbols;
+    symbols.reserve(count);
+
+    // a streamed table is decoded a cache block at a time, so the scratch copies
+    // stay as small as the blocks; a mapped one is viewed whole
+    size_t chunk = elf.source != nullptr ? std::max<size_t>(1, elf.source->block_size / entsize) : count;
+    std::vector<uint8_t> scratch;
+    std::vector<uint8_t> shndx_scratch;
+
+    for (size_t first = 0; first < count; first += chunk) {
+        size_t last = std::min(count, first + chunk);
+        auto table = elf.bytes(table_start + first * entsize, table_start + last * entsize, scratch);
+
+        // the SHT_SYMTAB_SHNDX entries of the same symbols, as far as the table has them
+        ByteView shndx_bytes;
+        if (shndx_range) {
+            auto [start, end] = *shndx_range;
+            size_t entries = (end - start) / 4;
+            if (first < entries) {
+                shndx_bytes = elf.bytes(start + first * 4, start + std::min(last, entries) * 4, shndx_scratch);
+            }
+        }
+
+        for (size_t i = first; i < last; ++i) {
+            auto sym = SymT::template read<Layout::big_endian>(table.data() + (i - first) * entsize);
+
+            uint32_t shndx = sym.st_shndx;
+            bool reserved = sym.st_shndx >= SHN_LORESERVE;
+            if (shndx == SHN_XINDEX && (i - first + 1) * 4 <= shndx_bytes.size()) {
+                shndx = load_bytes<uint32_t, Layout::big_endian>(shndx_bytes.data() + (i - first) * 4);
+                reserved = false;
+            }
+
+            symbols.push_back(ParsedSymbol{
+                names.get(sym.st_name),
+                sym.st_value,
+                sym.st_size,
+                static_cast<uint8_t>(sym.st_info & 0xf),
+                static_cast<uint8_t>(sym.st_info >> 4),
+                shndx,
+                reserved,
+            });
+        }
+    }
+
+    return symbols;
+}
+
+}
+
+
+std::vector<ParsedSymbol> parse_symbols(const ParsedElf& elf) {
+    STATS_PHASE(phase, "symbols");
+
+    auto symtab = find_symbol_table(elf);
+    // objcopy --only-keep-debug keeps the section numbering, so st_shndx still applies
+    if (elf.debug_file && (!symtab || elf.shdrs[*symtab].shtype != SHT_SYMTAB)) {
+        auto symbols = parse_symbols(*elf.debug_file);
+        if (!symbols.empty()) {
+            return symbols;
+        }
+    }
+    if (!symtab) {
+        return {};
+    }
+
+    return visit_elf(elf.ident, [&](auto layout) {
+        return parse_symbol_table<decltype(layout)>(elf, *symtab);
+    });
+}
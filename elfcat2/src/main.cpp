@@ -1,60 +1,1077 @@
+#include <atomic>
+#include <charconv>
+#include <cstring>
 #include <fstream>
 #include <iostream>
-#include <streambuf>
+#include <optional>
+#include <sstream>
+#include <set>
 #include <string>
 #include <vector>
 
+#include <sys/stat.h>
+
+#include <address_index.hpp>
+#include <archive.hpp>
+#include <block_cache.hpp>
+#include <build_id_index.hpp>
 #include <config.h>
+#include <debug_link.hpp>
+#include <defs.hpp>
+#include <file_walk.hpp>
+#include <hash.hpp>
+#include <hash_manifest.hpp>
+#include <mapped_file.hpp>
+#include <parallel.hpp>
+#include <report_cache.hpp>
+#include <size_report.hpp>
+#include <stats.hpp>
+#include <string_scan.hpp>
 
+#include "diff_gen.hpp"
+#include "manifest_gen.hpp"
 #include "report_gen.hpp"
+#include "serve.hpp"
+#include "size_gen.hpp"
+#include "watch.hpp"
+
+
+enum class StatsFormat {
+    none,
+    table,
+    json,
+};
+
+
+enum class ManifestFormat {
+    none,
+    text,
+    json,
+};
+
+
+enum class QueryMode {
+    none,
+    vaddr,
+    offset,
+};
+
+
+struct Options {
+    std::string filename;
+    StatsFormat stats = StatsFormat::none;
+    bool summary = false;
+    // 0 means map the whole file instead of streaming it
+    size_t stream_budget = 0;
+    QueryMode query = QueryMode::none;
+    std::optional<SizeLevel> sizes;
+    // diff the size report against this file instead of printing it
+    std::string size_base;
+    // compare filename against this file
+    std::string diff_base;
+    // 0 means one thread per core
+    size_t jobs = 0;
+    // minimum length of the strings to print, 0 for no strings mode
+    size_t strings = 0;
+    StringEncoding encoding = StringEncoding::ascii;
+    // write a build-id index of the directories filename and extra_files to this file
+    std::string index_output;
+    // more directories for --index, more files for --serve
+    std::vector<std::string> extra_files;
+    // filename is a build-id index, look up the build-ids read from stdin
+    bool lookup = false;
+    // searched for debug files before /usr/lib/debug
+    std::vector<std::string> debug_dirs;
+    // filename is a directory to keep rendering the reports of
+    bool watch = false;
+    // serve filename and extra_files over HTTP on this port instead of writing reports
+    std::optional<uint16_t> serve_port;
+    // keep reports here and reuse them for files with the same contents
+    std::string cache_dir;
+    uint64_t cache_budget = ReportCache::DEFAULT_BUDGET;
+    ManifestFormat manifest = ManifestFormat::none;
+    // sections the manifest leaves out
+    std::set<std::string> ignored_sections;
+    // print the parse diagnostics of filename and extra_files instead of writing reports
+    bool check = false;
+};
+
+
+// the separate debug file of a stripped binary, kept open as long as the binary's ParsedElf
+struct DebugFile {
+    MappedFile file;
+    std::optional<ParsedElf> elf;
+};
 
 
 void usage(int ret) {
-    std::cout << "Usage: elfcat <filename>" << std::endl;
+    std::cout << "Usage: elfcat [--summary] [--stream[=BUDGET] | --cache-dir DIR] [--stats[=json]] <filename>" << std::endl;
+    std::cout << "       elfcat --query[=vaddr|offset] <filename>" << std::endl;
+    std::cout << "       elfcat --sizes[=LEVEL] [--base OLD] <filename>" << std::endl;
+    std::cout << "       elfcat --diff OLD [--summary] [--jobs=N] <filename>" << std::endl;
+    std::cout << "       elfcat --strings[=MIN] [--encoding=E] [--jobs=N] <filename>" << std::endl;
+    std::cout << "       elfcat --manifest[=json] [--ignore-volatile] [--ignore-section NAME] <filename>" << std::endl;
+    std::cout << "       elfcat --index OUT [--jobs=N] <directory>..." << std::endl;
+    std::cout << "       elfcat --lookup <index>" << std::endl;
+    std::cout << "       elfcat --watch [--summary] [--jobs=N] <directory>" << std::endl;
+    std::cout << "       elfcat --serve[=PORT] <filename>..." << std::endl;
+    std::cout << "       elfcat --check [--jobs=N] <filename or directory>..." << std::endl;
     std::cout << "Writes <filename>.html to CWD." << std::endl;
+    std::cout << std::endl;
+    std::cout << "  --summary          only the file information table, without the byte dump" << std::endl;
+    std::cout << "  --stream[=BUDGET]  read the file with pread through a block cache of at most" << std::endl;
+    std::cout << "                     BUDGET bytes (K/M/G suffixes, default 64M) instead of mapping it" << std::endl;
+    std::cout << "  --stats            print per-phase timings and counters to stderr" << std::endl;
+    std::cout << "  --stats=json       same, as a single JSON object" << std::endl;
+    std::cout << "  --query[=vaddr]    read virtual addresses from stdin, one per line (0x-prefixed hex" << std::endl;
+    std::cout << "                     or decimal), and print: address, segment, section, file offset" << std::endl;
+    std::cout << "  --query=offset     same for file offsets, printing the virtual address last" << std::endl;
+    std::cout << "  --sizes[=LEVEL]    print which part of the file and of the memory image every byte" << std::endl;
+    std::cout << "                     belongs to; LEVEL is segments, sections (default), symbols or" << std::endl;
+    std::cout << "                     compileunits" << std::endl;
+    std::cout << "  --base OLD         with --sizes, print the growth since OLD instead" << std::endl;
+    std::cout << "  --diff OLD         print the sections and segments that differ from OLD and write" << std::endl;
+    std::cout << "                     <filename>.diff.html with the changed bytes marked; exits with 1" << std::endl;
+    std::cout << "                     when the files differ" << std::endl;
+    std::cout << "  --strings[=MIN]    print printable strings of at least MIN characters (default 4) with" << std::endl;
+    std::cout << "                     their file offset and section; <filename>.html#OFFSET shows them" << std::endl;
+    std::cout << "  --encoding=E       ascii (default), utf16le or utf16be; strings -e s/l/b work too" << std::endl;
+    std::cout << "  --manifest[=json]  print the SHA-256 and XXH64 of every section and segment, to" << std::endl;
+    std::cout << "                     compare builds" << std::endl;
+    std::cout << "  --ignore-section NAME  leave section NAME out of the manifest, and its bytes out of" << std::endl;
+    std::cout << "                     the segments holding it" << std::endl;
+    std::cout << "  --ignore-volatile  same for the sections that change between identical builds" << std::endl;
+    std::cout << "                     (build-ids, .gnu_debuglink)" << std::endl;
+    std::cout << "  --index OUT        write an index of the build-ids of every ELF file under the" << std::endl;
+    std::cout << "                     directories to OUT" << std::endl;
+    std::cout << "  --lookup           read hex build-ids from stdin, one per line, and print the" << std::endl;
+    std::cout << "                     path, size, class and machine of each file the index has for it" << std::endl;
+    std::cout << "  --watch            render every ELF file and archive under the directory, then again" << std::endl;
+    std::cout << "                     whenever one is rewritten (inotify); unchanged contents are skipped" << std::endl;
+    std::cout << "  --serve[=PORT]     serve the reports on http://127.0.0.1:PORT/ (default 8080) instead," << std::endl;
+    std::cout << "                     rendering the byte dump in windows as the page is scrolled" << std::endl;
+    std::cout << "  --check            print what is malformed in the files, and in the ELF files under the" << std::endl;
+    std::cout << "                     directories, one line per problem; exits with 1 if there is any" << std::endl;
+    std::cout << "  --cache-dir DIR    reuse the report of a file with the same contents and options from" << std::endl;
+    std::cout << "                     DIR, or store it there; least recently used reports are dropped" << std::endl;
+    std::cout << "                     once DIR holds more than --cache-size=SIZE bytes (default 1G);" << std::endl;
+    std::cout << "                     not with --stream or --watch" << std::endl;
+    std::cout << "  --debug-dir DIR    look for separate debug files of stripped binaries under DIR" << std::endl;
+    std::cout << "                     (by build-id and .gnu_debuglink) before /usr/lib/debug" << std::endl;
+    std::cout << "  --jobs=N           threads for the work that runs in parallel (default: all cores)" << std::endl;
     std::exit(ret);
 }
 
-std::string parse_arguments(int argc, char** argv) {
-    if (argc != 2) {
+Options parse_arguments(int argc, char** argv) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        auto argument = std::string(argv[i]);
+
+        if (argument == "-h" || argument == "--help") {
+            usage(0);
+        }
+
+        if (argument == "-v" || argument == "--version") {
+            std::cout << "elfcat " << ELFCAT_VERSION_MAJOR << "." << ELFCAT_VERSION_MAJOR << std::endl;
+            std::exit(0);
+        }
+
+        if (argument == "--summary") {
+            options.summary = true;
+        } else if (argument == "--stream") {
+            options.stream_budget = BlockCache::DEFAULT_BUDGET;
+        } else if (argument.rfind("--stream=", 0) == 0) {
+            auto budget = parse_byte_size(argument.substr(9));
+            if (!budget || *budget == 0) {
+                usage(1);
+            }
+            options.stream_budget = *budget;
+        } else if (argument == "--stats") {
+            options.stats = StatsFormat::table;
+        } else if (argument == "--stats=json") {
+            options.stats = StatsFormat::json;
+        } else if (argument == "--query" || argument == "--query=vaddr") {
+            options.query = QueryMode::vaddr;
+        } else if (argument == "--query=offset") {
+            options.query = QueryMode::offset;
+        } else if (argument == "--sizes") {
+            options.sizes = SizeLevel::sections;
+        } else if (argument.rfind("--sizes=", 0) == 0) {
+            options.sizes = parse_size_level(argument.substr(8));
+            if (!options.sizes) {
+                usage(1);
+            }
+        } else if (argument == "--base") {
+            if (i + 1 == argc) {
+                usage(1);
+            }
+            options.size_base = argv[++i];
+        } else if (argument == "--diff") {
+            if (i + 1 == argc) {
+                usage(1);
+            }
+            options.diff_base = argv[++i];
+        } else if (argument == "--strings") {
+            options.strings = 4;
+        } else if (argument.rfind("--strings=", 0) == 0) {
+            auto text = argument.substr(10);
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), options.strings);
+            if (error != std::errc() || end != text.data() + text.size() || options.strings == 0) {
+                usage(1);
+            }
+        } else if (argument.rfind("--encoding=", 0) == 0) {
+            auto encoding = parse_string_encoding(argument.substr(11));
+            if (!encoding) {
+                usage(1);
+            }
+            options.encoding = *encoding;
+        } else if (argument.rfind("--jobs=", 0) == 0) {
+            auto text = argument.substr(7);
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), options.jobs);
+            if (error != std::errc() || end != text.data() + text.size() || options.jobs == 0) {
+                usage(1);
+            }
+        } else if (argument == "--index") {
+            if (i + 1 == argc) {
+                usage(1);
+            }
+            options.index_output = argv[++i];
+        } else if (argument == "--debug-dir") {
+            if (i + 1 == argc) {
+                usage(1);
+            }
+            options.debug_dirs.push_back(argv[++i]);
+        } else if (argument == "--manifest") {
+            options.manifest = ManifestFormat::text;
+        } else if (argument == "--manifest=json") {
+            options.manifest = ManifestFormat::json;
+        } else if (argument == "--ignore-section") {
+            if (i + 1 == argc) {
+                usage(1);
+            }
+            options.ignored_sections.insert(argv[++i]);
+        } else if (argument == "--ignore-volatile") {
+            options.ignored_sections.insert(std::begin(VOLATILE_SECTIONS), std::end(VOLATILE_SECTIONS));
+        } else if (argument == "--cache-dir") {
+            if (i + 1 == argc) {
+                usage(1);
+            }
+            options.cache_dir = argv[++i];
+        } else if (argument.rfind("--cache-size=", 0) == 0) {
+            auto budget = parse_byte_size(argument.substr(13));
+            if (!budget || *budget == 0) {
+                usage(1);
+            }
+            options.cache_budget = *budget;
+        } else if (argument == "--serve") {
+            options.serve_port = SERVE_DEFAULT_PORT;
+        } else if (argument.rfind("--serve=", 0) == 0) {
+            auto text = argument.substr(8);
+            uint16_t port = 0;
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), port);
+            if (error != std::errc() || end != text.data() + text.size() || port == 0) {
+                usage(1);
+            }
+            options.serve_port = port;
+        } else if (argument == "--watch") {
+            options.watch = true;
+        } else if (argument == "--lookup") {
+            options.lookup = true;
+        } else if (argument == "--check") {
+            options.check = true;
+        } else if (argument.rfind("-", 0) == 0) {
+            usage(1);
+        } else if (options.filename.empty()) {
+            options.filename = argument;
+        } else {
+            options.extra_files.push_back(argument);
+        }
+    }
+
+    if (options.filename.empty()) {
         usage(1);
     }
 
-    auto argument = std::string(argv[1]);
+    if (!options.extra_files.empty() && options.index_output.empty() && !options.serve_port && !options.check) {
+        usage(1);
+    }
+
+    if (!options.size_base.empty() && !options.sizes) {
+        usage(1);
+    }
+
+    // streaming keeps nothing but the block cache in memory and watched renders
+    // skip unchanged files already, neither goes through the report cache
+    if (!options.cache_dir.empty() && (options.stream_budget != 0 || options.watch)) {
+        usage(1);
+    }
+
+    if (options.stats != StatsFormat::none && !STATS_ENABLED) {
+        std::cout << "Error: elfcat was built without stats support (ELFCAT_STATS=OFF)" << std::endl;
+        std::exit(1);
+    }
+
+    return options;
+}
+
+void print_stats([[maybe_unused]] StatsFormat format) {
+#if STATS_ENABLED
+    if (format == StatsFormat::table) {
+        Stats::instance().print_table(std::cerr);
+    } else if (format == StatsFormat::json) {
+        Stats::instance().print_json(std::cerr);
+    }
+#endif
+}
+
+// a binary without .symtab takes the symbols and DWARF of its debug file, if one is found
+void attach_debug_file(ParsedElf& elf, DebugFile& debug, const std::vector<std::string>& debug_dirs) {
+    for (const auto& shdr : elf.shdrs) {
+        if (shdr.shtype == SHT_SYMTAB) {
+            return;
+        }
+    }
+
+    DebugResolver resolver{debug_dirs, DebugFileCache::load(DebugFileCache::default_path())};
+    auto path = resolver.resolve(elf);
+    resolver.cache.save();
+
+    if (!path) {
+        return;
+    }
+
+    try {
+        debug.file = MappedFile::open(*path);
+        debug.elf = ParsedElf::from_bytes(*path, debug.file.view());
+    } catch (const std::runtime_error&) {
+        return;
+    }
+
+    elf.debug_file = &*debug.elf;
+    elf.information.emplace_back("debug_file", "Debug file", *path);
+}
+
+// the code a report is rendered with, by the XXH64 of this executable, and the
+// stylesheet and scripts it inlines from data/, which are read at run time
+std::string build_identity() {
+    std::stringstream identity;
+    try {
+        auto self = MappedFile::open("/proc/self/exe");
+        identity << "executable " << std::hex << xxhash64(self.view()) << std::dec << '\n';
+    } catch (const std::runtime_error&) {
+        // only the assets and version then
+        identity << "executable unknown\n";
+    }
+
+    std::vector<std::string> assets;
+    try {
+        assets = list_regular_files("data");
+    } catch (const std::runtime_error&) {
+    }
+    for (const auto& path : assets) {
+        try {
+            auto asset = MappedFile::open(path);
+            identity << "asset " << path << " " << std::hex << xxhash64(asset.view()) << std::dec << '\n';
+        } catch (const std::runtime_error&) {
+            identity << "asset " << path << " unreadable\n";
+        }
+    }
+    return identity.str();
+}
+
+// everything besides the contents that the report of a file depends on
+std::string cache_parameters(const Options& options, const ParsedElf* elf) {
+    static const std::string build = build_identity();
+
+    std::stringstream parameters;
+    parameters << "elfcat " << ELFCAT_VERSION_MAJOR << "." << ELFCAT_VERSION_MINOR << '\n';
+    parameters << build;
+    parameters << "filename " << options.filename << '\n';
+    parameters << "summary " << options.summary << '\n';
+
+    // trusted while its size and modification time stay, like DebugFileCache does
+    if (elf != nullptr && elf->debug_file != nullptr) {
+        struct stat st = {};
+        stat(elf->debug_file->filename.c_str(), &st);
+        parameters << "debug_file " << st.st_size << " " << st.st_mtim.tv_sec << "." << st.st_mtim.tv_nsec << " " << elf->debug_file->filename << '\n';
+    }
+
+    return parameters.str();
+}
+
+// writes the cached report of key, if there is one
+bool write_cached_report(const std::optional<ReportCache>& cache, const std::string& key, const std::string& report_filename) {
+    if (!cache) {
+        return false;
+    }
+
+    STATS_PHASE(phase, "cache");
+
+    auto report = cache->get(key);
+    if (!report) {
+        return false;
+    }
+
+    std::ofstream ofile(report_filename);
+    ofile << *report;
+    STATS_EMITTED(phase, report->size());
+    return true;
+}
+
+std::optional<ReportCache> open_cache(const Options& options) {
+    if (options.cache_dir.empty()) {
+        return std::nullopt;
+    }
+    return ReportCache::open(options.cache_dir, options.cache_budget);
+}
+
+// .a files: every member is parsed straight from the mapping, one page sums them up
+int archive_report(const Options& options, const MappedFile& file, const std::optional<ReportCache>& cache = std::nullopt) {
+    std::string key;
+    if (cache) {
+        STATS_PHASE(phase, "hash");
+        key = ReportCache::key(file.view(), cache_parameters(options, nullptr));
+    }
+
+    if (write_cached_report(cache, key, construct_filename(options.filename))) {
+        print_stats(options.stats);
+        return 0;
+    }
+
+    std::optional<ParsedArchive> archive;
+    try {
+        STATS_PHASE(phase, "parse");
+        archive = ParsedArchive::from_bytes(options.filename, file.view(), options.jobs);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    auto report = generate_archive_report(*archive);
+
+    {
+        STATS_PHASE(phase, "write");
+
+        std::ofstream ofile(construct_filename(options.filename));
+        ofile << report;
+        STATS_EMITTED(phase, report.size());
+
+        if (cache) {
+            cache->put(key, report);
+        }
+    }
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+// bounded-memory path: contents go through the block cache and the report is
+// written out as it is generated instead of being assembled in memory
+int stream_report(const Options& options) {
+    const auto& filename = options.filename;
+
+    BlockCache source;
+    try {
+        source = BlockCache::open(filename, options.stream_budget);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: file '" << filename << "' can't be opened!" << std::endl;
+        return -1;
+    }
+
+    // members are parsed from views of the archive, which needs the whole file mapped
+    if (source.size() >= 8) {
+        uint8_t magic[8];
+        source.read(0, sizeof(magic), magic);
+        if (Archive::is_archive(ByteView(magic, sizeof(magic)))) {
+            return archive_report(options, MappedFile::open(filename));
+        }
+    }
+
+    auto elf = [&] {
+        STATS_PHASE(phase, "parse");
+        return ParsedElf::parse(filename, source);
+    }();
+    elf.jobs = options.jobs;
+
+    if (!elf.headers_parsed()) {
+        std::cout << "Error: " << elf.diagnostics.back().problem << std::endl;
+        return -1;
+    }
+
+    DebugFile debug;
+    attach_debug_file(elf, debug, options.debug_dirs);
+
+    std::ofstream ofile(construct_filename(filename));
+
+    if (options.summary) {
+        ofile << generate_summary_report(elf);
+    } else {
+        write_report(ofile, elf);
+    }
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+std::optional<uint64_t> parse_address(std::string_view text) {
+    int base = 10;
+    if (text.rfind("0x", 0) == 0 || text.rfind("0X", 0) == 0) {
+        text.remove_prefix(2);
+        base = 16;
+    }
+
+    uint64_t value = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+    if (error != std::errc() || end != text.data() + text.size() || text.empty()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// same format as int_to_hex<uint64_t>, without going through a stringstream
+void append_hex(std::string& out, uint64_t value) {
+    char digits[18] = {'0', 'x'};
+    for (int i = 17; i >= 2; --i) {
+        digits[i] = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+    }
+    out.append(digits, sizeof(digits));
+}
+
+// batch translation for symbolizers: one tab-separated line out per line in,
+// "-" for whatever doesn't map and "?" for input that isn't a number
+int run_queries(const Options& options) {
+    const auto& filename = options.filename;
+
+    MappedFile file;
+    try {
+        file = MappedFile::open(filename);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: file '" << filename << "' can't be opened!" << std::endl;
+        return -1;
+    }
+
+    auto elf = ParsedElf::parse(filename, file.view());
+    if (!elf.headers_parsed()) {
+        std::cout << "Error: " << elf.diagnostics.back().problem << std::endl;
+        return -1;
+    }
+
+    auto index = AddressIndex::build(elf);
+
+    std::ios::sync_with_stdio(false);
+
+    std::string line;
+    std::string out;
+
+    while (std::getline(std::cin, line)) {
+        auto address = parse_address(line);
+
+        out += line;
+        if (!address) {
+            out += "\t?\n";
+            continue;
+        }
+
+        auto location = (options.query == QueryMode::vaddr) ? index.from_vaddr(*address) : index.from_offset(*address);
+        auto translated = (options.query == QueryMode::vaddr) ? location.file_offset : location.vaddr;
+
+        out += '\t';
+        out += location.segment ? std::to_string(*location.segment) : "-";
+        out += '\t';
+        if (location.section) {
+            out += elf.shnstrtab().get_view(elf.shdrs[*location.section].name);
+        } else {
+            out += '-';
+        }
+        out += '\t';
+        if (translated) {
+            append_hex(out, *translated);
+        } else {
+            out += '-';
+        }
+        out += '\n';
+
+        if (out.size() >= DUMP_CHUNK_SIZE) {
+            std::cout << out;
+            out.clear();
+        }
+    }
+
+    std::cout << out;
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+// where the report of a watched file goes: its path below the watched directory,
+// mirrored under CWD with ".html" appended, so that build/a/util.o and
+// build/b/util.so (or build/util.o and build/util.so) don't overwrite each other
+std::string watched_report_filename(const std::string& filename, const std::string& directory) {
+    // the same root watch_directory builds paths from
+    auto root = directory.size() > 1 && directory.back() == '/' ? directory.substr(0, directory.size() - 1) : directory;
+    auto prefix = root == "/" ? root : root + "/";
+    auto relative = filename.rfind(prefix, 0) == 0 ? filename.substr(prefix.size()) : basename(filename);
+
+    // the directories in between
+    auto slash = relative.rfind('/');
+    if (slash != std::string::npos) {
+        make_directories(relative.substr(0, slash));
+    }
+    return relative + ".html";
+}
+
+// reports are written under a temporary name and renamed, so that a browser
+// reloading one never sees it half written
+void render_watched(const std::string& filename, const ByteView& contents, const Options& options) {
+    static std::atomic<uint64_t> serial = 0;
+
+    std::string report;
+    if (Archive::is_archive(contents)) {
+        report = generate_archive_report(ParsedArchive::from_bytes(filename, contents, 1));
+    } else {
+        auto elf = ParsedElf::from_bytes(filename, contents);
+        // the files themselves are already spread over the workers
+        elf.jobs = 1;
+        report = options.summary ? generate_summary_report(elf) : generate_report(elf);
+    }
+
+    auto report_filename = watched_report_filename(filename, options.filename);
+    auto temporary = report_filename + ".tmp" + std::to_string(serial++);
+    {
+        std::ofstream ofile(temporary);
+        ofile << report;
+        if (!ofile) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("can't write '" + temporary + "'");
+        }
+    }
+    std::rename(temporary.c_str(), report_filename.c_str());
+}
+
+int build_index(const Options& options) {
+    std::vector<std::string> roots = {options.filename};
+    roots.insert(roots.end(), options.extra_files.cbegin(), options.extra_files.cend());
+
+    std::vector<BuildIdEntry> entries;
+    try {
+        entries = scan_build_ids(roots, options.jobs);
+        BuildIdIndex::write(options.index_output, entries);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::cout << "Indexed " << entries.size() << " files with a build-id" << std::endl;
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+// one tab-separated line per match: build-id, path, size, class, machine;
+// "-" for build-ids the index doesn't have and "?" for input that isn't one
+int lookup_build_ids(const Options& options) {
+    BuildIdIndex index;
+    try {
+        index = BuildIdIndex::open(options.filename);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    std::string line;
+    std::string out;
+
+    while (std::getline(std::cin, line)) {
+        auto build_id = parse_build_id(line);
+        if (!build_id) {
+            out += line;
+            out += "\t?\n";
+            continue;
+        }
+
+        auto found = index.lookup(ByteView(*build_id));
+        if (found.empty()) {
+            out += line;
+            out += "\t-\n";
+        }
+
+        for (const auto& entry : found) {
+            out += line;
+            out += '\t';
+            out += entry.path;
+            out += '\t';
+            out += std::to_string(entry.file_size);
+            out += '\t';
+            out += entry.elf_class == ELF_CLASS64 ? "64" : "32";
+            out += '\t';
+            out += machine_to_string(entry.machine);
+            out += '\n';
+        }
+
+        if (out.size() >= DUMP_CHUNK_SIZE) {
+            std::cout << out;
+            out.clear();
+        }
+    }
+
+    std::cout << out;
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+std::optional<SizeReport> build_size_report(const std::string& filename, const Options& options) {
+    MappedFile file;
+    try {
+        file = MappedFile::open(filename);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: file '" << filename << "' can't be opened!" << std::endl;
+        return std::nullopt;
+    }
+
+    auto elf = ParsedElf::parse(filename, file.view());
+    if (!elf.headers_parsed()) {
+        std::cout << "Error: " << elf.diagnostics.back().problem << std::endl;
+        return std::nullopt;
+    }
+
+    DebugFile debug;
+    if (*options.sizes == SizeLevel::symbols || *options.sizes == SizeLevel::compile_units) {
+        attach_debug_file(elf, debug, options.debug_dirs);
+    }
+
+    return SizeReport::build(elf, *options.sizes);
+}
+
+int print_sizes(const Options& options) {
+    auto report = build_size_report(options.filename, options);
+    if (!report) {
+        return -1;
+    }
+
+    if (options.size_base.empty()) {
+        print_size_report(std::cout, *report);
+    } else {
+        auto base = build_size_report(options.size_base, options);
+        if (!base) {
+            return -1;
+        }
+        print_size_diff(std::cout, *report, *base);
+    }
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+// one tab-separated line per string: offset, section ("-" outside sections), text
+int print_strings(const Options& options) {
+    const auto& filename = options.filename;
+
+    MappedFile file;
+    try {
+        file = MappedFile::open(filename);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: file '" << filename << "' can't be opened!" << std::endl;
+        return -1;
+    }
+
+    auto elf = ParsedElf::parse(filename, file.view());
+    if (!elf.headers_parsed()) {
+        std::cout << "Error: " << elf.diagnostics.back().problem << std::endl;
+        return -1;
+    }
+
+    auto found = scan_strings(elf, options.strings, options.encoding, options.jobs);
+
+    std::ios::sync_with_stdio(false);
+
+    std::string out;
+
+    for (const auto& string : found) {
+        append_hex(out, string.offset);
+        out += '\t';
+        if (string.section) {
+            out += elf.shnstrtab().get_view(elf.shdrs[*string.section].name);
+        } else {
+            out += '-';
+        }
+        out += '\t';
+        out += string_text(elf, string, options.encoding);
+        out += '\n';
+
+        if (out.size() >= DUMP_CHUNK_SIZE) {
+            std::cout << out;
+            out.clear();
+        }
+    }
+
+    std::cout << out;
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+int print_manifest(const Options& options) {
+    const auto& filename = options.filename;
+
+    MappedFile file;
+    try {
+        file = MappedFile::open(filename);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: file '" << filename << "' can't be opened!" << std::endl;
+        return -1;
+    }
+
+    auto elf = ParsedElf::parse(filename, file.view());
+    if (!elf.headers_parsed()) {
+        std::cout << "Error: " << elf.diagnostics.back().problem << std::endl;
+        return -1;
+    }
 
-    if (argument == "-h" || argument == "--help") {
-        usage(0);
+    auto manifest = HashManifest::build(elf, options.ignored_sections, options.jobs);
+
+    if (options.manifest == ManifestFormat::json) {
+        print_manifest_json(std::cout, manifest);
+    } else {
+        print_manifest(std::cout, manifest);
+    }
+
+    print_stats(options.stats);
+
+    return 0;
+}
+
+std::string format_diagnostic(const std::string& filename, const ParseDiagnostic& diagnostic) {
+    return filename + ": " + int_to_hex(diagnostic.offset) + ": " + diagnostic.structure + ": " + diagnostic.problem + "\n";
+}
+
+// one line per diagnostic: path, offset, structure and problem. Files are mapped and
+// parsed on all cores; files found under a directory are skipped unless they start with
+// the ELF magic. Exit status 1 when any file has a diagnostic
+int check_files(const Options& options) {
+    std::vector<std::string> roots = {options.filename};
+    roots.insert(roots.end(), options.extra_files.cbegin(), options.extra_files.cend());
+
+    std::vector<std::string> files;
+    // given on the command line rather than found under a directory
+    std::vector<bool> named;
+    try {
+        for (const auto& root : roots) {
+            auto found = list_regular_files(root);
+            bool is_file = found.size() == 1 && found[0] == root;
+            files.insert(files.end(), found.cbegin(), found.cend());
+            named.insert(named.end(), found.size(), is_file);
+        }
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> results(files.size());
+
+    parallel_for(files.size(), options.jobs, [&](size_t i) {
+        MappedFile file;
+        try {
+            file = MappedFile::open(files[i]);
+        } catch (const std::runtime_error& e) {
+            results[i] = files[i] + ": " + e.what() + "\n";
+            return;
+        }
+
+        auto contents = file.view();
+        bool elf_magic = contents.size() >= 4 && std::memcmp(contents.data(), "\x7f" "ELF", 4) == 0;
+        if (!named[i] && !elf_magic) {
+            return;
+        }
+
+        auto elf = ParsedElf::parse(files[i], contents);
+        for (const auto& diagnostic : elf.diagnostics) {
+            results[i] += format_diagnostic(files[i], diagnostic);
+        }
+    });
+
+    bool clean = true;
+    for (const auto& result : results) {
+        std::cout << result;
+        clean = clean && result.empty();
+    }
+
+    print_stats(options.stats);
+
+    return clean ? 0 : 1;
+}
+
+// exit status like cmp: 0 when identical, 1 when the files differ
+int diff_files(const Options& options) {
+    MappedFile base_file;
+    MappedFile file;
+    for (auto [mapped, filename] : {std::tie(base_file, options.diff_base), std::tie(file, options.filename)}) {
+        try {
+            mapped = MappedFile::open(filename);
+        } catch (const std::runtime_error& e) {
+            std::cout << "Error: file '" << filename << "' can't be opened!" << std::endl;
+            return -1;
+        }
     }
 
-    if (argument == "-v" || argument == "--version") {
-        std::cout << "elfcat " << ELFCAT_VERSION_MAJOR << "." << ELFCAT_VERSION_MAJOR << std::endl;
-        std::exit(0);
+    auto base = ParsedElf::parse(options.diff_base, base_file.view());
+    auto elf = ParsedElf::parse(options.filename, file.view());
+    for (const auto& parsed : {&base, &elf}) {
+        if (!parsed->headers_parsed()) {
+            std::cout << "Error: " << parsed->filename << ": " << parsed->diagnostics.back().problem << std::endl;
+            return -1;
+        }
+    }
+    elf.jobs = options.jobs;
+
+    auto diff = ElfDiff::build(base, elf, options.jobs);
+    print_diff_summary(std::cout, diff, options.filename);
+
+    elf.highlight_spans = diff.changed_spans();
+
+    {
+        STATS_PHASE(phase, "write");
+
+        std::ofstream ofile(construct_diff_filename(options.filename));
+        if (options.summary) {
+            ofile << generate_summary_report(elf, &diff);
+        } else {
+            write_report(ofile, elf, &diff);
+        }
     }
 
-    return std::string(argv[1]);
+    print_stats(options.stats);
+
+    return diff.identical() ? 0 : 1;
 }
 
 int main(int argc, char** argv) {
-    std::string filename = parse_arguments(argc, argv);
+    auto options = parse_arguments(argc, argv);
+    const auto& filename = options.filename;
+
+    if (!options.index_output.empty()) {
+        return build_index(options);
+    }
+
+    if (options.serve_port) {
+        std::vector<std::string> files = {filename};
+        files.insert(files.end(), options.extra_files.cbegin(), options.extra_files.cend());
+        return serve_files(files, *options.serve_port);
+    }
+
+    if (options.watch) {
+        return watch_directory(filename, options.jobs, [&](const std::string& path, const ByteView& contents) {
+            render_watched(path, contents, options);
+        });
+    }
 
-    std::ifstream ifile(filename, std::ios::binary);
-    if (ifile.fail()) {
+    if (options.lookup) {
+        return lookup_build_ids(options);
+    }
+
+    if (options.check) {
+        return check_files(options);
+    }
+
+    if (options.query != QueryMode::none) {
+        return run_queries(options);
+    }
+
+    if (options.sizes) {
+        return print_sizes(options);
+    }
+
+    if (!options.diff_base.empty()) {
+        return diff_files(options);
+    }
+
+    if (options.strings != 0) {
+        return print_strings(options);
+    }
+
+    if (options.manifest != ManifestFormat::none) {
+        return print_manifest(options);
+    }
+
+    if (options.stream_budget != 0) {
+        return stream_report(options);
+    }
+
+    MappedFile file;
+    try {
+        STATS_PHASE(phase, "map");
+        file = MappedFile::open(filename);
+    } catch (const std::runtime_error& e) {
         std::cout << "Error: file '" << filename << "' can't be opened!" << std::endl;
         return -1;
     }
-    ifile.unsetf(std::ios::skipws);
-    ifile.seekg(0, std::ios::end);
-    std::streampos file_size = ifile.tellg();
-    ifile.seekg(0, std::ios::beg);
 
-    std::vector<uint8_t> contents;
-    contents.reserve(file_size);
-    contents.insert(contents.begin(), std::istreambuf_iterator<char>(ifile), std::istreambuf_iterator<char>());
+    std::optional<ReportCache> cache;
+    try {
+        cache = open_cache(options);
+    } catch (const std::runtime_error& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    if (Archive::is_archive(file.view())) {
+        return archive_report(options, file, cache);
+    }
+
+    auto elf = [&] {
+        STATS_PHASE(phase, "parse");
+        return ParsedElf::parse(filename, file.view());
+    }();
+    elf.jobs = options.jobs;
+
+    // the other diagnostics go into the report
+    if (!elf.headers_parsed()) {
+        std::cout << "Error: " << elf.diagnostics.back().problem << std::endl;
+        return -1;
+    }
+
+    DebugFile debug;
+    attach_debug_file(elf, debug, options.debug_dirs);
 
-    auto elf = ParsedElf::from_bytes(filename, contents);
     auto report_filename = construct_filename(filename);
-    auto report = generate_report(elf);
 
-    std::ofstream ofile(report_filename);
-    ofile << report;
+    // only the headers have been parsed so far, which the debug file needed
+    std::string key;
+    if (cache) {
+        STATS_PHASE(phase, "hash");
+        key = ReportCache::key(file.view(), cache_parameters(options, &elf));
+    }
+
+    if (write_cached_report(cache, key, report_filename)) {
+        print_stats(options.stats);
+        return 0;
+    }
+
+    // the full report is written out as it's rendered; the cache copies it from the file
+    {
+        std::ofstream ofile(report_filename);
+        if (options.summary) {
+            ofile << generate_summary_report(elf);
+        } else {
+            write_report(ofile, elf);
+        }
+    }
+
+    if (cache) {
+        STATS_PHASE(phase, "cache");
+        cache->put_file(key, report_filename);
+    }
+
+    print_stats(options.stats);
 }
@@ -0,0 +1,81 @@
+#include <cstdio>
+
+#include "manifest_gen.hpp"
+
+
+namespace {
+
+std::string sha256_hex(const std::array<uint8_t, 32>& digest) {
+    char buf[65];
+    for (size_t i = 0; i < digest.size(); ++i) {
+        std::snprintf(buf + 2 * i, 3, "%02x", digest[i]);
+    }
+    return buf;
+}
+
+std::string xxh64_hex(uint64_t digest) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(digest));
+    return buf;
+}
+
+// section names are arbitrary bytes
+std::string json_string(const std::string& text) {
+    std::string quoted = "\"";
+    for (unsigned char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            quoted += '\\';
+            quoted += ch;
+        } else if (ch < 0x20 || ch >= 0x7f) {
+            char buf[7];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            quoted += buf;
+        } else {
+            quoted += ch;
+        }
+    }
+    return quoted + "\"";
+}
+
+void print_entries_json(std::ostream& o, const std::vector<ManifestEntry>& entries) {
+    o << "[";
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        o << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": " << json_string(entry.name)
+            << ", \"size\": " << entry.size
+            << ", \"sha256\": \"" << sha256_hex(entry.sha256) << "\""
+            << ", \"xxh64\": \"" << xxh64_hex(entry.xxh64) << "\"}";
+    }
+    o << (entries.empty() ? "]" : "\n  ]");
+}
+
+}
+
+
+void print_manifest(std::ostream& o, const HashManifest& manifest) {
+    auto print_entries = [&](const char* kind, const std::vector<ManifestEntry>& entries) {
+        for (const auto& entry : entries) {
+            o << kind << '\t' << entry.name << '\t' << entry.size << '\t'
+                << sha256_hex(entry.sha256) << '\t' << xxh64_hex(entry.xxh64) << '\n';
+        }
+    };
+
+    print_entries("section", manifest.sections);
+    print_entries("segment", manifest.segments);
+    for (const auto& name : manifest.ignored) {
+        o << "ignored\t" << name << '\n';
+    }
+}
+
+void print_manifest_json(std::ostream& o, const HashManifest& manifest) {
+    o << "{\n  \"sections\": ";
+    print_entries_json(o, manifest.sections);
+    o << ",\n  \"segments\": ";
+    print_entries_json(o, manifest.segments);
+    o << ",\n  \"ignored\": [";
+    for (size_t i = 0; i < manifest.ignored.size(); ++i) {
+        o << (i == 0 ? "" : ", ") << json_string(manifest.ignored[i]);
+    }
+    o << "]\n}" << std::endl;
+}
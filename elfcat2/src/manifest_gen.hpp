@@ -0,0 +1,12 @@
+#pragma once
+
+#include <ostream>
+
+#include <hash_manifest.hpp>
+
+
+// one tab-separated line per section and segment: kind, name, bytes hashed,
+// SHA-256, XXH64; then one line per ignored section. Stable across builds that
+// only move things around, so two manifests can be compared with diff
+void print_manifest(std::ostream& o, const HashManifest& manifest);
+void print_manifest_json(std::ostream& o, const HashManifest& manifest);
@@ -1,6 +1,11 @@
+#include <algorithm>
 #include <experimental/filesystem>
+#include <map>
+#include <set>
 namespace fs = std::experimental::filesystem;
 
+#include <stats.hpp>
+
 #include "defs.hpp"
 #include "report_gen.hpp"
 
@@ -17,6 +22,10 @@ std::string construct_filename(const std::string& filename) {
     return stem(basename(filename)) + ".html";
 }
 
+std::string construct_diff_filename(const std::string& filename) {
+    return stem(basename(filename)) + ".diff.html";
+}
+
 std::string indent(size_t level, const std::string& line) {
     if (line.empty()) {
         return {};
@@ -24,20 +33,24 @@ std::string indent(size_t level, const std::string& line) {
     return repeat(INDENT, level) + line;
 }
 
-void generate_head(std::stringstream& o, const ParsedElf& elf) {
+void generate_head(std::ostream& o, const ParsedElf& elf) {
+    generate_head(o, html_escape(basename(elf.filename)));
+}
+
+void generate_head(std::ostream& o, const std::string& title) {
     std::string stylesheet = include_str("data/style.css", repeat(INDENT, 3));
 
     w(o, 1, "<head>");
     w(o, 2, "<meta charset='utf-8'>");
     w(o, 2, "<meta name='viewport' content='width=900, initial-scale=1'>");
-    w(o, 2, "<title>", basename(elf.filename), "</title>");
+    w(o, 2, "<title>", title, "</title>");
     w(o, 2, "<style>");
     wnonl(o, 0, stylesheet);
     w(o, 2, "</style>");
     w(o, 1, "</head>");
 }
 
-void generate_svg_element(std::stringstream& o) {
+void generate_svg_element(std::ostream& o) {
     w(o, 2, "<svg width='100%' height='100%'>");
 
     w(o, 3, "<defs>");
@@ -59,23 +72,77 @@ void generate_svg_element(std::stringstream& o) {
     w(o, 2, "</svg>");
 }
 
-void generate_file_info_table(std::stringstream& o, const ParsedElf& elf) {
+// "ph"/"sh" rows are split into spans so that each number highlights its header field
+std::string header_table_markup(const std::string& prefix, size_t num, size_t entsize, size_t offset) {
+    return std::string("<span id='info_e_") + prefix + "num'>" + std::to_string(num) + "</span> * " +
+        "<span id='info_e_" + prefix + "entsize'>" + std::to_string(entsize) + "</span> @ " +
+        "<span id='info_e_" + prefix + "off'>" + std::to_string(offset) + "</span>";
+}
+
+void generate_file_info_table(std::ostream& o, const ParsedElf& elf) {
     w(o, 4, "<table>");
 
     for (const auto& [id, desc, value] : elf.information) {
         wnonl(o, 5, "<tr id='info_", id, "'> ");
         wnonl(o, 0, "<td>", desc, ":</td> ");
-        wnonl(o, 0, "<td>", value, "</td> ");
+        if (id == "ph") {
+            wnonl(o, 0, "<td>", header_table_markup("ph", elf.phdrs.size(), elf.phentsize, elf.phoff), "</td> ");
+        } else if (id == "sh") {
+            wnonl(o, 0, "<td>", header_table_markup("sh", elf.shdrs.size(), elf.shentsize, elf.shoff), "</td> ");
+        } else {
+            wnonl(o, 0, "<td>", html_escape(value), "</td> ");
+        }
         w(o, 0, "</tr>");
     }
 
     w(o, 4, "</table>");
 }
 
-void generate_phdr_info_table(std::stringstream& o, const ParsedPhdr& phdr, size_t idx) {
+// section names of a segment, space separated like readelf's section to segment mapping
+std::string segment_sections_string(const ParsedElf& elf, size_t idx) {
+    std::string result;
+    for (auto section : elf.segment_mapping().sections_in_segment[idx]) {
+        if (!result.empty()) {
+            result += ' ';
+        }
+        result += html_escape(elf.shnstrtab().get(elf.shdrs[section].name));
+    }
+    return result;
+}
+
+// entropy, zero padding and the most frequent values of a section's or segment's bytes
+void add_byte_stats_items(std::vector<std::tuple<std::string, std::string>>& items, const ByteSummary& summary) {
+    if (summary.size == 0) {
+        return;
+    }
+
+    auto percent = [&](uint64_t count) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%.1f%%", 100.0 * count / summary.size);
+        return std::string(buf);
+    };
+
+    char entropy[32];
+    std::snprintf(entropy, sizeof(entropy), "%.2f bits/byte", summary.entropy);
+    items.emplace_back("Entropy", entropy);
+    items.emplace_back("Zero runs", percent(summary.zero_run_bytes));
+
+    std::string common;
+    for (const auto& [value, count] : summary.common) {
+        if (!common.empty()) {
+            common += ", ";
+        }
+        char byte[8];
+        std::snprintf(byte, sizeof(byte), "%02x ", value);
+        common += byte + percent(count);
+    }
+    items.emplace_back("Common bytes", common);
+}
+
+void generate_phdr_info_table(std::ostream& o, const ParsedElf& elf, const ParsedPhdr& phdr, size_t idx, bool byte_stats) {
     std::vector<std::tuple<std::string, std::string>> items = {
         {"Type", ptype_to_string(phdr.ptype)},
-        {"Flags", phdr.flags},
+        {"Flags", std::string(pflags_to_string(phdr.flags))},
         {"Offset in file", std::to_string(phdr.file_offset)},
         {"Size in file", std::to_string(phdr.file_size)},
         {"Vaddr in memory", int_to_hex(phdr.vaddr)},
@@ -83,6 +150,14 @@ void generate_phdr_info_table(std::stringstream& o, const ParsedPhdr& phdr, size
         {"Alignment", int_to_hex(phdr.alignment)},
     };
 
+    if (!elf.segment_mapping().sections_in_segment[idx].empty()) {
+        items.emplace_back("Sections", segment_sections_string(elf, idx));
+    }
+
+    if (byte_stats) {
+        add_byte_stats_items(items, elf.byte_stats().segments[idx]);
+    }
+
     w(o, 5, "<table class='conceal' id='info_phdr", idx, "'>");
 
     for (const auto& [desc, value] : items) {
@@ -92,19 +167,19 @@ void generate_phdr_info_table(std::stringstream& o, const ParsedPhdr& phdr, size
     w(o, 5, "</table>");
 }
 
-void generate_phdr_info_tables(std::stringstream& o, const ParsedElf& elf) {
+void generate_phdr_info_tables(std::ostream& o, const ParsedElf& elf, bool byte_stats) {
     size_t idx = 0;
     for (const auto& phdr : elf.phdrs) {
-        generate_phdr_info_table(o, phdr, idx);
+        generate_phdr_info_table(o, elf, phdr, idx, byte_stats);
         ++idx;
     }
 }
 
-void generate_shdr_info_table(std::stringstream& o, const ParsedElf& elf, const ParsedShdr& shdr, size_t idx) {
+void generate_shdr_info_table(std::ostream& o, const ParsedElf& elf, const ParsedShdr& shdr, size_t idx, bool byte_stats) {
     std::vector<std::tuple<std::string, std::string>> items = {
-        {"Name", elf.shnstrtab.get(shdr.name)},
+        {"Name", html_escape(elf.shnstrtab().get(shdr.name))},
         {"Type", shtype_to_string(shdr.shtype)},
-        {"Flags", shflags_to_string(shdr.flags)},
+        {"Flags", std::string(shflags_to_string(shdr.flags))},
         {"Vaddr in memory", int_to_hex(shdr.addr)},
         {"Offset in file", std::to_string(shdr.file_offset)},
         {"Size in file", std::to_string(shdr.size)},
@@ -114,6 +189,10 @@ void generate_shdr_info_table(std::stringstream& o, const ParsedElf& elf, const
         {"Size of entries", std::to_string(shdr.entsize)},
     };
 
+    if (byte_stats) {
+        add_byte_stats_items(items, elf.byte_stats().sections[idx]);
+    }
+
     w(o, 5, "<table class='conceal' id='info_shdr", idx, "'>");
 
     for (const auto& [desc, value] : items) {
@@ -123,10 +202,10 @@ void generate_shdr_info_table(std::stringstream& o, const ParsedElf& elf, const
     w(o, 5, "</table>");
 }
 
-void generate_shdr_info_tables(std::stringstream& o, const ParsedElf& elf) {
+void generate_shdr_info_tables(std::ostream& o, const ParsedElf& elf, bool byte_stats) {
     size_t idx = 0;
     for (const auto& shdr : elf.shdrs) {
-        generate_shdr_info_table(o, elf, shdr, idx);
+        generate_shdr_info_table(o, elf, shdr, idx, byte_stats);
         ++idx;
     }
 }
@@ -142,14 +221,14 @@ std::string format_string_slice(const std::vector<uint8_t>& slice) {
     return std::string(slice.cbegin(), slice.cend());
 }
 
-void generate_note_data(std::stringstream& o, const Note& note) {
+void generate_note_data(std::ostream& o, const Note& note) {
     std::string name = note.name.empty()?"":format_string_slice(byte_range(note.name, 0, note.name.size() - 1));
 
-    wrow(o, 6, "Name", name);
+    wrow(o, 6, "Name", html_escape(name));
 
     wrow(o, 6, "Type", int_to_hex(note.ntype));
 
-    if (note.ntype == NT_GNU_BUILD_ID) {
+    if (name == "GNU" && note.ntype == NT_GNU_BUILD_ID) {
         std::stringstream hash;
 
         for (const auto& byte : note.desc) {
@@ -157,32 +236,37 @@ void generate_note_data(std::stringstream& o, const Note& note) {
         }
 
         wrow(o, 6, "Build ID", hash.str());
+    } else if (name == "CORE" || name == "LINUX") {
+        // binary process state, decoded into the core tables instead
+        wrow(o, 6, "Desc size", note.desc.size());
     } else {
-        wrow(o, 6, "Desc", format_string_slice(note.desc));
+        wrow(o, 6, "Desc", html_escape(format_string_slice(note.desc)));
     }
 }
 
-void generate_segment_info_table(std::stringstream& o, const ParsedElf& elf, const ParsedPhdr& phdr) {
+void generate_segment_info_table(std::ostream& o, const ParsedElf& elf, const ParsedPhdr& phdr) {
     if (phdr.ptype == PT_INTERP) {
-        auto interp_str = format_string_slice(byte_range(elf.contents, phdr.file_offset, phdr.file_offset + phdr.file_size - 1));
-        wrow(o, 6, "Interpreter", interp_str);
+        // without the terminating NUL
+        auto [start, end] = elf.file_range(phdr.file_offset, phdr.file_size);
+        auto interp_str = format_string_slice(elf.read_bytes(start, (end > start) ? end - 1 : end));
+        wrow(o, 6, "Interpreter", html_escape(interp_str));
     } else if (phdr.ptype == PT_NOTE) {
         // this is really bad and made out of desperation.
         // notes stored in elf.notes don't have to have 1-to-1
         // correspondence with phdrs, yet here we are.
-        for (size_t i = 0; i < elf.notes.size(); ++i) {
-            const auto& note = elf.notes[i];
+        for (size_t i = 0; i < elf.notes().size(); ++i) {
+            const auto& note = elf.notes()[i];
 
             generate_note_data(o, note);
 
-            if (i != elf.notes.size() - 1) {
+            if (i != elf.notes().size() - 1) {
                 w(o, 6, "<tr> <td><br></td> </tr>");
             }
         }
     }
 }
 
-void generate_strtab_data(std::stringstream& o, const std::vector<uint8_t>& section) {
+void generate_strtab_data(std::ostream& o, const std::vector<uint8_t>& section) {
     size_t curr_start = 0;
 
     w(o, 6, "<tr>");
@@ -199,7 +283,7 @@ void generate_strtab_data(std::stringstream& o, const std::vector<uint8_t>& sect
             std::string maybe = std::string(section.cbegin() + curr_start, section.cbegin() + end);
 
             if (section[curr_start] != 0) {
-                w(o, 9, maybe);
+                w(o, 9, html_escape(maybe));
             }
 
             curr_start = i + 1;
@@ -212,11 +296,10 @@ void generate_strtab_data(std::stringstream& o, const std::vector<uint8_t>& sect
     w(o, 6, "</tr>");
 }
 
-void generate_section_info_table(std::stringstream& o, const ParsedElf& elf, const ParsedShdr& shdr) {
-    auto section = byte_range(elf.contents, shdr.file_offset, shdr.file_offset + shdr.size);
-
+void generate_section_info_table(std::ostream& o, const ParsedElf& elf, const ParsedShdr& shdr) {
     if (shdr.shtype == SHT_STRTAB) {
-        generate_strtab_data(o, section);
+        auto [start, end] = elf.file_range(shdr.file_offset, shdr.size);
+        generate_strtab_data(o, elf.read_bytes(start, end));
     }
 }
 
@@ -229,7 +312,7 @@ bool has_section_detail(uint32_t ptype) {
     return ptype == SHT_STRTAB;
 }
 
-void generate_segment_info_tables(std::stringstream& o, const ParsedElf& elf) {
+void generate_segment_info_tables(std::ostream& o, const ParsedElf& elf) {
     size_t idx = 0;
     for (const auto& phdr : elf.phdrs) {
         w(o, 5, "<table class='conceal' id='info_segment", idx, "'>");
@@ -247,7 +330,7 @@ void generate_segment_info_tables(std::stringstream& o, const ParsedElf& elf) {
     }
 }
 
-void generate_section_info_tables(std::stringstream& o, const ParsedElf& elf) {
+void generate_section_info_tables(std::ostream& o, const ParsedElf& elf) {
     size_t idx = 0;
     for (const auto& shdr : elf.shdrs) {
         w(o, 5, "<table class='conceal' id='info_section", idx, "'>");
@@ -264,16 +347,16 @@ void generate_section_info_tables(std::stringstream& o, const ParsedElf& elf) {
     }
 }
 
-void generate_sticky_info_table(std::stringstream& o, const ParsedElf& elf) {
+void generate_sticky_info_table(std::ostream& o, const ParsedElf& elf, bool byte_stats) {
     w(o, 2, "<table id='sticky_table' cellspacing='0'>");
     w(o, 3, "<tr>");
 
     w(o, 4, "<td id='desc'></td>");
 
     w(o, 4, "<td id='struct_infotables'>");
-    generate_phdr_info_tables(o, elf);
+    generate_phdr_info_tables(o, elf, byte_stats);
 
-    generate_shdr_info_tables(o, elf);
+    generate_shdr_info_tables(o, elf, byte_stats);
     w(o, 4, "</td>");
 
     w(o, 4, "<td id='data_infotables'>");
@@ -286,7 +369,7 @@ void generate_sticky_info_table(std::stringstream& o, const ParsedElf& elf) {
     w(o, 2, "</table>");
 }
 
-void add_highlight_script(std::stringstream& o) {
+void add_highlight_script(std::ostream& o) {
     std::array<std::string, 16> ids = {
         "class",
         "data",
@@ -317,7 +400,7 @@ void add_highlight_script(std::stringstream& o) {
     w(o, 2, "</script>");
 }
 
-void add_description_script(std::stringstream& o) {
+void add_description_script(std::ostream& o) {
     w(o, 2, "<script type='text/javascript'>");
 
     wnonl(o, 0, include_str("data/js/description.js", repeat(INDENT, 3)));
@@ -325,7 +408,7 @@ void add_description_script(std::stringstream& o) {
     w(o, 2, "</script>");
 }
 
-void add_conceal_script(std::stringstream& o) {
+void add_conceal_script(std::ostream& o) {
     w(o, 2, "<script type='text/javascript'>");
 
     wnonl(o, 0, include_str("data/js/conceal.js", repeat(INDENT, 3)));
@@ -333,19 +416,58 @@ void add_conceal_script(std::stringstream& o) {
     w(o, 2, "</script>");
 }
 
-void add_offsets_script(std::stringstream& o, const ParsedElf& elf) {
+// first row and length of every run of collapsed rows
+void add_repeated_rows_variable(std::ostream& o, const ParsedElf& elf) {
+    wnonl(o, 3, "let repeatedRows = [");
+    for (const auto& run : elf.repeated_rows()) {
+        wnonl(o, 0, run.first_row, ",", run.rows, ",");
+    }
+    w(o, 0, "]");
+}
+
+void add_offsets_script(std::ostream& o, const ParsedElf& elf) {
     w(o, 2, "<script type='text/javascript'>");
 
     w(o, 3, "let fileLen = ", elf.file_size);
+    add_repeated_rows_variable(o, elf);
 
     wnonl(o, 0, include_str("data/js/offsets.js", repeat(INDENT, 3)));
 
     w(o, 3, "populateOffsets(16)");
+    w(o, 3, "window.addEventListener('hashchange', () => scrollToOffset(16))");
+    w(o, 3, "scrollToOffset(16)");
+
+    w(o, 2, "</script>");
+}
+
+void add_heatmap_script(std::ostream& o, const ParsedElf& elf) {
+    w(o, 2, "<script type='text/javascript'>");
+
+    w(o, 3, "let entropyLevels = '", elf.byte_stats().entropy_levels, "'");
+
+    wnonl(o, 0, include_str("data/js/heatmap.js", repeat(INDENT, 3)));
+
+    w(o, 3, "populateHeatmap(", ENTROPY_BLOCK / 16, ")");
 
     w(o, 2, "</script>");
 }
 
-void add_arrows_script(std::stringstream& o, const ParsedElf& elf) {
+void add_windows_script(std::ostream& o, const ParsedElf& elf, const std::string& rows_url, size_t window_rows) {
+    w(o, 2, "<script type='text/javascript'>");
+
+    w(o, 3, "let fileLen = ", elf.file_size);
+    w(o, 3, "let windowRows = ", window_rows);
+    w(o, 3, "let rowsUrl = '", rows_url, "'");
+    add_repeated_rows_variable(o, elf);
+
+    wnonl(o, 0, include_str("data/js/windows.js", repeat(INDENT, 3)));
+
+    w(o, 3, "setupWindows()");
+
+    w(o, 2, "</script>");
+}
+
+void add_arrows_script(std::ostream& o, const ParsedElf& elf) {
     w(o, 2, "<script type='text/javascript'>");
 
     wnonl(o, 0, include_str("data/js/arrows.js", repeat(INDENT, 3)));
@@ -365,7 +487,7 @@ void add_arrows_script(std::stringstream& o, const ParsedElf& elf) {
 }
 
 
-void add_collapsible_script(std::stringstream& o) {
+void add_collapsible_script(std::ostream& o) {
     w(o, 2, "<script type='text/javascript'>");
 
     wnonl(o, 0, include_str("data/js/collapse.js", repeat(INDENT, 3)));
@@ -373,7 +495,61 @@ void add_collapsible_script(std::stringstream& o) {
     w(o, 2, "</script>");
 }
 
-void add_scripts(std::stringstream& o, const ParsedElf& elf) {
+// a JS string with one code unit per byte of text: everything but printable ASCII is
+// escaped, and so are the quote, the backslash and '<', which could close the script
+std::string js_byte_string(const std::string& text) {
+    std::string literal = "'";
+    for (uint8_t ch : text) {
+        if (ch < 0x20 || ch >= 0x7f || ch == '\'' || ch == '\\' || ch == '<') {
+            literal += "\\x";
+            literal += digit_to_hex(ch / 16);
+            literal += digit_to_hex(ch % 16);
+        } else {
+            literal += static_cast<char>(ch);
+        }
+    }
+    return literal + "'";
+}
+
+// filled in by search.js from the index add_search_script writes
+void generate_search_box(std::ostream& o) {
+    w(o, 4, "<input id='search' type='search' placeholder='symbol or section' autocomplete='off'>");
+    w(o, 4, "<div id='search_results'></div>");
+}
+
+// the names sorted as NameIndex sorts them, with offset and size pairs and kind letters
+// alongside; prefix lookups in search.js are binary searches over them
+void add_search_script(std::ostream& o, const NameIndex& index) {
+    static constexpr char KIND_LETTERS[] = {'s', 'f', 'o', '-'};
+
+    w(o, 2, "<script type='text/javascript'>");
+
+    wnonl(o, 3, "let searchNames = [");
+    for (const auto& named : index.names) {
+        o << js_byte_string(named.name) << ',';
+    }
+    w(o, 0, "]");
+
+    wnonl(o, 3, "let searchRanges = [");
+    for (const auto& named : index.names) {
+        o << named.file_offset << ',' << named.size << ',';
+    }
+    w(o, 0, "]");
+
+    wnonl(o, 3, "let searchKinds = '");
+    for (const auto& named : index.names) {
+        o << KIND_LETTERS[static_cast<size_t>(named.kind)];
+    }
+    w(o, 0, "'");
+
+    wnonl(o, 0, include_str("data/js/search.js", repeat(INDENT, 3)));
+
+    w(o, 3, "setupSearch()");
+
+    w(o, 2, "</script>");
+}
+
+void add_scripts(std::ostream& o, const ParsedElf& elf) {
     add_highlight_script(o);
 
     add_description_script(o);
@@ -385,6 +561,8 @@ void add_scripts(std::stringstream& o, const ParsedElf& elf) {
 
     add_offsets_script(o, elf);
 
+    add_heatmap_script(o, elf);
+
     add_arrows_script(o, elf);
 }
 
@@ -402,7 +580,7 @@ char digit_to_hex(uint8_t digit) {
     return 'a' + (digit - 10);
 }
 
-void append_hex_byte(std::stringstream& s, uint8_t byte) {
+void append_hex_byte(std::ostream& s, uint8_t byte) {
     if (byte < 0x10) {
         s << '0';
 
@@ -416,10 +594,10 @@ void append_hex_byte(std::stringstream& s, uint8_t byte) {
     }
 }
 
-void generate_dump_for_byte(size_t idx, std::stringstream& dump, const ParsedElf& elf) {
-    auto byte = elf.contents[idx];
+void generate_dump_for_byte(size_t idx, uint8_t byte, std::ostream& dump, const Ranges& ranges) {
+    const auto& range = ranges.at(idx);
 
-    for (const auto& range_type : elf.ranges.data[idx]) {
+    for (const auto& range_type : range) {
         if (!range_type->is_end()) {
             dump << "<span " << range_type->span_attributes() << ">";
         }
@@ -431,9 +609,11 @@ void generate_dump_for_byte(size_t idx, std::stringstream& dump, const ParsedElf
         append_hex_byte(dump, byte);
     }
 
-    dump << repeat("</span>", elf.ranges.lookup_range_ends(idx));
+    if (!range.empty()) {
+        dump << repeat("</span>", ranges.lookup_range_ends(idx));
+    }
     if ((idx + 1) % 16 == 0) {
-        dump << std::endl;
+        dump << '\n';
     } else {
         dump << " ";
     }
@@ -441,19 +621,21 @@ void generate_dump_for_byte(size_t idx, std::stringstream& dump, const ParsedElf
 
 // assumes balance == 1
 std::optional<size_t> skip_bytes(size_t idx, size_t len, const ParsedElf& elf) {
-    if (!(elf.ranges.data[idx].size() == 1 && elf.ranges.data[idx][0]->skippable())) {
+    const auto& ranges = elf.ranges();
+
+    if (!(ranges.at(idx).size() == 1 && ranges.at(idx)[0]->skippable())) {
         return std::nullopt;
     }
 
     auto new_idx = idx + 1;
 
     while (new_idx < len) {
-        switch (elf.ranges.data[new_idx].size()) {
+        switch (ranges.at(new_idx).size()) {
         case 0:
             new_idx += 1;
             break;
         case 1:
-            if (elf.ranges.data[new_idx][0]->is_end()) {
+            if (ranges.at(new_idx)[0]->is_end()) {
                 return new_idx;
             }
             return std::nullopt;
@@ -465,67 +647,405 @@ std::optional<size_t> skip_bytes(size_t idx, size_t len, const ParsedElf& elf) {
     return std::nullopt;
 }
 
-std::string generate_file_dump(const ParsedElf& elf) {
-    std::stringstream dump;
-    size_t i = 0;
-    size_t len = elf.contents.size();
-    int64_t balance = 0;
+// stands for a run of rows in both the bytes and the ascii column; as wide as the column,
+// so it takes a row of its own
+void generate_repeated_row(std::ostream& o, const RepeatedRows& run, bool ascii) {
+    if (ascii) {
+        w(o, 0, "<span class='repeated'>*</span>");
+    } else {
+        w(o, 0, "<span class='repeated'>* previous row repeated ", run.rows, " times</span>");
+    }
+}
 
-    while (i < len) {
-        // we are iterating twice for one byte, which is not very smart
-        for (const auto& r : elf.ranges.data[i]) {
-            if (r->is_end()) {
-                --balance;
-            } else {
-                ++balance;
+void generate_file_dump(std::ostream& dump, const ParsedElf& elf) {
+    // built before the phase starts so that range registration is not attributed to the dump
+    const auto& ranges = elf.ranges();
+    const auto& runs = elf.repeated_rows();
+
+    STATS_PHASE(phase, "file_dump");
+
+    auto emitted_at_start = dump.tellp();
+    std::vector<uint8_t> scratch;
+    size_t len = elf.file_size;
+    int64_t balance = 0;
+    auto run = runs.cbegin();
+    size_t next_run = (run == runs.cend()) ? SIZE_MAX : run->first_row * DUMP_ROW_SIZE;
+
+    // contents are visited in chunks so that a streamed file is never resident as a whole
+    for (size_t chunk_start = 0; chunk_start < len; ) {
+        size_t chunk_end = std::min(len, chunk_start + DUMP_CHUNK_SIZE);
+        auto chunk = elf.bytes(chunk_start, chunk_end, scratch);
+        size_t i = chunk_start;
+
+        while (i < chunk_end) {
+            // no range starts or ends in a run, so the balance stays as it is
+            if (i == next_run) {
+                generate_repeated_row(dump, *run, false);
+                i = (run->first_row + run->rows) * DUMP_ROW_SIZE;
+                ++run;
+                next_run = (run == runs.cend()) ? SIZE_MAX : run->first_row * DUMP_ROW_SIZE;
+                break;
             }
-        }
 
-        // account for one potential skippable range which would already start (incr. balance by 1)
-        // disable while working on offsets
-        if (false && balance == 1) {
-            auto new_idx = skip_bytes(i, len, elf);
-            if (new_idx) {
-                dump << "<span " << elf.ranges.data[i][0]->span_attributes() << ">..</span>";
-                if ((i + 1) % 16 == 0) {
-                    dump << std::endl;
+            // we are iterating twice for one byte, which is not very smart
+            for (const auto& r : ranges.at(i)) {
+                if (r->is_end()) {
+                    --balance;
                 } else {
-                    dump << " ";
+                    ++balance;
                 }
-                i = *new_idx;
-                continue;
             }
+
+            // account for one potential skippable range which would already start (incr. balance by 1)
+            // disable while working on offsets
+            if (false && balance == 1) {
+                auto new_idx = skip_bytes(i, len, elf);
+                if (new_idx) {
+                    dump << "<span " << ranges.at(i)[0]->span_attributes() << ">..</span>";
+                    if ((i + 1) % 16 == 0) {
+                        dump << '\n';
+                    } else {
+                        dump << " ";
+                    }
+                    i = *new_idx;
+                    continue;
+                }
+            }
+
+            generate_dump_for_byte(i, chunk[i - chunk_start], dump, ranges);
+            ++i;
         }
 
-        generate_dump_for_byte(i, dump, elf);
-        ++i;
+        chunk_start = i;
     }
 
+    STATS_EMITTED(phase, dump.tellp() - emitted_at_start);
+}
+
+std::string generate_file_dump(const ParsedElf& elf) {
+    std::stringstream dump;
+    generate_file_dump(dump, elf);
     return dump.str();
 }
 
-void generate_ascii_dump(std::stringstream& o, const ParsedElf& elf) {
-    size_t i = 0;
-    for (const auto& b : elf.contents) {
-        if (b >= 0x21 and b <= 0x7e) {
-            auto escaped = html_escape(b);
-            if (escaped) {
-                wnonl(o, 0, *escaped);
+void generate_ascii_rows(std::ostream& o, const ParsedElf& elf, size_t start, size_t end) {
+    std::vector<uint8_t> scratch;
+
+    for (size_t chunk_start = start; chunk_start < end; chunk_start += DUMP_CHUNK_SIZE) {
+        size_t chunk_end = std::min(end, chunk_start + DUMP_CHUNK_SIZE);
+        size_t i = chunk_start;
+
+        for (const auto& b : elf.bytes(chunk_start, chunk_end, scratch)) {
+            if (b >= 0x21 and b <= 0x7e) {
+                auto escaped = html_escape(b);
+                if (escaped) {
+                    wnonl(o, 0, *escaped);
+                } else {
+                    wnonl(o, 0, b);
+                }
             } else {
-                wnonl(o, 0, b);
+                wnonl(o, 0, ".");
             }
+
+            if ((i + 1) % 16 == 0) {
+                w(o, 0, "");
+            }
+            ++i;
+        }
+    }
+}
+
+void generate_ascii_dump(std::ostream& o, const ParsedElf& elf) {
+    const auto& runs = elf.repeated_rows();
+
+    STATS_PHASE(phase, "ascii_dump");
+
+    auto emitted_at_start = o.tellp();
+    size_t start = 0;
+    for (const auto& run : runs) {
+        generate_ascii_rows(o, elf, start, run.first_row * DUMP_ROW_SIZE);
+        generate_repeated_row(o, run, true);
+        start = (run.first_row + run.rows) * DUMP_ROW_SIZE;
+    }
+    generate_ascii_rows(o, elf, start, elf.file_size);
+
+    STATS_EMITTED(phase, o.tellp() - emitted_at_start);
+}
+
+// the runs of repeated rows in rows [first_row, last_row), cut at both ends: each window
+// shows its part of a run as a marker row of its own
+std::vector<RepeatedRows> runs_in_window(const ParsedElf& elf, size_t first_row, size_t last_row) {
+    const auto& runs = elf.repeated_rows();
+
+    auto run = std::lower_bound(runs.cbegin(), runs.cend(), first_row,
+        [](const RepeatedRows& run, size_t row) { return run.first_row + run.rows <= row; });
+
+    std::vector<RepeatedRows> result;
+    for (; run != runs.cend() && run->first_row < last_row; ++run) {
+        size_t first = std::max(run->first_row, first_row);
+        size_t end = std::min(run->first_row + run->rows, last_row);
+        result.push_back({first, end - first});
+    }
+    return result;
+}
+
+// like generate_file_dump for [start, end) only: spans of ranges that began earlier are
+// reopened and the ones going on past end are closed, so every window is balanced markup
+void generate_dump_window(std::ostream& dump, const ParsedElf& elf, size_t start, size_t end,
+        const std::vector<RepeatedRows>& runs) {
+    const auto& ranges = elf.ranges();
+
+    auto open = ranges.open_at(start);
+    for (const auto& range_type : open) {
+        dump << "<span " << range_type->span_attributes() << ">";
+    }
+
+    std::vector<uint8_t> scratch;
+    int64_t balance = open.size();
+    auto run = runs.cbegin();
+    size_t next_run = (run == runs.cend()) ? SIZE_MAX : run->first_row * DUMP_ROW_SIZE;
+
+    for (size_t chunk_start = start; chunk_start < end; ) {
+        size_t chunk_end = std::min(end, chunk_start + DUMP_CHUNK_SIZE);
+        auto chunk = elf.bytes(chunk_start, chunk_end, scratch);
+        size_t i = chunk_start;
+
+        while (i < chunk_end) {
+            // no range starts or ends in a run, so the balance stays as it is
+            if (i == next_run) {
+                generate_repeated_row(dump, *run, false);
+                i = (run->first_row + run->rows) * DUMP_ROW_SIZE;
+                ++run;
+                next_run = (run == runs.cend()) ? SIZE_MAX : run->first_row * DUMP_ROW_SIZE;
+                break;
+            }
+
+            for (const auto& r : ranges.at(i)) {
+                balance += r->is_end() ? -1 : 1;
+            }
+            generate_dump_for_byte(i, chunk[i - chunk_start], dump, ranges);
+            ++i;
+        }
+
+        chunk_start = i;
+    }
+
+    dump << repeat("</span>", std::max<int64_t>(balance, 0));
+}
+
+void generate_offset_rows(std::ostream& o, size_t first_row, size_t last_row, const std::vector<RepeatedRows>& runs) {
+    char offset[24];
+    auto run = runs.cbegin();
+
+    for (size_t row = first_row; row < last_row; ++row) {
+        if (run != runs.cend() && row == run->first_row) {
+            o << "*</br>\n";
+            row += run->rows - 1;
+            ++run;
+            continue;
+        }
+        std::snprintf(offset, sizeof(offset), "%zx", row * 16);
+        o << offset << "</br>\n";
+    }
+}
+
+void generate_ascii_window(std::ostream& o, const ParsedElf& elf, size_t start, size_t end, const std::vector<RepeatedRows>& runs) {
+    for (const auto& run : runs) {
+        generate_ascii_rows(o, elf, start, run.first_row * DUMP_ROW_SIZE);
+        generate_repeated_row(o, run, true);
+        start = (run.first_row + run.rows) * DUMP_ROW_SIZE;
+    }
+    generate_ascii_rows(o, elf, start, end);
+}
+
+// rows [first_row, last_row) of the offsets, the dump and the ascii column, one div each
+void generate_rows_window(std::ostream& o, const ParsedElf& elf, size_t first_row, size_t last_row) {
+    size_t start = std::min(elf.file_size, first_row * 16);
+    size_t end = std::min(elf.file_size, last_row * 16);
+    auto runs = runs_in_window(elf, first_row, last_row);
+
+    o << "<div>";
+    generate_offset_rows(o, first_row, last_row, runs);
+    o << "</div><div>";
+    generate_dump_window(o, elf, start, end, runs);
+    o << "</div><div>";
+    generate_ascii_window(o, elf, start, end, runs);
+    o << "</div>";
+}
+
+void generate_core_tables(std::ostream& o, const ParsedElf& elf) {
+    const auto& core = elf.core();
+
+    w(o, 2, "<table id='core'>");
+    if (!core.process_name.empty()) {
+        wrow(o, 3, "Process", html_escape(core.process_name));
+        wrow(o, 3, "Arguments", html_escape(core.process_args));
+    }
+    if (core.siginfo) {
+        wrow(o, 3, "Signal", signal_to_string(core.siginfo->signo) + " (code " + std::to_string(core.siginfo->code) + ")");
+        if (core.siginfo->addr) {
+            wrow(o, 3, "Fault address", int_to_hex(*core.siginfo->addr));
+        }
+    }
+    w(o, 2, "</table>");
+
+    w(o, 2, "<table id='core_threads'>");
+    w(o, 3, "<tr> <th>Thread</th> <th>Signal</th> <th>PC</th> <th>SP</th> </tr>");
+    for (const auto& thread : core.threads) {
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td>", thread.pid, "</td> ");
+        wnonl(o, 0, "<td>", thread.signal ? signal_to_string(thread.signal) : "", "</td> ");
+        wnonl(o, 0, "<td>", thread.pc ? int_to_hex(*thread.pc) : "", "</td> ");
+        wnonl(o, 0, "<td>", thread.sp ? int_to_hex(*thread.sp) : "", "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+
+    w(o, 2, "<table id='core_segments'>");
+    w(o, 3, "<tr> <th>Segment</th> <th>Vaddr</th> <th>Size in memory</th> <th>Size in file</th> <th>Data</th> </tr>");
+    for (const auto& segment : core.segments) {
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td>", segment.phdr_idx, "</td> ");
+        wnonl(o, 0, "<td>", int_to_hex(segment.vaddr), "</td> ");
+        wnonl(o, 0, "<td>", human_format_bytes(segment.memsz), "</td> ");
+        wnonl(o, 0, "<td>", human_format_bytes(segment.file_size), "</td> ");
+        // the rest of the file image is a hole: pages the kernel skipped as all-zero
+        wnonl(o, 0, "<td>", human_format_bytes(segment.data_bytes), "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+
+    w(o, 2, "<table id='core_files'>");
+    w(o, 3, "<tr> <th>Start</th> <th>End</th> <th>Offset</th> <th>File</th> </tr>");
+    for (const auto& mapping : core.mappings) {
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td>", int_to_hex(mapping.start), "</td> ");
+        wnonl(o, 0, "<td>", int_to_hex(mapping.end), "</td> ");
+        wnonl(o, 0, "<td>", int_to_hex(mapping.file_offset), "</td> ");
+        wnonl(o, 0, "<td>", html_escape(mapping.path), "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+
+    w(o, 2, "<table id='core_auxv'>");
+    for (const auto& [type, value] : core.auxv) {
+        wrow(o, 3, auxv_type_to_string(type), int_to_hex(value));
+    }
+    w(o, 2, "</table>");
+}
+
+std::string section_diff_details(const SectionDiff& section) {
+    std::string details;
+    if (section.header_changed) {
+        details += "header";
+    }
+    if (section.contents_changed) {
+        details += details.empty() ? "contents" : ", contents";
+    }
+    return details;
+}
+
+void generate_diff_tables(std::ostream& o, const ElfDiff& diff) {
+    uint64_t changed_bytes = 0;
+    for (const auto& section : diff.sections) {
+        changed_bytes += section.changed_bytes;
+    }
+
+    w(o, 2, "<table id='diff'>");
+    wrow(o, 3, "Compared with", html_escape(basename(diff.base_filename)));
+    wrow(o, 3, "ELF header", diff.header_changed ? "changed" : "same");
+    wrow(o, 3, "Changed bytes", human_format_bytes(changed_bytes));
+    w(o, 2, "</table>");
+
+    w(o, 2, "<table id='diff_sections'>");
+    w(o, 3, "<tr> <th>Section</th> <th>Status</th> <th>Old size</th> <th>New size</th> <th>Changed</th> <th>Moved</th> <th>Removed</th> </tr>");
+    for (const auto& section : diff.sections) {
+        if (section.status == DiffStatus::same) {
+            continue;
+        }
+        wnonl(o, 3, "<tr> ");
+        if (section.index && !section.changed.empty()) {
+            wnonl(o, 0, "<td><a href='#bin_section", *section.index, "'>", html_escape(section.name), "</a></td> ");
         } else {
-            wnonl(o, 0, ".");
+            wnonl(o, 0, "<td>", html_escape(section.name), "</td> ");
+        }
+        auto status = diff_status_to_string(section.status);
+        if (section.status == DiffStatus::changed) {
+            status += " (" + section_diff_details(section) + ")";
         }
+        wnonl(o, 0, "<td>", status, "</td> ");
+        wnonl(o, 0, "<td>", section.base_index ? std::to_string(section.base_size) : "", "</td> ");
+        wnonl(o, 0, "<td>", section.index ? std::to_string(section.size) : "", "</td> ");
+        wnonl(o, 0, "<td>", section.changed_bytes, "</td> ");
+        wnonl(o, 0, "<td>", section.moved_bytes, "</td> ");
+        wnonl(o, 0, "<td>", section.removed_bytes, "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
 
-        if ((i + 1) % 16 == 0) {
-            w(o, 0, "");
+    w(o, 2, "<table id='diff_segments'>");
+    w(o, 3, "<tr> <th>Segment</th> <th>Status</th> </tr>");
+    for (const auto& segment : diff.segments) {
+        if (segment.status == DiffStatus::same) {
+            continue;
         }
-        ++i;
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td>", ptype_to_string(segment.ptype), " #", segment.ordinal, "</td> ");
+        wnonl(o, 0, "<td>", diff_status_to_string(segment.status), "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+}
+
+// what parse found malformed; the offsets scroll the dump to the broken structure
+void generate_diagnostics_table(std::ostream& o, const ParsedElf& elf) {
+    w(o, 2, "<table id='diagnostics'>");
+    w(o, 3, "<tr> <th>Offset</th> <th>Structure</th> <th>Problem</th> </tr>");
+    for (const auto& diagnostic : elf.diagnostics) {
+        auto offset = int_to_hex(diagnostic.offset);
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td><a href='#", offset, "'>", offset, "</a></td> ");
+        wnonl(o, 0, "<td>", diagnostic.structure, "</td> ");
+        wnonl(o, 0, "<td>", diagnostic.problem, "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+}
+
+// sections only the separate debug file has contents for, with the symbol count taken from it
+void generate_debug_file_table(std::ostream& o, const ParsedElf& elf) {
+    const auto& debug = *elf.debug_file;
+
+    std::set<std::string> present;
+    for (const auto& shdr : elf.shdrs) {
+        if (shdr.shtype != SHT_NOBITS) {
+            present.insert(elf.shnstrtab().get(shdr.name));
+        }
+    }
+
+    w(o, 2, "<table id='debug_file'>");
+    w(o, 3, "<tr> <th>Debug section</th> <th>Type</th> <th>Size</th> </tr>");
+    for (size_t i = 1; i < debug.shdrs.size(); ++i) {
+        const auto& shdr = debug.shdrs[i];
+        auto name = debug.shnstrtab().get(shdr.name);
+        if (shdr.shtype == SHT_NOBITS || present.count(name) != 0) {
+            continue;
+        }
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td>", html_escape(name), "</td> ");
+        wnonl(o, 0, "<td>", shtype_to_string(shdr.shtype), "</td> ");
+        wnonl(o, 0, "<td>", shdr.size, "</td> ");
+        w(o, 0, "</tr>");
     }
+    wrow(o, 3, "Symbols", elf.symbols().size());
+    w(o, 2, "</table>");
 }
 
-void generate_body(std::stringstream& o, const ParsedElf& elf) {
+void generate_body(std::ostream& o, const ParsedElf& elf, const ElfDiff* diff) {
+    // the index holds every symbol name, more than a streamed report may keep
+    // resident, so streamed reports go without the search box
+    auto names = elf.source == nullptr ? NameIndex::build(elf) : NameIndex{};
+
     w(o, 1, "<body>");
 
     generate_svg_element(o);
@@ -535,14 +1055,35 @@ void generate_body(std::stringstream& o, const ParsedElf& elf) {
     generate_file_info_table(o, elf);
     w(o, 3, "</td>");
     w(o, 3, "<td id='rightmenu'>");
+    if (!names.names.empty()) {
+        generate_search_box(o);
+    }
     w(o, 4, "<p id='credits'>generated with elfcat 0.0.1</p>");
     w(o, 3, "</td>");
     w(o, 2, "</table>");
 
+    if (!elf.diagnostics.empty()) {
+        generate_diagnostics_table(o, elf);
+    }
+
+    if (elf.debug_file) {
+        generate_debug_file_table(o, elf);
+    }
+
+    if (elf.type == ELF_ET_CORE) {
+        generate_core_tables(o, elf);
+    }
+
+    if (diff) {
+        generate_diff_tables(o, *diff);
+    }
+
     w(o, 2, "<div id='offsets'></div>");
 
+    w(o, 2, "<div id='heatmap'></div>");
+
     w(o, 2, "<div id='bytes'>");
-    wnonl(o, 0, generate_file_dump(elf));
+    generate_file_dump(o, elf);
     w(o, 2, "</div>");
 
     w(o, 2, "<div id='ascii'>");
@@ -553,19 +1094,266 @@ void generate_body(std::stringstream& o, const ParsedElf& elf) {
 
     add_scripts(o, elf);
 
+    if (!names.names.empty()) {
+        add_search_script(o, names);
+    }
+
     w(o, 1, "</body>");
 }
 
-std::string generate_report(const ParsedElf& elf) {
+void generate_summary_body(std::ostream& o, const ParsedElf& elf, const ElfDiff* diff) {
+    w(o, 1, "<body>");
+
+    w(o, 2, "<table id='headertable'>");
+    w(o, 3, "<td>");
+    generate_file_info_table(o, elf);
+    w(o, 3, "</td>");
+    w(o, 3, "<td id='rightmenu'>");
+    w(o, 4, "<p id='credits'>generated with elfcat 0.0.1</p>");
+    w(o, 3, "</td>");
+    w(o, 2, "</table>");
+
+    if (!elf.diagnostics.empty()) {
+        generate_diagnostics_table(o, elf);
+    }
+
+    if (elf.debug_file) {
+        generate_debug_file_table(o, elf);
+    }
+
+    if (elf.type == ELF_ET_CORE) {
+        generate_core_tables(o, elf);
+    }
+
+    if (diff) {
+        generate_diff_tables(o, *diff);
+    }
+
+    w(o, 1, "</body>");
+}
+
+// only the file information table, plus the core tables for core files: reads nothing but headers
+// and notes, so it's cheap even on huge files
+std::string generate_summary_report(const ParsedElf& elf, const ElfDiff* diff) {
+    STATS_PHASE(phase, "render");
+
     std::stringstream output;
 
     w(output, 0, "<!doctype html>");
     w(output, 0, "<html>");
 
     generate_head(output, elf);
-    generate_body(output, elf);
+    generate_summary_body(output, elf, diff);
+
+    w(output, 0, "</html>");
+
+    auto report = output.str();
+    STATS_EMITTED(phase, report.size());
+    return report;
+}
+
+// the page of --serve: the full report without the byte statistics, which would need a
+// pass over the whole file, and with only the first window_rows rows of the dump; the
+// page fetches the others from rows_url as it is scrolled
+std::string generate_served_report(const ParsedElf& elf, const std::string& rows_url, size_t window_rows) {
+    STATS_PHASE(phase, "render");
+
+    std::stringstream o;
+    size_t rows = (elf.file_size + 15) / 16;
+    auto names = NameIndex::build(elf);
+
+    w(o, 0, "<!doctype html>");
+    w(o, 0, "<html>");
+
+    generate_head(o, elf);
+
+    w(o, 1, "<body>");
+
+    w(o, 2, "<table id='headertable'>");
+    w(o, 3, "<td>");
+    generate_file_info_table(o, elf);
+    w(o, 3, "</td>");
+    w(o, 3, "<td id='rightmenu'>");
+    if (!names.names.empty()) {
+        generate_search_box(o);
+    }
+    w(o, 4, "<p id='credits'>generated with elfcat 0.0.1</p>");
+    w(o, 3, "</td>");
+    w(o, 2, "</table>");
+
+    if (!elf.diagnostics.empty()) {
+        generate_diagnostics_table(o, elf);
+    }
+
+    if (elf.debug_file) {
+        generate_debug_file_table(o, elf);
+    }
+
+    if (elf.type == ELF_ET_CORE) {
+        generate_core_tables(o, elf);
+    }
+
+    size_t first_rows = std::min(rows, window_rows);
+    size_t first_end = std::min(elf.file_size, first_rows * 16);
+    auto first_runs = runs_in_window(elf, 0, first_rows);
+
+    wnonl(o, 2, "<div id='offsets'><div>");
+    generate_offset_rows(o, 0, first_rows, first_runs);
+    w(o, 0, "</div></div>");
+
+    wnonl(o, 2, "<div id='bytes'><div>");
+    generate_dump_window(o, elf, 0, first_end, first_runs);
+    w(o, 0, "</div></div>");
+
+    wnonl(o, 2, "<div id='ascii'><div>");
+    generate_ascii_window(o, elf, 0, first_end, first_runs);
+    w(o, 0, "</div></div>");
+
+    generate_sticky_info_table(o, elf, false);
+
+    add_highlight_script(o);
+    add_description_script(o);
+    add_conceal_script(o);
+    add_windows_script(o, elf, rows_url, window_rows);
+    if (!names.names.empty()) {
+        add_search_script(o, names);
+    }
+
+    w(o, 1, "</body>");
+    w(o, 0, "</html>");
+
+    auto report = o.str();
+    STATS_EMITTED(phase, report.size());
+    return report;
+}
+
+void write_report(std::ostream& output, const ParsedElf& elf, const ElfDiff* diff) {
+    STATS_PHASE(phase, "render");
+
+    auto emitted_at_start = output.tellp();
+
+    w(output, 0, "<!doctype html>");
+    w(output, 0, "<html>");
+
+    generate_head(output, elf);
+    generate_body(output, elf, diff);
 
     w(output, 0, "</html>");
 
+    STATS_EMITTED(phase, output.tellp() - emitted_at_start);
+}
+
+std::string generate_report(const ParsedElf& elf, const ElfDiff* diff) {
+    std::stringstream output;
+    write_report(output, elf, diff);
     return output.str();
 }
+
+void generate_archive_info_table(std::ostream& o, const ParsedArchive& archive) {
+    size_t elf_members = std::count_if(archive.elves.cbegin(), archive.elves.cend(),
+            [](const auto& elf) { return elf.has_value(); });
+
+    w(o, 4, "<table>");
+    wrow(o, 5, "File name", html_escape(archive.filename));
+    wrow(o, 5, "File size", human_format_bytes(archive.file_size) + " (" + std::to_string(archive.file_size) + " B)");
+    wrow(o, 5, "Members", archive.archive.members.size());
+    wrow(o, 5, "ELF members", elf_members);
+    wrow(o, 5, "Indexed symbols", archive.archive.symbols.size());
+    w(o, 4, "</table>");
+}
+
+// every section name across the ELF members, with how many members have it and
+// their total size, largest first
+void generate_archive_section_table(std::ostream& o, const ParsedArchive& archive) {
+    std::map<std::string, std::tuple<size_t, uint64_t>> totals;
+    for (const auto& elf : archive.elves) {
+        if (!elf) {
+            continue;
+        }
+        for (size_t i = 1; i < elf->shdrs.size(); ++i) {
+            auto& [members, size] = totals[elf->shnstrtab().get(elf->shdrs[i].name)];
+            ++members;
+            size += elf->shdrs[i].size;
+        }
+    }
+
+    std::vector<std::tuple<std::string, size_t, uint64_t>> rows;
+    for (const auto& [name, total] : totals) {
+        rows.emplace_back(name, std::get<0>(total), std::get<1>(total));
+    }
+    std::stable_sort(rows.begin(), rows.end(),
+            [](const auto& lhs, const auto& rhs) { return std::get<2>(lhs) > std::get<2>(rhs); });
+
+    w(o, 2, "<table id='archive_sections'>");
+    w(o, 3, "<tr> <th>Section</th> <th>Members</th> <th>Total size</th> </tr>");
+    for (const auto& [name, members, size] : rows) {
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td>", html_escape(name), "</td> ");
+        wnonl(o, 0, "<td>", members, "</td> ");
+        wnonl(o, 0, "<td>", size, "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+}
+
+void generate_archive_member_table(std::ostream& o, const ParsedArchive& archive) {
+    std::vector<size_t> indexed(archive.archive.members.size());
+    for (const auto& symbol : archive.archive.symbols) {
+        ++indexed[symbol.member];
+    }
+
+    w(o, 2, "<table id='archive_members'>");
+    w(o, 3, "<tr> <th>Member</th> <th>Offset</th> <th>Size</th> <th>Type</th> <th>Machine</th> <th>Sections</th> <th>Indexed symbols</th> </tr>");
+    for (size_t i = 0; i < archive.archive.members.size(); ++i) {
+        const auto& member = archive.archive.members[i];
+        const auto& elf = archive.elves[i];
+
+        wnonl(o, 3, "<tr id='member", i, "'> ");
+        wnonl(o, 0, "<td>", html_escape(member.name), "</td> ");
+        wnonl(o, 0, "<td>", int_to_hex(member.offset), "</td> ");
+        wnonl(o, 0, "<td>", member.size, "</td> ");
+        if (elf) {
+            wnonl(o, 0, "<td>", type_to_string(elf->type), "</td> ");
+            wnonl(o, 0, "<td>", machine_to_string(elf->machine), "</td> ");
+            wnonl(o, 0, "<td>", elf->shdrs.empty() ? 0 : elf->shdrs.size() - 1, "</td> ");
+        } else {
+            wnonl(o, 0, "<td colspan='3'>", html_escape(archive.errors[i]), "</td> ");
+        }
+        wnonl(o, 0, "<td>", indexed[i], "</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+}
+
+// one page for the whole archive: the members and what they add up to, no byte dumps
+std::string generate_archive_report(const ParsedArchive& archive) {
+    STATS_PHASE(phase, "render");
+
+    std::stringstream output;
+
+    w(output, 0, "<!doctype html>");
+    w(output, 0, "<html>");
+
+    generate_head(output, html_escape(basename(archive.filename)));
+
+    w(output, 1, "<body>");
+
+    w(output, 2, "<table id='headertable'>");
+    w(output, 3, "<td>");
+    generate_archive_info_table(output, archive);
+    w(output, 3, "</td>");
+    w(output, 3, "<td id='rightmenu'>");
+    w(output, 4, "<p id='credits'>generated with elfcat 0.0.1</p>");
+    w(output, 3, "</td>");
+    w(output, 2, "</table>");
+
+    generate_archive_section_table(output, archive);
+    generate_archive_member_table(output, archive);
+
+    w(output, 1, "</body>");
+    w(output, 0, "</html>");
+
+    auto report = output.str();
+    STATS_EMITTED(phase, report.size());
+    return report;
+}
@@ -1,27 +1,34 @@
+#include <ostream>
 #include <sstream>
 #include <string>
 #include <vector>
 #include "utils.hpp"
+#include <archive.hpp>
+#include <elf_diff.hpp>
+#include <name_index.hpp>
 #include <parser.hpp>
 
 
 const std::string INDENT = "  ";
 
+// the byte and ascii dumps read contents in chunks of this size
+constexpr size_t DUMP_CHUNK_SIZE = 1 << 20;
+
 
 template<class... parameters>
-void wnonl(std::stringstream& ss, uint32_t indent_level, const parameters&... values) {
+void wnonl(std::ostream& ss, uint32_t indent_level, const parameters&... values) {
     ss << repeat(INDENT, indent_level);
     ((ss << values), ...);
 }
 
 template<class... parameters>
-void w(std::stringstream& ss, uint32_t indent_level, const parameters&... values) {
+void w(std::ostream& ss, uint32_t indent_level, const parameters&... values) {
     wnonl(ss, indent_level, values...);
-    ss << std::endl;
+    ss << '\n';
 }
 
 template<class lhs, class rhs>
-void wrow(std::stringstream& ss, uint32_t indent_level, const lhs& lhs_value, const rhs& rhs_value) {
+void wrow(std::ostream& ss, uint32_t indent_level, const lhs& lhs_value, const rhs& rhs_value) {
     wnonl(ss, indent_level, "<tr> ");
     wnonl(ss, 0, "<td>", lhs_value, ":</td> ");
     wnonl(ss, 0, "<td>", rhs_value, "</td> ");
@@ -31,38 +38,72 @@ void wrow(std::stringstream& ss, uint32_t indent_level, const lhs& lhs_value, co
 std::string basename(const std::string& path);
 std::string stem(const std::string path);
 std::string construct_filename(const std::string& filename);
+std::string construct_diff_filename(const std::string& filename);
 std::string indent(size_t level, const std::string& line);
-void generate_head(std::stringstream& o, const ParsedElf& elf);
-void generate_svg_element(std::stringstream& o);
-void generate_file_info_table(std::stringstream& o, const ParsedElf& elf);
-void generate_phdr_info_table(std::stringstream& o, const ParsedPhdr& phdr, size_t idx);
-void generate_phdr_info_tables(std::stringstream& o, const ParsedElf& elf);
-void generate_shdr_info_table(std::stringstream& o, const ParsedElf& elf, const ParsedShdr& shdr, size_t idx);
-void generate_shdr_info_tables(std::stringstream& o, const ParsedElf& elf);
+void generate_head(std::ostream& o, const ParsedElf& elf);
+void generate_head(std::ostream& o, const std::string& title);
+void generate_svg_element(std::ostream& o);
+std::string header_table_markup(const std::string& prefix, size_t num, size_t entsize, size_t offset);
+void generate_file_info_table(std::ostream& o, const ParsedElf& elf);
+std::string segment_sections_string(const ParsedElf& elf, size_t idx);
+void add_byte_stats_items(std::vector<std::tuple<std::string, std::string>>& items, const ByteSummary& summary);
+void generate_phdr_info_table(std::ostream& o, const ParsedElf& elf, const ParsedPhdr& phdr, size_t idx, bool byte_stats = true);
+void generate_phdr_info_tables(std::ostream& o, const ParsedElf& elf, bool byte_stats = true);
+void generate_shdr_info_table(std::ostream& o, const ParsedElf& elf, const ParsedShdr& shdr, size_t idx, bool byte_stats = true);
+void generate_shdr_info_tables(std::ostream& o, const ParsedElf& elf, bool byte_stats = true);
 std::string format_string_byte(uint8_t byte);
 std::string format_string_slice(const std::vector<uint8_t>& slice);
-void generate_note_data(std::stringstream& o, const Note& note);
-void generate_segment_info_table(std::stringstream& o, const ParsedElf& elf, const ParsedPhdr& phdr);
-void generate_strtab_data(std::stringstream& o, const std::vector<uint8_t>& section);
-void generate_section_info_table(std::stringstream& o, const ParsedElf& elf, const ParsedShdr& shdr);
+void generate_note_data(std::ostream& o, const Note& note);
+void generate_segment_info_table(std::ostream& o, const ParsedElf& elf, const ParsedPhdr& phdr);
+void generate_strtab_data(std::ostream& o, const std::vector<uint8_t>& section);
+void generate_section_info_table(std::ostream& o, const ParsedElf& elf, const ParsedShdr& shdr);
 bool has_segment_detail(uint32_t ptype);
 bool has_section_detail(uint32_t ptype);
-void generate_segment_info_tables(std::stringstream& o, const ParsedElf& elf);
-void generate_section_info_tables(std::stringstream& o, const ParsedElf& elf);
-void generate_sticky_info_table(std::stringstream& o, const ParsedElf& elf);
-void add_highlight_script(std::stringstream& o);
-void add_description_script(std::stringstream& o);
-void add_conceal_script(std::stringstream& o);
-void add_offsets_script(std::stringstream& o, const ParsedElf& elf);
-void add_arrows_script(std::stringstream& o, const ParsedElf& elf);
-void add_collapsible_script(std::stringstream& o);
-void add_scripts(std::stringstream& o, const ParsedElf& elf);
+void generate_segment_info_tables(std::ostream& o, const ParsedElf& elf);
+void generate_section_info_tables(std::ostream& o, const ParsedElf& elf);
+// without byte_stats nothing but the headers is read
+void generate_sticky_info_table(std::ostream& o, const ParsedElf& elf, bool byte_stats = true);
+void add_highlight_script(std::ostream& o);
+void add_description_script(std::ostream& o);
+void add_conceal_script(std::ostream& o);
+void add_repeated_rows_variable(std::ostream& o, const ParsedElf& elf);
+void add_offsets_script(std::ostream& o, const ParsedElf& elf);
+void add_heatmap_script(std::ostream& o, const ParsedElf& elf);
+void add_windows_script(std::ostream& o, const ParsedElf& elf, const std::string& rows_url, size_t window_rows);
+void add_arrows_script(std::ostream& o, const ParsedElf& elf);
+void add_collapsible_script(std::ostream& o);
+std::string js_byte_string(const std::string& text);
+void generate_search_box(std::ostream& o);
+void add_search_script(std::ostream& o, const NameIndex& index);
+void add_scripts(std::ostream& o, const ParsedElf& elf);
 std::string format_magic(uint8_t byte);
 char digit_to_hex(uint8_t digit);
-void append_hex_byte(std::stringstream& s, uint8_t byte);
-void generate_dump_for_byte(size_t idx, std::stringstream& dump, const ParsedElf& elf);
+void append_hex_byte(std::ostream& s, uint8_t byte);
+void generate_dump_for_byte(size_t idx, uint8_t byte, std::ostream& dump, const Ranges& ranges);
 std::optional<size_t> skip_bytes(size_t idx, size_t len, const ParsedElf& elf);
+void generate_file_dump(std::ostream& dump, const ParsedElf& elf);
 std::string generate_file_dump(const ParsedElf& elf);
-void generate_ascii_dump(std::stringstream& o, const ParsedElf& elf);
-void generate_body(std::stringstream& o, const ParsedElf& elf);
-std::string generate_report(const ParsedElf& elf);
+void generate_ascii_rows(std::ostream& o, const ParsedElf& elf, size_t start, size_t end);
+void generate_ascii_dump(std::ostream& o, const ParsedElf& elf);
+std::vector<RepeatedRows> runs_in_window(const ParsedElf& elf, size_t first_row, size_t last_row);
+void generate_dump_window(std::ostream& dump, const ParsedElf& elf, size_t start, size_t end,
+        const std::vector<RepeatedRows>& runs);
+void generate_offset_rows(std::ostream& o, size_t first_row, size_t last_row, const std::vector<RepeatedRows>& runs);
+void generate_ascii_window(std::ostream& o, const ParsedElf& elf, size_t start, size_t end, const std::vector<RepeatedRows>& runs);
+void generate_rows_window(std::ostream& o, const ParsedElf& elf, size_t first_row, size_t last_row);
+void generate_core_tables(std::ostream& o, const ParsedElf& elf);
+std::string section_diff_details(const SectionDiff& section);
+void generate_diff_tables(std::ostream& o, const ElfDiff& diff);
+void generate_diagnostics_table(std::ostream& o, const ParsedElf& elf);
+void generate_debug_file_table(std::ostream& o, const ParsedElf& elf);
+// with a diff, its tables go under the file information and the changed bytes are marked
+void generate_body(std::ostream& o, const ParsedElf& elf, const ElfDiff* diff = nullptr);
+void generate_summary_body(std::ostream& o, const ParsedElf& elf, const ElfDiff* diff = nullptr);
+std::string generate_summary_report(const ParsedElf& elf, const ElfDiff* diff = nullptr);
+void write_report(std::ostream& output, const ParsedElf& elf, const ElfDiff* diff = nullptr);
+std::string generate_report(const ParsedElf& elf, const ElfDiff* diff = nullptr);
+std::string generate_served_report(const ParsedElf& elf, const std::string& rows_url, size_t window_rows);
+void generate_archive_info_table(std::ostream& o, const ParsedArchive& archive);
+void generate_archive_section_table(std::ostream& o, const ParsedArchive& archive);
+void generate_archive_member_table(std::ostream& o, const ParsedArchive& archive);
+std::string generate_archive_report(const ParsedArchive& archive);
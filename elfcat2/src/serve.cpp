@@ -0,0 +1,320 @@
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <mapped_file.hpp>
+#include <stats.hpp>
+
+#include "report_gen.hpp"
+#include "serve.hpp"
+
+
+namespace {
+
+constexpr size_t MAX_REQUEST_SIZE = 16 * 1024;
+
+
+struct ServedFile {
+    std::string filename;
+    MappedFile file;
+    std::optional<ParsedElf> elf;
+    // built on the first request
+    std::string page;
+};
+
+
+// rendered windows by "file/from/to", least recently used dropped first once
+// the total size goes over budget
+struct WindowCache {
+    const std::string* get(const std::string& key) {
+        auto found = index.find(key);
+        if (found == index.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, found->second);
+        return &found->second->second;
+    }
+
+    const std::string& put(const std::string& key, std::string window) {
+        size += window.size();
+        entries.emplace_front(key, std::move(window));
+        index[key] = entries.begin();
+
+        // the newest entry stays even when it alone is over budget
+        while (size > budget && entries.size() > 1) {
+            size -= entries.back().second.size();
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        return entries.front().second;
+    }
+
+    size_t budget;
+    size_t size = 0;
+    std::list<std::pair<std::string, std::string>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::string>>::iterator> index;
+};
+
+
+struct Request {
+    std::string path;
+    std::string query;
+    std::string host;
+};
+
+
+// the Host header, lowercased; empty when there is none
+std::string host_header(const std::string& headers) {
+    size_t pos = 0;
+    while ((pos = headers.find("\r\n", pos)) != std::string::npos) {
+        pos += 2;
+        auto end = headers.find("\r\n", pos);
+        auto line = headers.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        auto name = line.substr(0, colon);
+        for (auto& c : name) {
+            c = std::tolower(static_cast<unsigned char>(c));
+        }
+        if (name != "host") {
+            continue;
+        }
+        auto value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t") + 1);
+        for (auto& c : value) {
+            c = std::tolower(static_cast<unsigned char>(c));
+        }
+        return value;
+    }
+    return {};
+}
+
+// a page on any other origin can still point its own name at 127.0.0.1 (DNS
+// rebinding), so only requests naming this server by address are answered
+bool allowed_host(const std::string& host, uint16_t port) {
+    auto suffix = ":" + std::to_string(port);
+    return host == "127.0.0.1" + suffix || host == "localhost" + suffix
+        || (port == 80 && (host == "127.0.0.1" || host == "localhost"));
+}
+
+// only the request line and Host matter; other headers and bodies are read past and ignored
+std::optional<Request> read_request(int client) {
+    std::string data;
+    char buffer[4096];
+
+    while (data.find("\r\n\r\n") == std::string::npos && data.size() < MAX_REQUEST_SIZE) {
+        auto size = recv(client, buffer, sizeof(buffer), 0);
+        if (size <= 0) {
+            return std::nullopt;
+        }
+        data.append(buffer, size);
+    }
+
+    std::istringstream line(data.substr(0, data.find("\r\n")));
+    std::string method, target;
+    if (!(line >> method >> target) || method != "GET" || target.empty() || target[0] != '/') {
+        return std::nullopt;
+    }
+
+    auto host = host_header(data.substr(0, data.find("\r\n\r\n")));
+    auto question = target.find('?');
+    if (question == std::string::npos) {
+        return Request{target, {}, host};
+    }
+    return Request{target.substr(0, question), target.substr(question + 1), host};
+}
+
+std::optional<size_t> query_value(const std::string& query, const std::string& name) {
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        auto end = query.find('&', pos);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        auto pair = std::string_view(query).substr(pos, end - pos);
+        if (pair.size() > name.size() && pair.substr(0, name.size()) == name && pair[name.size()] == '=') {
+            auto text = pair.substr(name.size() + 1);
+            size_t value = 0;
+            auto [last, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc() || last != text.data() + text.size()) {
+                return std::nullopt;
+            }
+            return value;
+        }
+        pos = end + 1;
+    }
+    return std::nullopt;
+}
+
+void send_all(int client, const char* data, size_t size) {
+    while (size > 0) {
+        // the browser may hang up first, which mustn't raise SIGPIPE
+        auto sent = send(client, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return;
+        }
+        data += sent;
+        size -= sent;
+    }
+}
+
+void respond(int client, const std::string& status, const std::string& body, const std::string& type = "text/html; charset=utf-8") {
+    auto header = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: " + type + "\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Cache-Control: no-store\r\n"
+        "Connection: close\r\n\r\n";
+    send_all(client, header.data(), header.size());
+    send_all(client, body.data(), body.size());
+}
+
+std::string index_page(const std::vector<ServedFile>& files) {
+    std::stringstream o;
+    w(o, 0, "<!doctype html>");
+    w(o, 0, "<html>");
+    generate_head(o, "elfcat");
+    w(o, 1, "<body>");
+    w(o, 2, "<table>");
+    for (size_t i = 0; i < files.size(); ++i) {
+        wnonl(o, 3, "<tr> ");
+        wnonl(o, 0, "<td><a href='/", i, "'>", html_escape(files[i].filename), "</a></td> ");
+        wnonl(o, 0, "<td>", human_format_bytes(files[i].elf->file_size), " (", files[i].elf->file_size, " B)</td> ");
+        w(o, 0, "</tr>");
+    }
+    w(o, 2, "</table>");
+    w(o, 1, "</body>");
+    w(o, 0, "</html>");
+    return o.str();
+}
+
+// "/", "/N", "/N/" and "/N/rows?from=A&to=B"
+void handle(int client, const Request& request, std::vector<ServedFile>& files, WindowCache& windows) {
+    if (request.path == "/" && files.size() > 1) {
+        respond(client, "200 OK", index_page(files));
+        return;
+    }
+
+    size_t file = 0;
+    std::string_view rest = request.path;
+    rest.remove_prefix(1);
+    if (!rest.empty()) {
+        auto [last, error] = std::from_chars(rest.data(), rest.data() + rest.size(), file);
+        if (error != std::errc() || file >= files.size()) {
+            respond(client, "404 Not Found", "no such file\n", "text/plain");
+            return;
+        }
+        rest.remove_prefix(last - rest.data());
+    }
+
+    auto& served = files[file];
+
+    if (rest.empty() || rest == "/") {
+        if (served.page.empty()) {
+            served.page = generate_served_report(*served.elf, "/" + std::to_string(file) + "/rows", SERVE_WINDOW_ROWS);
+        }
+        respond(client, "200 OK", served.page);
+        return;
+    }
+
+    if (rest != "/rows") {
+        respond(client, "404 Not Found", "no such page\n", "text/plain");
+        return;
+    }
+
+    auto from = query_value(request.query, "from");
+    auto to = query_value(request.query, "to");
+    size_t rows = (served.elf->file_size + 15) / 16;
+    if (!from || !to || *from >= *to || *to > rows || *to - *from > SERVE_MAX_WINDOW_ROWS) {
+        respond(client, "400 Bad Request", "bad row range\n", "text/plain");
+        return;
+    }
+
+    auto key = std::to_string(file) + "/" + std::to_string(*from) + "/" + std::to_string(*to);
+    auto cached = windows.get(key);
+    if (cached == nullptr) {
+        STATS_PHASE(phase, "window");
+        std::stringstream window;
+        generate_rows_window(window, *served.elf, *from, *to);
+        cached = &windows.put(key, window.str());
+        STATS_EMITTED(phase, cached->size());
+    }
+    respond(client, "200 OK", *cached);
+}
+
+}
+
+
+int serve_files(const std::vector<std::string>& filenames, uint16_t port, size_t cache_budget) {
+    std::vector<ServedFile> files(filenames.size());
+
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        auto& served = files[i];
+        served.filename = filenames[i];
+        try {
+            served.file = MappedFile::open(served.filename);
+            served.elf = ParsedElf::from_bytes(served.filename, served.file.view());
+        } catch (const std::runtime_error& e) {
+            std::cout << "Error: file '" << served.filename << "' can't be opened!" << std::endl;
+            return -1;
+        }
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    // nothing but this machine gets to read the files
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        std::cout << "Error: can't listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+
+    std::cout << "Serving http://127.0.0.1:" << port << "/" << std::endl;
+
+    WindowCache windows;
+    windows.budget = cache_budget;
+
+    // one request at a time: ParsedElf's caches aren't synchronized, and a window
+    // renders in milliseconds
+    while (true) {
+        int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+
+        timeval timeout = {5, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        if (auto request = read_request(client)) {
+            if (allowed_host(request->host, port)) {
+                handle(client, *request, files, windows);
+            } else {
+                respond(client, "403 Forbidden", "unknown host\n", "text/plain");
+            }
+        } else {
+            respond(client, "400 Bad Request", "bad request\n", "text/plain");
+        }
+
+        close(client);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+constexpr uint16_t SERVE_DEFAULT_PORT = 8080;
+// rows per window of the dump, 256 KiB of the file
+constexpr size_t SERVE_WINDOW_ROWS = 16384;
+// windows are never larger than this, whatever the page asks for
+constexpr size_t SERVE_MAX_WINDOW_ROWS = 65536;
+// rendered windows kept for scrolling back
+constexpr size_t SERVE_CACHE_BUDGET = 64 * 1024 * 1024;
+
+
+// Serves the reports of filenames on 127.0.0.1:port until killed. Each page is
+// built from the headers alone and carries the first window of the dump; the page
+// asks for further windows (/N/rows?from=A&to=B) as it is scrolled. Those are
+// rendered from the mapped file and kept in an LRU of at most cache_budget bytes,
+// so memory use doesn't depend on the size of the files. Returns only if a file
+// can't be opened or the port can't be bound.
+int serve_files(const std::vector<std::string>& filenames, uint16_t port, size_t cache_budget = SERVE_CACHE_BUDGET);
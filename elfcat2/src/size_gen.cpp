@@ -0,0 +1,128 @@
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+#include "size_gen.hpp"
+
+
+std::string format_size(uint64_t bytes) {
+    static const char* units[] = {"", "Ki", "Mi", "Gi", "Ti"};
+
+    double value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while (value >= 1024 && unit + 1 < std::size(units)) {
+        value /= 1024;
+        ++unit;
+    }
+
+    char buf[32];
+    if (unit == 0) {
+        std::snprintf(buf, sizeof(buf), "%" PRIu64, bytes);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.1f%s", value, units[unit]);
+    }
+    return buf;
+}
+
+std::string format_percent(double fraction) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f%%", fraction * 100);
+    return buf;
+}
+
+namespace {
+
+std::string format_delta(int64_t delta) {
+    auto text = format_size(static_cast<uint64_t>(std::abs(delta)));
+    return (delta < 0 ? "-" : "+") + text;
+}
+
+// relative to the base size; labels that only exist on one side are marked instead
+std::string format_change(int64_t delta, uint64_t base, uint64_t current) {
+    if (delta == 0) {
+        return "";
+    }
+    if (base == 0) {
+        return "[NEW]";
+    }
+    if (current == 0) {
+        return "[DEL]";
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%+.1f%%", 100.0 * static_cast<double>(delta) / static_cast<double>(base));
+    return buf;
+}
+
+void print_row(std::ostream& o, const std::string& file_percent, const std::string& file_size,
+        const std::string& vm_percent, const std::string& vm_size, const std::string& label) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%8s %8s %8s %8s    ", file_percent.c_str(), file_size.c_str(),
+            vm_percent.c_str(), vm_size.c_str());
+    o << buf << label << '\n';
+}
+
+double fraction(uint64_t part, uint64_t total) {
+    return total == 0 ? 0.0 : static_cast<double>(part) / static_cast<double>(total);
+}
+
+}
+
+void print_size_report(std::ostream& o, const SizeReport& report) {
+    print_row(o, "FILE", "SIZE", "VM", "SIZE", "");
+    print_row(o, "--------", "--------", "--------", "--------", "");
+
+    auto shown = std::min(report.rows.size(), SIZE_ROWS_SHOWN);
+
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& row = report.rows[i];
+        print_row(o, format_percent(fraction(row.file_size, report.file_total)), format_size(row.file_size),
+                format_percent(fraction(row.vm_size, report.vm_total)), format_size(row.vm_size), row.label);
+    }
+
+    if (shown < report.rows.size()) {
+        uint64_t file_size = 0;
+        uint64_t vm_size = 0;
+        for (size_t i = shown; i < report.rows.size(); ++i) {
+            file_size += report.rows[i].file_size;
+            vm_size += report.rows[i].vm_size;
+        }
+        print_row(o, format_percent(fraction(file_size, report.file_total)), format_size(file_size),
+                format_percent(fraction(vm_size, report.vm_total)), format_size(vm_size),
+                "[" + std::to_string(report.rows.size() - shown) + " others]");
+    }
+
+    print_row(o, "100.0%", format_size(report.file_total), "100.0%", format_size(report.vm_total), "TOTAL");
+}
+
+void print_size_diff(std::ostream& o, const SizeReport& current, const SizeReport& base) {
+    auto deltas = diff_size_reports(current, base);
+
+    print_row(o, "FILE", "SIZE", "VM", "SIZE", "");
+    print_row(o, "--------", "--------", "--------", "--------", "");
+
+    auto shown = std::min(deltas.size(), SIZE_ROWS_SHOWN);
+
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& delta = deltas[i];
+        auto file_size = static_cast<uint64_t>(static_cast<int64_t>(delta.base_file_size) + delta.file_delta);
+        auto vm_size = static_cast<uint64_t>(static_cast<int64_t>(delta.base_vm_size) + delta.vm_delta);
+        print_row(o, format_change(delta.file_delta, delta.base_file_size, file_size), format_delta(delta.file_delta),
+                format_change(delta.vm_delta, delta.base_vm_size, vm_size), format_delta(delta.vm_delta), delta.label);
+    }
+
+    if (shown < deltas.size()) {
+        int64_t file_delta = 0;
+        int64_t vm_delta = 0;
+        for (size_t i = shown; i < deltas.size(); ++i) {
+            file_delta += deltas[i].file_delta;
+            vm_delta += deltas[i].vm_delta;
+        }
+        print_row(o, "", format_delta(file_delta), "", format_delta(vm_delta),
+                "[" + std::to_string(deltas.size() - shown) + " others]");
+    }
+
+    auto file_delta = static_cast<int64_t>(current.file_total) - static_cast<int64_t>(base.file_total);
+    auto vm_delta = static_cast<int64_t>(current.vm_total) - static_cast<int64_t>(base.vm_total);
+    print_row(o, format_change(file_delta, base.file_total, current.file_total), format_delta(file_delta),
+            format_change(vm_delta, base.vm_total, current.vm_total), format_delta(vm_delta), "TOTAL");
+}
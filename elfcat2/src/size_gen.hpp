@@ -0,0 +1,14 @@
+#pragma once
+
+#include <ostream>
+
+#include <size_report.hpp>
+
+
+// number of rows printed before the rest is folded into "[N others]"
+constexpr size_t SIZE_ROWS_SHOWN = 40;
+
+std::string format_size(uint64_t bytes);
+std::string format_percent(double fraction);
+void print_size_report(std::ostream& o, const SizeReport& report);
+void print_size_diff(std::ostream& o, const SizeReport& current, const SizeReport& base);
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "include/block_cache.hpp"
+
+
+BlockCache BlockCache::open(const std::string& path, size_t budget, size_t block_size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("can't open '" + path + "': " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("'" + path + "' is not a regular file");
+    }
+
+    BlockCache cache;
+    cache.fd = fd;
+    cache.file_size = static_cast<size_t>(st.st_size);
+    // a budget below one block gets a single block of the budget's size
+    cache.block_size = std::max<size_t>(1, std::min(block_size, budget));
+    cache.max_blocks = std::max<size_t>(1, budget / cache.block_size);
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    return cache;
+}
+
+BlockCache::BlockCache(BlockCache&& other) noexcept {
+    *this = std::move(other);
+}
+
+BlockCache& BlockCache::operator=(BlockCache&& other) noexcept {
+    if (this != &other) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = std::exchange(other.fd, -1);
+        file_size = other.file_size;
+        block_size = other.block_size;
+        max_blocks = other.max_blocks;
+        lru = std::move(other.lru);
+        blocks = std::move(other.blocks);
+        hits = other.hits;
+        misses = other.misses;
+    }
+    return *this;
+}
+
+BlockCache::~BlockCache() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+const BlockCache::Block& BlockCache::block(size_t index) const {
+    auto found = blocks.find(index);
+    if (found != blocks.end()) {
+        ++hits;
+        lru.splice(lru.begin(), lru, found->second);
+        return lru.front();
+    }
+
+    ++misses;
+
+    // recycle the least recently used buffer instead of allocating a new one
+    if (lru.size() >= max_blocks) {
+        blocks.erase(lru.back().index);
+        lru.splice(lru.begin(), lru, std::prev(lru.end()));
+    } else {
+        lru.emplace_front();
+    }
+
+    auto& block = lru.front();
+    size_t start = index * block_size;
+    size_t len = std::min(block_size, file_size - start);
+
+    block.index = index;
+    block.data.resize(len);
+
+    size_t done = 0;
+    while (done < len) {
+        auto got = pread(fd, block.data.data() + done, len - done, static_cast<off_t>(start + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            blocks.erase(index);
+            lru.pop_front();
+            throw std::runtime_error(std::string("read failed: ") + (got < 0 ? std::strerror(errno) : "unexpected end of file"));
+        }
+        done += static_cast<size_t>(got);
+    }
+
+    blocks[index] = lru.begin();
+    return block;
+}
+
+void BlockCache::read(size_t start, size_t end, uint8_t* out) const {
+    if (end < start || end > file_size) {
+        throw std::runtime_error("read past the end of file");
+    }
+
+    while (start < end) {
+        const auto& b = block(start / block_size);
+        size_t in_block = start - b.index * block_size;
+        size_t len = std::min(end - start, b.data.size() - in_block);
+
+        std::memcpy(out, b.data.data() + in_block, len);
+        out += len;
+        start += len;
+    }
+}
+
+uint8_t BlockCache::at(size_t offset) const {
+    if (offset >= file_size) {
+        throw std::runtime_error("read past the end of file");
+    }
+    const auto& b = block(offset / block_size);
+    return b.data[offset - b.index * block_size];
+}
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "include/file_walk.hpp"
+
+
+namespace {
+
+void walk(const std::string& directory, std::vector<std::string>& files) {
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+
+    while (auto* entry = readdir(dir)) {
+        if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        auto path = directory + "/" + entry->d_name;
+        auto type = entry->d_type;
+
+        // not every file system fills d_type in
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (lstat(path.c_str(), &st) != 0) {
+                continue;
+            }
+            type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+
+        if (type == DT_DIR) {
+            walk(path, files);
+        } else if (type == DT_REG) {
+            files.push_back(std::move(path));
+        }
+    }
+
+    closedir(dir);
+}
+
+}
+
+
+std::vector<std::string> list_regular_files(const std::string& root) {
+    struct stat st;
+    if (stat(root.c_str(), &st) != 0) {
+        throw std::runtime_error("can't open '" + root + "': " + std::strerror(errno));
+    }
+    if (S_ISREG(st.st_mode)) {
+        return {root};
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        throw std::runtime_error("'" + root + "' is neither a directory nor a regular file");
+    }
+
+    std::vector<std::string> files;
+    walk(root.size() > 1 && root.back() == '/' ? root.substr(0, root.size() - 1) : root, files);
+    std::sort(files.begin(), files.end());
+    return files;
+}
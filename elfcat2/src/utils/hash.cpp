@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ELFCAT_SHA_NI
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#include "include/hash.hpp"
+
+
+namespace {
+
+constexpr uint64_t PRIME1 = 0x9e3779b185ebca87ULL;
+constexpr uint64_t PRIME2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr uint64_t PRIME3 = 0x165667b19e3779f9ULL;
+constexpr uint64_t PRIME4 = 0x85ebca77c2b2ae63ULL;
+constexpr uint64_t PRIME5 = 0x27d4eb2f165667c5ULL;
+
+uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// little endian loads; memcpy keeps them alignment-safe
+uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// slicing-by-8: CRC_TABLES[k][b] is the CRC of byte b followed by k zero bytes
+constexpr auto CRC_TABLES = [] {
+    std::array<std::array<uint32_t, 256>, 8> tables = {};
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        uint32_t crc = byte;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320U : 0);
+        }
+        tables[0][byte] = crc;
+    }
+    for (size_t k = 1; k < 8; ++k) {
+        for (size_t byte = 0; byte < 256; ++byte) {
+            auto previous = tables[k - 1][byte];
+            tables[k][byte] = (previous >> 8) ^ tables[0][previous & 0xff];
+        }
+    }
+    return tables;
+}();
+
+uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+uint64_t merge_round(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+uint64_t merge_lanes(uint64_t v1, uint64_t v2, uint64_t v3, uint64_t v4) {
+    uint64_t hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    hash = merge_round(hash, v1);
+    hash = merge_round(hash, v2);
+    hash = merge_round(hash, v3);
+    return merge_round(hash, v4);
+}
+
+// the bytes after the last 32-byte stripe, then the avalanche
+uint64_t finish_xxhash64(uint64_t hash, const uint8_t* p, const uint8_t* end) {
+    while (p + 8 <= end) {
+        hash ^= round(0, read64(p));
+        hash = rotl(hash, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        hash ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+        hash = rotl(hash, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+
+    while (p < end) {
+        hash ^= *p * PRIME5;
+        hash = rotl(hash, 11) * PRIME1;
+        ++p;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+constexpr uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+uint32_t rotr32(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+uint32_t read32_be(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+void sha256_blocks_portable(uint32_t* state, const uint8_t* data, size_t blocks) {
+    for (; blocks > 0; --blocks, data += 64) {
+        uint32_t w[64];
+        for (int t = 0; t < 16; ++t) {
+            w[t] = read32_be(data + 4 * t);
+        }
+        for (int t = 16; t < 64; ++t) {
+            uint32_t s0 = rotr32(w[t - 15], 7) ^ rotr32(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            uint32_t s1 = rotr32(w[t - 2], 17) ^ rotr32(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; ++t) {
+            uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+            uint32_t choice = (e & f) ^ (~e & g);
+            uint32_t temp1 = h + s1 + choice + SHA256_K[t] + w[t];
+            uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+            uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t temp2 = s0 + majority;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef ELFCAT_SHA_NI
+
+// four rounds per step with sha256rnds2; the message schedule for the steps
+// ahead is computed in the four registers of msg as their words are used up
+__attribute__((target("sha,sse4.1,ssse3")))
+void sha256_blocks_sha_ni(uint32_t* state, const uint8_t* data, size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // the instructions want the state as ABEF and CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        __m128i abef = state0;
+        __m128i cdgh = state1;
+        __m128i msg[4];
+
+        // unrolled, msg lives in registers: twice as fast
+#pragma GCC unroll 16
+        for (int i = 0; i < 16; ++i) {
+            if (i < 4) {
+                msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byte_swap);
+            }
+
+            __m128i words = _mm_add_epi32(msg[i % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(SHA256_K + 4 * i)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, words);
+
+            if (i >= 3 && i < 15) {
+                __m128i& next = msg[(i + 1) % 4];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(msg[i % 4], msg[(i + 3) % 4], 4));
+                next = _mm_sha256msg2_epu32(next, msg[i % 4]);
+            }
+
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(words, 0x0e));
+
+            if (i >= 1 && i < 13) {
+                msg[(i + 3) % 4] = _mm_sha256msg1_epu32(msg[(i + 3) % 4], msg[i % 4]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+bool has_sha_ni() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1)) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & (1u << 29)) != 0;
+}
+
+#endif
+
+void sha256_blocks(uint32_t* state, const uint8_t* data, size_t blocks) {
+#ifdef ELFCAT_SHA_NI
+    static const bool sha_ni = has_sha_ni();
+    if (sha_ni) {
+        sha256_blocks_sha_ni(state, data, blocks);
+        return;
+    }
+#endif
+    sha256_blocks_portable(state, data, blocks);
+}
+
+}
+
+uint64_t xxhash64(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint64_t hash;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+
+        hash = merge_lanes(v1, v2, v3, v4);
+    } else {
+        hash = seed + PRIME5;
+    }
+
+    return finish_xxhash64(hash + size, p, end);
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    const auto& t = CRC_TABLES;
+
+    crc = ~crc;
+
+    while (p + 8 <= end) {
+        uint32_t low = read32(p) ^ crc;
+        uint32_t high = read32(p + 4);
+        crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24]
+            ^ t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+        p += 8;
+    }
+
+    while (p < end) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+        ++p;
+    }
+
+    return ~crc;
+}
+
+Xxh64::Xxh64(uint64_t seed)
+    : seed(seed)
+    , lanes{seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1} {
+}
+
+void Xxh64::update(const uint8_t* data, size_t size) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    length += size;
+
+    auto consume = [&](const uint8_t* stripe) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            lanes[lane] = round(lanes[lane], read64(stripe + 8 * lane));
+        }
+    };
+
+    if (buffered != 0) {
+        size_t taken = std::min(size, buffer.size() - buffered);
+        std::memcpy(buffer.data() + buffered, p, taken);
+        buffered += taken;
+        p += taken;
+        if (buffered < buffer.size()) {
+            return;
+        }
+        consume(buffer.data());
+        buffered = 0;
+    }
+
+    for (; p + 32 <= end; p += 32) {
+        consume(p);
+    }
+
+    std::memcpy(buffer.data(), p, end - p);
+    buffered = end - p;
+}
+
+uint64_t Xxh64::digest() const {
+    uint64_t hash = (length >= 32) ? merge_lanes(lanes[0], lanes[1], lanes[2], lanes[3]) : seed + PRIME5;
+    return finish_xxhash64(hash + length, buffer.data(), buffer.data() + buffered);
+}
+
+void Sha256::update(const uint8_t* data, size_t size) {
+    length += size;
+
+    if (buffered != 0) {
+        size_t taken = std::min(size, buffer.size() - buffered);
+        std::memcpy(buffer.data() + buffered, data, taken);
+        buffered += taken;
+        data += taken;
+        size -= taken;
+        if (buffered < buffer.size()) {
+            return;
+        }
+        sha256_blocks(state.data(), buffer.data(), 1);
+        buffered = 0;
+    }
+
+    sha256_blocks(state.data(), data, size / 64);
+    data += size / 64 * 64;
+    size %= 64;
+
+    std::memcpy(buffer.data(), data, size);
+    buffered = size;
+}
+
+std::array<uint8_t, 32> Sha256::finish() {
+    uint64_t bits = length * 8;
+
+    // 0x80, zeros up to 56 mod 64, then the length in bits, big endian
+    uint8_t padding[72] = {0x80};
+    size_t padding_size = (buffered < 56 ? 56 : 120) - buffered;
+    for (int i = 0; i < 8; ++i) {
+        padding[padding_size + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+    update(padding, padding_size + 8);
+
+    std::array<uint8_t, 32> digest;
+    for (size_t i = 0; i < 8; ++i) {
+        digest[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(state[i]);
+    }
+    return digest;
+}
+
+std::array<uint8_t, 32> sha256(const uint8_t* data, size_t size) {
+    Sha256 sha;
+    sha.update(data, size);
+    return sha.finish();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.hpp"
+
+
+// pread-backed file reader with an LRU cache of fixed-size blocks. Resident
+// memory never exceeds the budget given at open, whatever the file size; blocks
+// shrink to the budget when it is smaller than one.
+struct BlockCache {
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 << 10;
+    static constexpr size_t DEFAULT_BUDGET = 64 << 20;
+
+    static BlockCache open(const std::string& path, size_t budget = DEFAULT_BUDGET, size_t block_size = DEFAULT_BLOCK_SIZE);
+
+    BlockCache() = default;
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+    BlockCache(BlockCache&& other) noexcept;
+    BlockCache& operator=(BlockCache&& other) noexcept;
+    ~BlockCache();
+
+    size_t size() const { return file_size; }
+
+    // copies [start, end) into out; throws if the range is past the end of the file
+    void read(size_t start, size_t end, uint8_t* out) const;
+    uint8_t at(size_t offset) const;
+
+    struct Block {
+        size_t index;
+        std::vector<uint8_t> data;
+    };
+
+    const Block& block(size_t index) const;
+
+    int fd = -1;
+    size_t file_size = 0;
+    size_t block_size = DEFAULT_BLOCK_SIZE;
+    size_t max_blocks = 1;
+
+    // front is most recently used
+    mutable std::list<Block> lru;
+    mutable std::unordered_map<size_t, std::list<Block>::iterator> blocks;
+    mutable uint64_t hits = 0;
+    mutable uint64_t misses = 0;
+};
+
+
+inline std::vector<uint8_t> byte_range(const BlockCache& cache, size_t start, size_t end) {
+    std::vector<uint8_t> result(end - start);
+    cache.read(start, end, result.data());
+    return result;
+}
+
+inline ByteView view_range(const BlockCache& cache, size_t start, size_t end, std::vector<uint8_t>& scratch) {
+    scratch.resize(end - start);
+    cache.read(start, end, scratch.data());
+    return ByteView(scratch);
+}
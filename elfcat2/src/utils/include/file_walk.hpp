@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+// Paths of the regular files under root, recursively and in sorted order.
+// Symbolic links are not followed, so a tree is never walked twice; a root that
+// is itself a regular file is returned as is. Throws when root can't be read,
+// unreadable directories further down are skipped.
+std::vector<std::string> list_regular_files(const std::string& root);
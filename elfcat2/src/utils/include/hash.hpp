@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "utils.hpp"
+
+
+// XXH64, bit-compatible with the reference implementation
+uint64_t xxhash64(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t xxhash64(const ByteView& bytes, uint64_t seed = 0) {
+    return xxhash64(bytes.data(), bytes.size(), seed);
+}
+
+// XXH64 fed in pieces: the digest of the concatenation, as xxhash64 would give it
+struct Xxh64 {
+    explicit Xxh64(uint64_t seed = 0);
+    void update(const uint8_t* data, size_t size);
+    uint64_t digest() const;
+
+    uint64_t seed;
+    std::array<uint64_t, 4> lanes;
+    // the part of a 32-byte stripe not consumed yet
+    std::array<uint8_t, 32> buffer = {};
+    size_t buffered = 0;
+    uint64_t length = 0;
+};
+
+// SHA-256 (FIPS 180-4) fed in pieces. Blocks are compressed with the SHA
+// extensions on x86-64 CPUs that have them, several times faster than the
+// portable code
+struct Sha256 {
+    void update(const uint8_t* data, size_t size);
+    std::array<uint8_t, 32> finish();
+
+    std::array<uint32_t, 8> state = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    std::array<uint8_t, 64> buffer = {};
+    size_t buffered = 0;
+    uint64_t length = 0;
+};
+
+std::array<uint8_t, 32> sha256(const uint8_t* data, size_t size);
+
+inline std::array<uint8_t, 32> sha256(const ByteView& bytes) {
+    return sha256(bytes.data(), bytes.size());
+}
+
+// CRC-32 as in zlib and .gnu_debuglink; pass the previous result to continue a checksum
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+inline uint32_t crc32(const ByteView& bytes, uint32_t crc = 0) {
+    return crc32(bytes.data(), bytes.size(), crc);
+}
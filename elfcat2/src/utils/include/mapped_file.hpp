@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+#include "utils.hpp"
+
+
+// Read-only mmap of a whole file. Pages are only faulted in when touched, so
+// parsing headers of a huge file does not read its contents.
+struct MappedFile {
+    static MappedFile open(const std::string& path);
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    ByteView view() const;
+
+    void* address = nullptr;
+    size_t size = 0;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// jobs == 0 means one per hardware thread
+size_t resolve_jobs(size_t jobs);
+
+// Calls body(i) for every i in [0, count) on up to jobs threads, handing out
+// indices one at a time so that a few large items don't stall the rest. The
+// first exception thrown by body is rethrown once all threads have stopped.
+void parallel_for(size_t count, size_t jobs, const std::function<void(size_t)>& body);
+
+
+// Long-lived threads running tasks in the order they're submitted, for work that
+// trickles in instead of arriving as one batch. Tasks must not throw. The
+// destructor finishes the queued tasks before joining.
+struct WorkerPool {
+    explicit WorkerPool(size_t jobs = 0);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool();
+
+    void submit(std::function<void()> task);
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> queue;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+#include "utils.hpp"
+
+
+// Rendered reports kept across runs under a directory, one file per key. Keys
+// are the XXH64 and size of the input together with a hash of whatever else
+// changes the output (elfcat version, options, the name shown in the report),
+// so a hit can be written out without parsing or rendering anything. Once the
+// entries add up to more than budget bytes the least recently used ones are
+// deleted; the modification time of an entry is its last use. Several elfcat
+// processes may share a directory: entries are written to a temporary file and
+// renamed into place.
+struct ReportCache {
+    static constexpr uint64_t DEFAULT_BUDGET = 1024 * 1024 * 1024;
+
+    // creates the directory if needed, throws when it can't be
+    static ReportCache open(const std::string& path, uint64_t budget = DEFAULT_BUDGET);
+
+    static std::string key(const ByteView& contents, const std::string& parameters);
+
+    // marks the entry as used
+    std::optional<std::string> get(const std::string& key) const;
+    // failures are ignored, the cache is only an optimization; reports larger than
+    // the whole budget aren't stored
+    void put(const std::string& key, const std::string& report) const;
+    // same for a report already written out to filename, which is copied without
+    // holding it in memory
+    void put_file(const std::string& key, const std::string& filename) const;
+
+    // writes an entry through a temporary file renamed into place
+    void store(const std::string& key, const std::function<void(std::ostream&)>& write) const;
+
+    std::string path;
+    uint64_t budget = DEFAULT_BUDGET;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+// Bytes of [start, end) that are backed by data rather than holes, found with
+// SEEK_DATA/SEEK_HOLE without reading anything. Filesystems that don't track
+// holes report the whole range as data.
+uint64_t data_bytes_in(int fd, uint64_t start, uint64_t end);
+
+
+// Keeps a descriptor open for a series of data_bytes_in queries on one file.
+struct SparseProbe {
+    static SparseProbe open(const std::string& path);
+
+    SparseProbe() = default;
+    SparseProbe(const SparseProbe&) = delete;
+    SparseProbe& operator=(const SparseProbe&) = delete;
+    SparseProbe(SparseProbe&& other) noexcept;
+    SparseProbe& operator=(SparseProbe&& other) noexcept;
+    ~SparseProbe();
+
+    uint64_t data_bytes(uint64_t start, uint64_t end) const {
+        return data_bytes_in(fd, start, end);
+    }
+
+    int fd = -1;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// Per-phase instrumentation behind --stats. Everything below the #else compiles
+// to nothing when the build is configured with -DELFCAT_STATS=OFF.
+#ifdef ELFCAT_STATS
+
+#include <chrono>
+
+struct PhaseStats {
+    std::string name;
+    uint32_t depth;
+    uint64_t calls;
+    uint64_t nanoseconds;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t bytes_emitted;
+};
+
+
+struct Stats {
+    static Stats& instance();
+
+    PhaseStats& phase(const char* name);
+    void print_table(std::ostream& os) const;
+    void print_json(std::ostream& os) const;
+
+    std::vector<PhaseStats> phases;
+    uint32_t depth = 0;
+};
+
+
+// phases nest: times, allocation counts and emitted bytes are inclusive of inner phases.
+// Only phases on the main thread are recorded; work handed to other threads counts
+// towards the main thread phase that waits for it.
+struct ScopedPhase {
+    static constexpr size_t NOT_RECORDED = SIZE_MAX;
+
+    ScopedPhase(const char* name);
+    ~ScopedPhase();
+
+    void emitted(uint64_t bytes);
+
+    size_t index;
+    std::chrono::steady_clock::time_point start;
+    uint64_t allocations_at_start;
+    uint64_t allocated_bytes_at_start;
+};
+
+
+// allocations are only counted in executables that link the alloc_hooks library,
+// which replaces global operator new. libelfcat itself never does.
+void count_allocation(size_t size);
+uint64_t allocation_count();
+uint64_t allocated_bytes();
+
+#define STATS_ENABLED 1
+#define STATS_PHASE(var, name) ScopedPhase var(name)
+#define STATS_EMITTED(var, bytes) var.emitted(static_cast<uint64_t>(bytes))
+
+#else
+
+#define STATS_ENABLED 0
+#define STATS_PHASE(var, name)
+#define STATS_EMITTED(var, bytes)
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <optional>
 #include <sstream>
@@ -10,10 +11,42 @@
 #include <vector>
 
 
+// Non-owning view of a byte buffer: a mapped file, a vector or a slice of either.
+// Whoever hands one out keeps the underlying storage alive.
+struct ByteView {
+    ByteView() = default;
+    ByteView(const uint8_t* data, size_t size) : ptr(data), len(size) {}
+    ByteView(const std::vector<uint8_t>& bytes) : ptr(bytes.data()), len(bytes.size()) {}
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    const uint8_t* begin() const { return ptr; }
+    const uint8_t* end() const { return ptr + len; }
+    const uint8_t* cbegin() const { return ptr; }
+    const uint8_t* cend() const { return ptr + len; }
+    uint8_t operator[](size_t idx) const { return ptr[idx]; }
+
+    ByteView subview(size_t start, size_t end) const {
+        return ByteView(ptr + start, end - start);
+    }
+
+    const uint8_t* ptr = nullptr;
+    size_t len = 0;
+};
+
+
 std::string human_format_bytes(uint64_t bytes);
+// "64M", "512k", "1G" or plain bytes
+std::optional<uint64_t> parse_byte_size(const std::string& text);
 std::optional<std::string> html_escape(char ch);
+// text from the file (names, paths, strings) as it's safe to put in markup
+std::string html_escape(const std::string& text);
 std::string repeat(const std::string& input, size_t num);
 std::string include_str(const std::string& path, const std::string& indent);
+// mkdir -p: path and whatever is missing above it. failures are left for whoever uses
+// the directory to notice
+void make_directories(const std::string& path);
 
 template<class t>
 std::string int_to_hex(t value) {
@@ -27,6 +60,16 @@ auto byte_range(const std::vector<t>& bytes, size_t start, size_t end) {
     return std::vector<t>(bytes.cbegin() + start, bytes.cbegin() + end);
 }
 
+inline std::vector<uint8_t> byte_range(const ByteView& bytes, size_t start, size_t end) {
+    return std::vector<uint8_t>(bytes.cbegin() + start, bytes.cbegin() + end);
+}
+
+// like byte_range, but without a copy when the bytes are already in memory; scratch
+// holds them otherwise (see the BlockCache overload)
+inline ByteView view_range(const ByteView& bytes, size_t start, size_t end, std::vector<uint8_t>&) {
+    return bytes.subview(start, end);
+}
+
 template<class t, class = typename std::enable_if_t<std::is_integral_v<t>>>
 t from_le_bytes(const std::vector<uint8_t>& bytes) {
     return *reinterpret_cast<std::decay_t<t>*>(const_cast<uint8_t*>(bytes.data()));
@@ -37,6 +80,22 @@ t from_be_bytes(const std::vector<uint8_t>& bytes) {
     return *reinterpret_cast<std::decay_t<t>*>(std::vector<uint8_t>(bytes.crbegin(), bytes.crend()).data());
 }
 
+// reads a t stored at p in the given byte order. the order is a template parameter so
+// that loops over tables are compiled once per order instead of testing it per field
+template<class t, bool big_endian, class = typename std::enable_if_t<std::is_integral_v<t>>>
+t load_bytes(const uint8_t* p) {
+    std::make_unsigned_t<std::decay_t<t>> value;
+    std::memcpy(&value, p, sizeof(value));
+    if constexpr (big_endian && sizeof(value) == 2) {
+        value = __builtin_bswap16(value);
+    } else if constexpr (big_endian && sizeof(value) == 4) {
+        value = __builtin_bswap32(value);
+    } else if constexpr (big_endian && sizeof(value) == 8) {
+        value = __builtin_bswap64(value);
+    }
+    return static_cast<t>(value);
+}
+
 template<size_t size>
 auto to_array(const std::vector<uint8_t>& buffer) {
     std::array<uint8_t, size> array;
@@ -59,6 +118,11 @@ struct ser_integral_t {
         return ser_integral_t(::from_be_bytes<type>(bytes));
     }
 
+    template<bool big_endian>
+    static ser_integral_t read(const uint8_t* p) {
+        return ser_integral_t(load_bytes<type, big_endian>(p));
+    }
+
     operator type() const {
         return value;
     }
@@ -0,0 +1,65 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "include/mapped_file.hpp"
+
+
+MappedFile MappedFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("can't open '" + path + "': " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("'" + path + "' is not a regular file");
+    }
+
+    MappedFile file;
+    file.size = static_cast<size_t>(st.st_size);
+
+    if (file.size != 0) {
+        void* address = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("can't map '" + path + "': " + std::strerror(errno));
+        }
+        file.address = address;
+    }
+
+    ::close(fd);
+    return file;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : address(std::exchange(other.address, nullptr))
+    , size(std::exchange(other.size, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        if (address != nullptr) {
+            munmap(address, size);
+        }
+        address = std::exchange(other.address, nullptr);
+        size = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    if (address != nullptr) {
+        munmap(address, size);
+    }
+}
+
+ByteView MappedFile::view() const {
+    return ByteView(static_cast<const uint8_t*>(address), size);
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "include/parallel.hpp"
+
+
+size_t resolve_jobs(size_t jobs) {
+    if (jobs != 0) {
+        return jobs;
+    }
+    auto hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : hardware;
+}
+
+void parallel_for(size_t count, size_t jobs, const std::function<void(size_t)>& body) {
+    jobs = std::min(resolve_jobs(jobs), count);
+
+    if (jobs <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                // let the other threads run out of work
+                next = count;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(jobs - 1);
+    for (size_t i = 1; i < jobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+WorkerPool::WorkerPool(size_t jobs) {
+    jobs = resolve_jobs(jobs);
+    threads.reserve(jobs);
+
+    for (size_t i = 0; i < jobs; ++i) {
+        threads.emplace_back([this] {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock(mutex);
+                    wake.wait(lock, [this] { return stopping || !queue.empty(); });
+                    if (queue.empty()) {
+                        return;
+                    }
+                    task = std::move(queue.front());
+                    queue.pop_front();
+                }
+                task();
+            }
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex);
+        queue.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
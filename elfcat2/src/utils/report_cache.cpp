@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "include/hash.hpp"
+#include "include/report_cache.hpp"
+
+
+namespace {
+
+constexpr char ENTRY_SUFFIX[] = ".report";
+
+
+std::string entry_path(const std::string& directory, const std::string& key) {
+    return directory + "/" + key + ENTRY_SUFFIX;
+}
+
+bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// oldest first, until what is left fits
+void evict(const std::string& directory, uint64_t budget) {
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+
+    // last use, size, path
+    std::vector<std::tuple<timespec, uint64_t, std::string>> entries;
+    uint64_t total = 0;
+
+    while (auto* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (!ends_with(name, ENTRY_SUFFIX)) {
+            continue;
+        }
+        auto path = directory + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        entries.emplace_back(st.st_mtim, st.st_size, path);
+        total += st.st_size;
+    }
+
+    closedir(dir);
+
+    if (total <= budget) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        const auto& [a_sec, a_nsec] = std::get<0>(a);
+        const auto& [b_sec, b_nsec] = std::get<0>(b);
+        return std::tie(a_sec, a_nsec) < std::tie(b_sec, b_nsec);
+    });
+
+    for (const auto& [used, size, path] : entries) {
+        if (total <= budget) {
+            break;
+        }
+        // another process may have evicted it already
+        unlink(path.c_str());
+        total -= size;
+    }
+}
+
+}
+
+
+ReportCache ReportCache::open(const std::string& path, uint64_t budget) {
+    make_directories(path);
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || access(path.c_str(), W_OK) != 0) {
+        throw std::runtime_error("can't use '" + path + "' as a cache directory");
+    }
+
+    return ReportCache{path, budget};
+}
+
+std::string ReportCache::key(const ByteView& contents, const std::string& parameters) {
+    char key[3 * 16 + 3];
+    std::snprintf(key, sizeof(key), "%016llx-%016llx-%016llx",
+        static_cast<unsigned long long>(xxhash64(contents)),
+        static_cast<unsigned long long>(contents.size()),
+        static_cast<unsigned long long>(xxhash64(reinterpret_cast<const uint8_t*>(parameters.data()), parameters.size())));
+    return key;
+}
+
+std::optional<std::string> ReportCache::get(const std::string& key) const {
+    auto path = entry_path(this->path, key);
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return std::nullopt;
+    }
+
+    std::stringstream contents;
+    contents << input.rdbuf();
+    if (!input) {
+        return std::nullopt;
+    }
+
+    // now as the last use, for eviction
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+
+    return contents.str();
+}
+
+void ReportCache::put(const std::string& key, const std::string& report) const {
+    // it would only push everything else out and then itself
+    if (report.size() > budget) {
+        return;
+    }
+
+    store(key, [&](std::ostream& output) { output << report; });
+}
+
+void ReportCache::put_file(const std::string& key, const std::string& filename) const {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0 || static_cast<uint64_t>(st.st_size) > budget) {
+        return;
+    }
+
+    std::ifstream input(filename, std::ios::binary);
+    if (!input) {
+        return;
+    }
+
+    store(key, [&](std::ostream& output) { output << input.rdbuf(); });
+}
+
+void ReportCache::store(const std::string& key, const std::function<void(std::ostream&)>& write) const {
+    auto path = entry_path(this->path, key);
+    // unique per process, so concurrent writers of one key don't mix their output
+    auto temporary = this->path + "/" + key + "." + std::to_string(getpid()) + ".tmp";
+
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        write(output);
+        if (!output) {
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return;
+    }
+
+    evict(this->path, budget);
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "include/sparse.hpp"
+
+
+uint64_t data_bytes_in(int fd, uint64_t start, uint64_t end) {
+    if (start >= end) {
+        return 0;
+    }
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    uint64_t total = 0;
+    uint64_t pos = start;
+
+    while (pos < end) {
+        off_t data = lseek(fd, static_cast<off_t>(pos), SEEK_DATA);
+        if (data < 0) {
+            // ENXIO: nothing but a hole up to the end of the file
+            if (errno == ENXIO) {
+                return total;
+            }
+            return end - start;
+        }
+        if (static_cast<uint64_t>(data) >= end) {
+            break;
+        }
+
+        off_t hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) {
+            return end - start;
+        }
+
+        total += std::min<uint64_t>(static_cast<uint64_t>(hole), end) - static_cast<uint64_t>(data);
+        pos = static_cast<uint64_t>(hole);
+    }
+
+    return total;
+#else
+    (void)fd;
+    return end - start;
+#endif
+}
+
+SparseProbe SparseProbe::open(const std::string& path) {
+    SparseProbe probe;
+    probe.fd = ::open(path.c_str(), O_RDONLY);
+    if (probe.fd < 0) {
+        throw std::runtime_error("can't open '" + path + "': " + std::strerror(errno));
+    }
+    return probe;
+}
+
+SparseProbe::SparseProbe(SparseProbe&& other) noexcept
+    : fd(std::exchange(other.fd, -1)) {}
+
+SparseProbe& SparseProbe::operator=(SparseProbe&& other) noexcept {
+    if (this != &other) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = std::exchange(other.fd, -1);
+    }
+    return *this;
+}
+
+SparseProbe::~SparseProbe() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
@@ -0,0 +1,120 @@
+#include "include/stats.hpp"
+
+#ifdef ELFCAT_STATS
+
+#include <atomic>
+#include <iomanip>
+#include <thread>
+
+
+static std::atomic<uint64_t> g_allocations{0};
+static std::atomic<uint64_t> g_allocated_bytes{0};
+// statics are initialized before main runs, on the main thread
+static const std::thread::id g_main_thread = std::this_thread::get_id();
+
+uint64_t allocation_count() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t allocated_bytes() {
+    return g_allocated_bytes.load(std::memory_order_relaxed);
+}
+
+void count_allocation(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+Stats& Stats::instance() {
+    static Stats stats;
+    return stats;
+}
+
+PhaseStats& Stats::phase(const char* name) {
+    for (auto& phase : phases) {
+        if (phase.name == name && phase.depth == depth) {
+            return phase;
+        }
+    }
+
+    phases.push_back(PhaseStats{name, depth, 0, 0, 0, 0, 0});
+    return phases.back();
+}
+
+void Stats::print_table(std::ostream& os) const {
+    os << std::left << std::setw(24) << "phase"
+        << std::right << std::setw(8) << "calls"
+        << std::setw(12) << "ms"
+        << std::setw(12) << "allocs"
+        << std::setw(16) << "alloc bytes"
+        << std::setw(16) << "emitted bytes" << std::endl;
+
+    for (const auto& phase : phases) {
+        os << std::left << std::setw(24) << (std::string(2 * phase.depth, ' ') + phase.name)
+            << std::right << std::setw(8) << phase.calls
+            << std::setw(12) << std::fixed << std::setprecision(3) << phase.nanoseconds / 1e6
+            << std::setw(12) << phase.allocations
+            << std::setw(16) << phase.allocated_bytes
+            << std::setw(16) << phase.bytes_emitted << std::endl;
+    }
+}
+
+void Stats::print_json(std::ostream& os) const {
+    os << "{\"phases\": [";
+
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const auto& phase = phases[i];
+
+        os << (i == 0 ? "" : ", ")
+            << "{\"name\": \"" << phase.name << "\""
+            << ", \"depth\": " << phase.depth
+            << ", \"calls\": " << phase.calls
+            << ", \"ns\": " << phase.nanoseconds
+            << ", \"allocations\": " << phase.allocations
+            << ", \"allocated_bytes\": " << phase.allocated_bytes
+            << ", \"bytes_emitted\": " << phase.bytes_emitted << "}";
+    }
+
+    os << "]}" << std::endl;
+}
+
+ScopedPhase::ScopedPhase(const char* name)
+    : allocations_at_start(allocation_count())
+    , allocated_bytes_at_start(allocated_bytes()) {
+    if (std::this_thread::get_id() != g_main_thread) {
+        index = NOT_RECORDED;
+        return;
+    }
+
+    auto& stats = Stats::instance();
+    auto& phase = stats.phase(name);
+
+    index = static_cast<size_t>(&phase - stats.phases.data());
+    ++stats.depth;
+    start = std::chrono::steady_clock::now();
+}
+
+ScopedPhase::~ScopedPhase() {
+    if (index == NOT_RECORDED) {
+        return;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto& stats = Stats::instance();
+    auto& phase = stats.phases[index];
+
+    --stats.depth;
+    phase.calls += 1;
+    phase.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    phase.allocations += allocation_count() - allocations_at_start;
+    phase.allocated_bytes += allocated_bytes() - allocated_bytes_at_start;
+}
+
+void ScopedPhase::emitted(uint64_t bytes) {
+    if (index == NOT_RECORDED) {
+        return;
+    }
+    Stats::instance().phases[index].bytes_emitted += bytes;
+}
+
+#endif
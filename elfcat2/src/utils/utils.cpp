@@ -1,10 +1,14 @@
+#include <charconv>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iterator>
 #include <sstream>
 #include <string>
 
+#include <sys/stat.h>
+
 #include "include/utils.hpp"
 
 
@@ -22,6 +26,36 @@ std::string human_format_bytes(uint64_t bytes) {
     return formatting.str();
 }
 
+std::optional<uint64_t> parse_byte_size(const std::string& text) {
+    // digits only: from_chars takes no sign or leading whitespace, unlike stoull
+    uint64_t value = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc()) {
+        return std::nullopt;
+    }
+
+    size_t idx = end - text.data();
+    if (idx == text.size()) {
+        return value;
+    }
+    if (idx + 1 != text.size()) {
+        return std::nullopt;
+    }
+
+    unsigned shift;
+    switch (text[idx]) {
+        case 'k': case 'K': shift = 10; break;
+        case 'm': case 'M': shift = 20; break;
+        case 'g': case 'G': shift = 30; break;
+        default: return std::nullopt;
+    }
+
+    if (value > (UINT64_MAX >> shift)) {
+        return std::nullopt;
+    }
+    return value << shift;
+}
+
 std::optional<std::string> html_escape(char ch) {
     switch (ch) {
         case '&': return "&amp;";
@@ -32,6 +66,22 @@ std::optional<std::string> html_escape(char ch) {
     }
 }
 
+std::string html_escape(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char ch : text) {
+        if (auto escaped = html_escape(ch)) {
+            result += *escaped;
+        } else if (ch == '\'') {
+            // the reports quote attributes with '
+            result += "&#39;";
+        } else {
+            result += ch;
+        }
+    }
+    return result;
+}
+
 std::string repeat(const std::string& input, size_t num) {
     std::ostringstream os;
     std::fill_n(std::ostream_iterator<std::string>(os), num, input);
@@ -47,3 +97,15 @@ std::string include_str(const std::string& path, const std::string& indent) {
     }
     return ss.str();
 }
+
+void make_directories(const std::string& path) {
+    if (path.empty()) {
+        return;
+    }
+    for (auto next = path.find('/', 1); ; next = path.find('/', next + 1)) {
+        mkdir(path.substr(0, next).c_str(), 0755);
+        if (next == std::string::npos) {
+            break;
+        }
+    }
+}
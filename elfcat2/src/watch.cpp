@@ -0,0 +1,302 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <archive.hpp>
+#include <defs.hpp>
+#include <hash.hpp>
+#include <parallel.hpp>
+
+#include "watch.hpp"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// close_write covers files written in place, moved_to the ones written elsewhere and renamed;
+// delete and moved_from drop what's known about files that are gone
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM;
+
+
+struct Watcher {
+    // registers directory and everything below it, and queues the files already there
+    void add_tree(const std::string& directory, Clock::time_point due) {
+        int wd = inotify_add_watch(fd, directory.c_str(), WATCH_MASK | IN_ONLYDIR);
+        if (wd < 0) {
+            return;
+        }
+        directories[wd] = directory;
+
+        DIR* dir = opendir(directory.c_str());
+        if (dir == nullptr) {
+            return;
+        }
+
+        while (auto* entry = readdir(dir)) {
+            if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            auto path = directory + "/" + entry->d_name;
+            if (entry->d_type == DT_DIR) {
+                add_tree(path, due);
+            } else if (entry->d_type == DT_REG || entry->d_type == DT_UNKNOWN) {
+                pending[path] = due;
+            }
+        }
+
+        closedir(dir);
+    }
+
+    // path is gone: its pending render is dropped, and for a directory those of
+    // everything below it and the watches on its subdirectories too
+    void forget(const std::string& path, bool is_directory) {
+        pending.erase(path);
+        if (!is_directory) {
+            return;
+        }
+
+        auto prefix = path + "/";
+        for (auto it = pending.lower_bound(prefix); it != pending.end() && it->first.compare(0, prefix.size(), prefix) == 0;) {
+            it = pending.erase(it);
+        }
+        // a moved directory keeps its watches, which would report under the old path
+        for (auto it = directories.begin(); it != directories.end();) {
+            if (it->second == path || it->second.compare(0, prefix.size(), prefix) == 0) {
+                inotify_rm_watch(fd, it->first);
+                it = directories.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    int fd = -1;
+    std::unordered_map<int, std::string> directories;
+    // path -> when it's quiet enough to render
+    std::map<std::string, Clock::time_point> pending;
+};
+
+
+// state the watch loop shares with the workers
+struct Renders {
+    std::mutex mutex;
+    std::set<std::string> running;
+    // path -> (size, xxhash64) of the contents last rendered
+    std::unordered_map<std::string, std::tuple<size_t, uint64_t>> rendered;
+
+    void forget(const std::string& path, bool is_directory) {
+        std::lock_guard lock(mutex);
+        rendered.erase(path);
+        if (!is_directory) {
+            return;
+        }
+
+        auto prefix = path + "/";
+        for (auto it = rendered.begin(); it != rendered.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                it = rendered.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+
+bool is_renderable(const ByteView& view) {
+    return (view.size() >= static_cast<size_t>(ELF_EI_NIDENT) && std::memcmp(view.data(), "\x7f" "ELF", 4) == 0)
+        || Archive::is_archive(view);
+}
+
+// the whole file, read rather than mapped: a mapping faults with SIGBUS once the file is
+// truncated under it, and files here are rewritten whenever their writer likes. nullopt
+// when it's gone, isn't a regular file or changed size while being read; the write
+// that changed it queues it again
+std::optional<std::vector<uint8_t>> read_contents(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    std::optional<std::vector<uint8_t>> contents;
+    struct stat before;
+    if (fstat(fd, &before) == 0 && S_ISREG(before.st_mode)) {
+        std::vector<uint8_t> buffer(static_cast<size_t>(before.st_size));
+        size_t done = 0;
+        while (done < buffer.size()) {
+            auto got = pread(fd, buffer.data() + done, buffer.size() - done, static_cast<off_t>(done));
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                break;
+            }
+            done += static_cast<size_t>(got);
+        }
+
+        struct stat after;
+        if (done == buffer.size() && fstat(fd, &after) == 0 && after.st_size == before.st_size) {
+            contents = std::move(buffer);
+        }
+    }
+
+    close(fd);
+    return contents;
+}
+
+void render_file(const std::string& path, Renders& renders,
+        const std::function<void(const std::string&, const ByteView&)>& render) {
+    auto contents = read_contents(path);
+
+    if (contents && is_renderable(*contents)) {
+        ByteView view(*contents);
+        auto stamp = std::make_tuple(view.size(), xxhash64(view));
+
+        bool unchanged;
+        {
+            std::lock_guard lock(renders.mutex);
+            auto found = renders.rendered.find(path);
+            unchanged = found != renders.rendered.end() && found->second == stamp;
+        }
+
+        if (!unchanged) {
+            try {
+                render(path, view);
+                std::lock_guard lock(renders.mutex);
+                renders.rendered[path] = stamp;
+                std::cout << "Rendered " << path << std::endl;
+            } catch (const std::runtime_error& e) {
+                std::lock_guard lock(renders.mutex);
+                std::cout << "Error: " << path << ": " << e.what() << std::endl;
+            }
+        }
+    }
+
+    std::lock_guard lock(renders.mutex);
+    renders.running.erase(path);
+}
+
+}
+
+
+int watch_directory(const std::string& directory, size_t jobs,
+        const std::function<void(const std::string&, const ByteView&)>& render) {
+    Watcher watcher;
+    watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher.fd < 0) {
+        std::cout << "Error: inotify: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+
+    auto root = directory.size() > 1 && directory.back() == '/' ? directory.substr(0, directory.size() - 1) : directory;
+    watcher.add_tree(root, Clock::now());
+    if (watcher.directories.empty()) {
+        std::cout << "Error: can't watch '" << directory << "': " << std::strerror(errno) << std::endl;
+        close(watcher.fd);
+        return -1;
+    }
+
+    std::cout << "Watching " << watcher.directories.size() << " directories under " << root << std::endl;
+
+    Renders renders;
+    WorkerPool pool(jobs);
+
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    while (true) {
+        auto now = Clock::now();
+
+        for (auto it = watcher.pending.begin(); it != watcher.pending.end();) {
+            if (it->second > now) {
+                ++it;
+                continue;
+            }
+            {
+                std::lock_guard lock(renders.mutex);
+                // written again while being rendered: wait for that render, then look again
+                if (!renders.running.insert(it->first).second) {
+                    it->second = now + WATCH_QUIET_PERIOD;
+                    ++it;
+                    continue;
+                }
+            }
+            pool.submit([&renders, &render, path = it->first] {
+                render_file(path, renders, render);
+            });
+            it = watcher.pending.erase(it);
+        }
+
+        int timeout = -1;
+        if (!watcher.pending.empty()) {
+            auto next = watcher.pending.begin()->second;
+            for (const auto& [path, due] : watcher.pending) {
+                next = std::min(next, due);
+            }
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+            timeout = static_cast<int>(std::max<int64_t>(wait, 1));
+        }
+
+        pollfd ready = {watcher.fd, POLLIN, 0};
+        if (poll(&ready, 1, timeout) < 0 && errno != EINTR) {
+            std::cout << "Error: poll: " << std::strerror(errno) << std::endl;
+            close(watcher.fd);
+            return -1;
+        }
+
+        while (true) {
+            auto size = read(watcher.fd, buffer, sizeof(buffer));
+            if (size <= 0) {
+                break;
+            }
+
+            now = Clock::now();
+
+            for (char* p = buffer; p < buffer + size;) {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // events were dropped, look at everything again; the hashes skip what didn't change
+                    watcher.add_tree(root, now);
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    watcher.directories.erase(event->wd);
+                    continue;
+                }
+
+                auto found = watcher.directories.find(event->wd);
+                if (found == watcher.directories.end() || event->len == 0) {
+                    continue;
+                }
+                auto path = found->second + "/" + event->name;
+
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    bool is_directory = event->mask & IN_ISDIR;
+                    watcher.forget(path, is_directory);
+                    renders.forget(path, is_directory);
+                } else if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        watcher.add_tree(path, now + WATCH_QUIET_PERIOD);
+                    }
+                } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    watcher.pending[path] = now + WATCH_QUIET_PERIOD;
+                }
+            }
+        }
+    }
+}
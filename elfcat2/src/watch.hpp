@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <utils.hpp>
+
+
+// how long a file must stay untouched before it's rendered; linkers rewrite their
+// output several times in quick succession
+constexpr std::chrono::milliseconds WATCH_QUIET_PERIOD{250};
+
+
+// Renders every ELF file and ar archive under directory, then watches the tree
+// with inotify and renders files again once they've been written and have stayed
+// quiet for WATCH_QUIET_PERIOD. render runs on a pool of jobs threads, never twice
+// at the same time for one file, and is skipped when the contents hash the same as
+// when they were last rendered; files are read into memory first, so one truncated
+// meanwhile can't fault the process. Files deleted or moved away are forgotten, and
+// render again when they come back. Only returns if watching fails.
+int watch_directory(const std::string& directory, size_t jobs,
+        const std::function<void(const std::string&, const ByteView&)>& render);